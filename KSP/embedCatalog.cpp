@@ -0,0 +1,192 @@
+/*
+
+    embedCatalog                        Builds the component catalog into the game
+
+    Loads every component of a components text file with the game's own model
+    reader and writes the catalog, with every mesh already optimized, as a C++
+    header (embeddedCatalog.h) that the game is compiled with. It runs before
+    every build of the game (see KSP.cbp):
+
+        embedCatalog Components.txt embeddedCatalog.h
+
+    The header it writes also defines the structs its arrays are made of, so
+    the layout of the records always matches the initializers written here.
+
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "modelReader.h"
+
+using namespace std;
+
+// The structs of the built-in catalog, written at the top of the generated header
+const char *embeddedStructs = R"(// This struct is one component of the built-in catalog: its catalog entry, and where its objects are in embeddedObjects
+struct EmbeddedComponent
+{
+    const char *fileName;
+
+    double mass;
+    double thrust;
+    double lift;
+    double drag;
+
+    double maxX, minX;
+    double maxY, minY;
+    double maxZ, minZ;
+
+    // The counts scanObject found in the model file (triangles after triangulation)
+    int vertexCount;
+    int triangleCount;
+    int polygonCount;
+
+    int firstObject;
+    int objectCount;
+};
+
+// This struct is one object of a built-in component, already optimized by loadObject: its vertices (three values each) in embeddedVertices, and its triangle and edge indices as delta-encoded streams in embeddedIndices (first is the byte the stream starts at, count the number of indices)
+struct EmbeddedObject
+{
+    int firstVertex;
+    int vertexCount;
+
+    int firstTriangle;
+    int triangleCount;
+
+    int firstEdge;
+    int edgeCount;
+};
+)";
+
+// This void method writes the values one after another as C++ array elements, a few to a line, followed by a last record of zeros of the given width (so that the array is never empty)
+template <typename T>
+void writeEmbeddedArray (ostream &out, const vector<T> &values, int width) {
+
+    for (int i=0; i<values.size(); i++) {
+        // (the unary plus writes bytes as numbers rather than characters)
+        out << (i % 8 == 0 ? "    " : " ") << +values[i] << (i % 8 == 7 ? ",\n" : ",");
+    }
+
+    if (values.size() % 8 != 0) {
+        out << "\n";
+    }
+
+    out << "    0";
+
+    for (int i=1; i<width; i++) {
+        out << ", 0";
+    }
+
+    out << "\n";
+
+}
+
+// This method generates the built-in catalog: it loads every component of the given components text file (exactly as the game would) and writes the structs of the catalog, the catalog itself and the optimized meshes as C++ arrays to outputName. Returns false if a file cannot be read or written (outputName is then left as it was)
+bool writeEmbeddedCatalog (string manifestName, string outputName) {
+
+    if (!ifstream(manifestName.c_str())) {
+        cout << "Could not read " << manifestName << endl;
+        return false;
+    }
+
+    vector<ComponentEntry> entries = parseComponents(manifestName);
+
+    ostringstream components;
+    ostringstream objects;
+
+    vector<double> vertices;
+    vector<unsigned char> indices;
+
+    int objectTotal = 0;
+
+    // Every number is written exactly, so the meshes match what loadObject returns
+    components.precision(17);
+
+    for (const ComponentEntry &entry : entries) {
+
+        CatalogInfo info;
+
+        if (!scanObject(entry.fileName, info)) {
+            cout << "Could not read " << entry.fileName << endl;
+            return false;
+        }
+
+        vector<Object> mesh = loadObject(entry.fileName);
+
+        components << "    {\"" << getBaseName(entry.fileName) << "\", " << entry.mass << ", " << entry.thrust << ", " << entry.lift << ", " << entry.drag << ", ";
+        components << info.maxX << ", " << info.minX << ", " << info.maxY << ", " << info.minY << ", " << info.maxZ << ", " << info.minZ << ", ";
+        components << info.vertexCount << ", " << info.triangleCount << ", " << info.polygonCount << ", " << objectTotal << ", " << mesh.size() << "},\n";
+
+        for (const Object &obj : mesh) {
+
+            objects << "    {" << vertices.size() / 3 << ", " << obj.vertices.size() << ", ";
+
+            for (const Point3D &p : obj.vertices) {
+                vertices.push_back(p.x);
+                vertices.push_back(p.y);
+                vertices.push_back(p.z);
+            }
+
+            objects << indices.size() << ", " << obj.triangles.size() << ", ";
+            encodeIndices(obj.triangles, indices);
+
+            objects << indices.size() << ", " << obj.edges.size() << "},\n";
+            encodeIndices(obj.edges, indices);
+
+            objectTotal++;
+
+        }
+
+    }
+
+    ofstream out(outputName.c_str());
+
+    out << "/*\n\n";
+    out << "    The built-in component catalog (" << entries.size() << " components), generated from " << getBaseName(manifestName) << " by\n\n";
+    out << "        embedCatalog " << getBaseName(manifestName) << " " << getBaseName(outputName) << "\n\n";
+    out << "    Do not edit it by hand: the command runs before every build of the game. The meshes are stored already welded, triangulated and ordered for the vertex cache, exactly as loadObject returns them (with the triangle and edge indices delta-encoded). Every array ends with a record of zeros so that an empty catalog still compiles.\n\n";
+    out << "*/\n\n";
+
+    out << "#ifndef KSP_EMBEDDED_CATALOG_H\n";
+    out << "#define KSP_EMBEDDED_CATALOG_H\n\n";
+
+    out << embeddedStructs << "\n";
+
+    out << "const int embeddedComponentCount = " << entries.size() << ";\n\n";
+
+    out << "const EmbeddedComponent embeddedComponents[] = {\n" << components.str() << "    {}\n};\n\n";
+    out << "const EmbeddedObject embeddedObjects[] = {\n" << objects.str() << "    {}\n};\n\n";
+
+    out.precision(17);
+    out << "const double embeddedVertices[] = {\n";
+    writeEmbeddedArray(out, vertices, 3);
+    out << "};\n\n";
+
+    out << "const unsigned char embeddedIndices[] = {\n";
+    writeEmbeddedArray(out, indices, 1);
+    out << "};\n\n";
+
+    out << "#endif\n";
+
+    if (!out) {
+        cout << "Could not write " << outputName << endl;
+        return false;
+    }
+
+    return true;
+
+}
+
+int main (int argc, char **argv)
+{
+    if (argc != 3) {
+        cout << "Usage: embedCatalog <components text file> <output header>" << endl;
+        return 1;
+    }
+
+    return writeEmbeddedCatalog(argv[1], argv[2]) ? 0 : 1;
+}
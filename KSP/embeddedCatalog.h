@@ -0,0 +1,68 @@
+/*
+
+    The built-in component catalog (0 components), generated from Components.txt by
+
+        embedCatalog Components.txt embeddedCatalog.h
+
+    Do not edit it by hand: the command runs before every build of the game. The meshes are stored already welded, triangulated and ordered for the vertex cache, exactly as loadObject returns them (with the triangle and edge indices delta-encoded). Every array ends with a record of zeros so that an empty catalog still compiles.
+
+*/
+
+#ifndef KSP_EMBEDDED_CATALOG_H
+#define KSP_EMBEDDED_CATALOG_H
+
+// This struct is one component of the built-in catalog: its catalog entry, and where its objects are in embeddedObjects
+struct EmbeddedComponent
+{
+    const char *fileName;
+
+    double mass;
+    double thrust;
+    double lift;
+    double drag;
+
+    double maxX, minX;
+    double maxY, minY;
+    double maxZ, minZ;
+
+    // The counts scanObject found in the model file (triangles after triangulation)
+    int vertexCount;
+    int triangleCount;
+    int polygonCount;
+
+    int firstObject;
+    int objectCount;
+};
+
+// This struct is one object of a built-in component, already optimized by loadObject: its vertices (three values each) in embeddedVertices, and its triangle and edge indices as delta-encoded streams in embeddedIndices (first is the byte the stream starts at, count the number of indices)
+struct EmbeddedObject
+{
+    int firstVertex;
+    int vertexCount;
+
+    int firstTriangle;
+    int triangleCount;
+
+    int firstEdge;
+    int edgeCount;
+};
+
+const int embeddedComponentCount = 0;
+
+const EmbeddedComponent embeddedComponents[] = {
+    {}
+};
+
+const EmbeddedObject embeddedObjects[] = {
+    {}
+};
+
+const double embeddedVertices[] = {
+    0, 0, 0
+};
+
+const unsigned char embeddedIndices[] = {
+    0
+};
+
+#endif
@@ -8,11 +8,55 @@
 #endif
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <iostream>
 #include <vector>
 #include <fstream>
 #include <sstream>
 #include <cmath>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <queue>
+#include <chrono>
+#include <set>
+#include <map>
+#include <list>
+#include <stdexcept>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <sys/stat.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <GL/glx.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#endif
+
+#include "telemetry.h"
+#include "sharedCatalog.h"
+#include "modelReader.h"
 
 /*
 
@@ -42,23 +86,50 @@
 
 using namespace std;
 
-// This struct represents one unit of a point in 3-dimensional space
-struct Point3D
+// The built-in catalog (and the structs it is made of), generated from the components text file by embedCatalog before every build
+#include "embeddedCatalog.h"
+
+// A loaded component mesh, shared (read-only) between the mesh cache and every placed part using it
+typedef shared_ptr<const vector<Object> > MeshHandle;
+
+// This struct is the silhouette of a component along the flight axis (the rocket flies up the Y axis, so this is the component seen from straight above): a grid of square cells over its X-Z bounds, each holding the height of the surface the air meets first there and the drag coefficient of that surface
+struct Silhouette
 {
-    double x;
-    double y;
-    double z;
+    // The corner of the grid, the size of its cells and the number of cells along X (columns) and Z (rows), in model units
+    double minX;
+    double minZ;
+    double cellSize;
+    int columns;
+    int rows;
+
+    // Per cell (row by row): the height of the frontmost surface (-infinity where nothing covers the cell), and its drag coefficient
+    vector<float> top;
+    vector<float> coefficient;
+
+    // The covered area and the drag area (drag coefficient times area) of the whole silhouette, in square model units
+    double frontalArea;
+    double dragArea;
 };
 
-// This struct is used to represent one object (loaded from a .obj file). It contains a list of the points and all the vectors for drawing the faces. It contains the max and min coordinates of every axis for scaling. It also contains physics info about the use of the component.
-struct Object
+// A component silhouette, computed once per component and shared like its mesh
+typedef shared_ptr<const Silhouette> SilhouetteHandle;
+
+// This struct is the mass properties of a solid body: its mass, its centre of mass, and its inertia tensor about the centre of mass. The tensor is symmetric, so only six entries are kept: xx, yy, zz, xy, yz and zx. A component's own mass properties are those of its mesh filled with a density of 1 (so the mass is its volume), and are scaled to the part's mass when it is placed
+struct MassProperties
 {
+    double mass;
+    Point3D centre;
+    double inertia[6];
+};
+
+// The mass properties of a component mesh, computed once per component and shared like its mesh
+typedef shared_ptr<const MassProperties> MassPropertiesHandle;
 
+// This struct is a convex hull: the corners of the smallest convex solid around a set of points, and its faces (three corner indices each, wound counter-clockwise seen from outside). Used as the collision proxy of components and of the rocket, so contact tests cost the same whatever the detail of the meshes
+struct ConvexHull
+{
     vector<Point3D> vertices;
-    vector<Point3D> normals;
-    vector<int> triangles;
-    vector<int> polygons;
-    vector<int> elements;
+    vector<int> faces;
 
     double maxX;
     double minX;
@@ -68,961 +139,8186 @@ struct Object
 
     double maxZ;
     double minZ;
+};
+
+// A convex hull, computed once per component and shared like its mesh
+typedef shared_ptr<const ConvexHull> HullHandle;
+
+// Parts as entities - every part the player places is an entity: a number, with its data kept in dense pools, one per kind of data, each holding that value for every part side by side. The pools are the state of the rocket: the passes over the parts (drawing, the exhaust, the fleet, the physics totals and picking) each read only the pools they need, straight through. The pools are persistent so that the edit history can keep every version of the rocket: changing a part copies only the pool nodes on the path to it and shares everything else with the old version
+
+// The state flags of a part
+const unsigned char PART_ASSEMBLED = 1;
+const unsigned char PART_SELECTED = 2;
+
+// This struct is the bounding box of a part's model (with maxX below minX if the model is empty)
+struct PartBounds
+{
+    double minX, maxX;
+    double minY, maxY;
+    double minZ, maxZ;
+};
 
+// This struct is the physics engine values of a part
+struct PartPhysics
+{
     double mass;
     double thrust;
     double lift;
     double drag;
-
 };
 
-// This struct is used to represent a "grouping", or "assembly", of components (which in turn contains sub-components). This is used to represent the playe constructed rocket in the game
-struct Union
+// This struct is what the physics knows of the shape of a part's model: its silhouette, its mass properties and its convex hull (shared with the mesh cache like the mesh)
+struct PartShape
 {
-    vector<vector<Object> > components;
+    SilhouetteHandle silhouette;
+    MassPropertiesHandle mass;
+    HullHandle hull;
 };
 
-// This function returns the magnitude of a given Point3D vector
-double getMagnitude (Point3D p)
-{
-    return sqrt((p.x * p.x) + (p.y * p.y) + (p.z * p.z));
-}
+// The number of bits of a part number used by each level of a pool, and the number of slots of each node (32)
+const int partPoolBits = 5;
+const int partPoolWidth = 1 << partPoolBits;
 
-// This method returns a new Point3D with subtracted values
-Point3D subtractP3D (Point3D p1, Point3D p2)
+// This struct is one node of a pool: a leaf holds the values of up to 32 parts side by side, a branch holds up to 32 nodes of the level below
+template <typename T>
+struct PartPoolNode
 {
-    Point3D p3;
-    p3.x = p1.x - p2.x;
-    p3.y = p1.y - p2.y;
-    p3.z = p1.z - p2.z;
-    return p3;
-}
+    vector<T> values;
+    vector<shared_ptr<const PartPoolNode<T> > > children;
+};
 
-// This method does cross multiplication on the 2 input points
-Point3D crossMultiplyP3D (Point3D p1, Point3D p2)
+// This struct is a pool: one value for every part, in a tree of 32 wide nodes that is never changed once built. Setting or adding a value returns a new pool that copies only the nodes on the path to that part and shares everything else with the old pool, so every old version stays valid at the cost of what changed. The values of 32 parts in a row are always side by side in one leaf (see getRun)
+template <typename T>
+struct PartPool
 {
-    Point3D p3;
-    p3.x = (p1.y * p2.z) - (p2.y * p1.z);
-    p3.x = (p1.z * p2.x) - (p2.z * p1.x);
-    p3.x = (p1.x * p2.y) - (p2.x * p1.y);
-    return p3;
-}
+    typedef shared_ptr<const PartPoolNode<T> > NodeHandle;
 
-// This method returns a new normalized unit vector Point3D of given Point3D p
-Point3D normalize (Point3D p)
-{
-    double magnitude = getMagnitude(p);
-    Point3D np;
-    np.x = (p.x/magnitude);
-    np.y = (p.y/magnitude);
-    np.z = (p.z/magnitude);
-    return np;
-}
+    // The nodes a change has already copied, so that a node shared by several versions is changed once and stays shared
+    typedef map<const PartPoolNode<T>*, NodeHandle> Changes;
 
-// This method returns a new loaded .obj file into the program as a new vector of objects
-vector<Object> loadObject (string fName) {
+    NodeHandle root;
 
-    // New vector to load the program files to
-    vector<Object> objects;
+    // The number of parts, and the number of index bits below the root (0 when the root is a leaf)
+    int count;
+    int shift;
 
-    // Create a new input file stream reader that will parse the .obj object model file
-    ifstream fParser(fName.c_str());
+    PartPool () : count(0), shift(0) {
+    }
 
-    if (!fParser)
-    {
-        cout << "Invalid File!" << endl;
-        return objects;
+    int size () const {
+        return count;
     }
 
-    // String variable used to store each line
-    string line;
+    // Returns the value of part i
+    const T &operator[] (int i) const {
+        return *getRun(i);
+    }
 
-    // Create a new blank object for the first case
-    Object newO;
-    objects.push_back(newO);
+    // Returns the values of part i to the last part of its leaf, side by side (see getRunEnd)
+    const T *getRun (int i) const {
 
-    // Integer variable used to keep track of the current index of the object
-    int cObj = 0;
+        const PartPoolNode<T> *node = root.get();
 
-    // These double variables are used to record the maximum x, y and z values of the current object. Used later for scaling and normalization
-    double maxX, maxY, maxZ = -1000000;
-    // These double variables are used to record the minimum x, y and z values of the current object. Used later for scaling and normalization
-    double minX, minY, minZ = 1000000;
+        for (int level=shift; level>0; level-=partPoolBits) {
+            node = node->children[(i >> level) & (partPoolWidth - 1)].get();
+        }
 
-    // Start the reading call for the entire file
-    while (getline(fParser, line))
-    {
+        return &node->values[i & (partPoolWidth - 1)];
 
-        // Check to see if the current line decalres a new object
-        if (line.substr(0,2) == "o ")
-        {
+    }
 
-            // Create a new object and add it to the objects vector. Increment the index of the current object
-            Object newO;
-            objects.push_back(newO);
-            cObj++;
+    // Returns a copy of the pool with the value of part i replaced
+    PartPool set (int i, const T &value) const {
 
-        }
-        else if (line.substr(0,2) == "v ")
-        {
+        PartPool pool = *this;
+        pool.root = setNode(root, shift, i, value);
 
-            // The current line contains a point for a vertex. Create a point and push it to the back of the current object's vertex
-            Point3D tempP;
+        return pool;
 
-            // Read the current point/vertice
-            istringstream sParser(line.substr(2));
+    }
 
-            // Parse the x, y and z coordinates into the current object
-            sParser >> tempP.x;
-            //sParser >> tempP.y;
-            //sParser >> tempP.z;
+    // Returns a copy of the pool with a value added for a new last part
+    PartPool push_back (const T &value) const {
 
-            sParser >> tempP.z;
-            sParser >> tempP.y;
+        PartPool pool = *this;
 
-            // Check to see if each coordinate is the currently assumed greatest value (maximum); if so, update the current max values
-            if (tempP.x > maxX) {
-                maxX = tempP.x;
-            }
+        if (!root) {
 
-            if (tempP.y > maxY) {
-                maxY = tempP.y;
-            }
+            pool.root = makePath(0, value);
 
-            if (tempP.z > maxZ) {
-                maxZ = tempP.z;
-            }
+        } else if (count == partPoolWidth << shift) {
 
-            // Check to see if each coordinate is the currently assumed smallest value (minimum); if so, update the current min values
-            if (tempP.x < minX) {
-                minX = tempP.x;
-            }
+            // The tree is full: add a level above the old root
+            shared_ptr<PartPoolNode<T> > node = make_shared<PartPoolNode<T> >();
+            node->children.push_back(root);
+            node->children.push_back(makePath(shift, value));
 
-            if (tempP.y < minY) {
-                minY = tempP.y;
-            }
+            pool.root = node;
+            pool.shift += partPoolBits;
 
-            if (tempP.z < minZ) {
-                minZ = tempP.z;
-            }
+        } else {
 
-            // Add the new point into the current vertices vector in the current object being loaded
-            objects[cObj].vertices.push_back(tempP);
+            pool.root = pushNode(root, shift, count, value);
 
         }
-        else if (line.substr(0,2) == "f ")
-        {
 
-            // Get the amount of vertices and determine whether it is a triangle or a polygon
+        pool.count++;
+
+        return pool;
 
-            // Assume that the current line contains a new face composed of 4 vertex indices only for now
-            string as, bs, cs, ds;
+    }
 
-            // Tokenize the string line and read each token
-            istringstream sParser(line.substr(2));
+    // Returns a copy of the pool with change applied to the value of every part (change is given the part number, and returns true if it changed the value). Nodes in which nothing changed are kept as they are
+    PartPool change (const function<bool (int, T &)> &change, Changes &changed) const {
 
-            // Read each index of the eadges used. Assume that there is a fourth vertice (some file formats do)
-            sParser >> as;
-            sParser >> bs;
-            sParser >> cs;
-            sParser >> ds;
+        PartPool pool = *this;
+        pool.root = changeNode(root, shift, 0, change, changed);
 
-            // Read the first 3 vertice indexes first for future drawing refenece
-            int a = stoi(as.substr(0,as.find("/")));
-            int b = stoi(bs.substr(0,bs.find("/")));
-            int c = stoi(cs.substr(0,cs.find("/")));
+        return pool;
 
-            // Decrement indices (.obj indices frustratingly start at 1)
-            a--;
-            b--;
-            c--;
+    }
 
-            // Check to see if a fourth vertice exists
-            if (ds != "") {
+    // Copies node with slot i (of the value below it at level) replaced
+    static NodeHandle setNode (const NodeHandle &node, int level, int i, const T &value) {
 
-                // If the last string token isn't blank, a fourth vertice exists and is added
+        shared_ptr<PartPoolNode<T> > copy = make_shared<PartPoolNode<T> >(*node);
+        int slot = (i >> level) & (partPoolWidth - 1);
 
-                int d = stoi(ds.substr(0,ds.find("/")));
-                d--;
+        if (level == 0) {
+            copy->values[slot] = value;
+        } else {
+            copy->children[slot] = setNode(node->children[slot], level - partPoolBits, i, value);
+        }
 
-                objects[cObj].polygons.push_back(a);
-                objects[cObj].polygons.push_back(b);
-                objects[cObj].polygons.push_back(c);
-                objects[cObj].polygons.push_back(d);
+        return copy;
 
-            } else {
+    }
 
-                // If the last string token is blank, fill triangles instead of polygons
-                objects[cObj].triangles.push_back(a);
-                objects[cObj].triangles.push_back(b);
-                objects[cObj].triangles.push_back(c);
+    // Copies node with value added as the value of part i (below the node at level)
+    static NodeHandle pushNode (const NodeHandle &node, int level, int i, const T &value) {
 
-            }
+        shared_ptr<PartPoolNode<T> > copy = make_shared<PartPoolNode<T> >(*node);
+        int slot = (i >> level) & (partPoolWidth - 1);
 
+        if (level == 0) {
+            copy->values.push_back(value);
+        } else if (slot < (int) copy->children.size()) {
+            copy->children[slot] = pushNode(node->children[slot], level - partPoolBits, i, value);
+        } else {
+            copy->children.push_back(makePath(level - partPoolBits, value));
         }
 
+        return copy;
+
     }
 
-    // Update the max and min coordinate parameters in each object
-    for (Object &obj : objects) {
+    // Builds a new chain of nodes from level down to a leaf holding only value
+    static NodeHandle makePath (int level, const T &value) {
 
-        obj.maxX = maxX;
-        obj.minX = minX;
+        shared_ptr<PartPoolNode<T> > node = make_shared<PartPoolNode<T> >();
 
-        obj.maxY = maxY;
-        obj.minY = minY;
+        if (level == 0) {
+            node->values.push_back(value);
+        } else {
+            node->children.push_back(makePath(level - partPoolBits, value));
+        }
 
-        obj.maxZ = maxZ;
-        obj.minZ = minZ;
+        return node;
 
     }
 
-}
+    // Returns node (whose first part is number first, at level) with change applied to every value below it
+    static NodeHandle changeNode (const NodeHandle &node, int level, int first, const function<bool (int, T &)> &change, Changes &changed) {
 
-// This method takes in an object and scales it down to an input range
-Object scaleObject (Object obj, double nMaxX, double nMinX, double nMaxY, double nMinY, double nMaxZ, double nMinZ) {
+        if (!node) {
+            return node;
+        }
 
-        double aspectRatio = (obj.maxY - obj.minY) / (obj.maxX - obj.minX);
+        typename Changes::iterator found = changed.find(node.get());
 
-        nMaxX *= (1/aspectRatio);
-        nMinX *= (1/aspectRatio);
+        if (found != changed.end()) {
+            return found->second;
+        }
 
-        // Object struct for the new point
-        Object nObj = obj;
+        shared_ptr<PartPoolNode<T> > copy;
 
-        vector<Point3D> nVertices;
+        for (int i=0; i<(int) node->values.size(); i++) {
 
-        for (Point3D p : obj.vertices) {
+            T value = node->values[i];
 
-            // Temporary point variable to be pushed back
-            Point3D temp;
+            if (change(first + i, value)) {
 
-            // Scale the x, y and z to be between their respective nMax and nMin values (normalization range)
+                if (!copy) {
+                    copy = make_shared<PartPoolNode<T> >(*node);
+                }
 
-            temp.x = ( ( (p.x - obj.minX) * (nMaxX - nMinX) ) / (obj.maxX - obj.minX) ) + nMinX;
-            temp.y = ( ( (p.y - obj.minY) * (nMaxY - nMinY) ) / (obj.maxY - obj.minY) ) + nMinY;
-            temp.z = ( ( (p.z - obj.minZ) * (nMaxZ - nMinZ) ) / (obj.maxZ - obj.minZ) ) + nMinZ;
+                copy->values[i] = value;
 
-            nVertices.push_back(temp);
+            }
 
         }
 
-        nObj.vertices = nVertices;
+        for (int i=0; i<(int) node->children.size(); i++) {
 
-        return nObj;
+            NodeHandle child = changeNode(node->children[i], level - partPoolBits, first + (i << level), change, changed);
 
-}
+            if (child != node->children[i]) {
 
-// This void method draws vector of objects with a translation of xpos, ypos, zpos
-void drawObject (vector<Object> objects, double xpos, double ypos, double zpos) {
+                if (!copy) {
+                    copy = make_shared<PartPoolNode<T> >(*node);
+                }
 
-    // Draw every object inside the given objects vector
-    for (int m=0; m<objects.size(); m++) {
+                copy->children[i] = child;
 
-        // Retrieve the vector of vertices (all points to be drawn)
-        vector<Point3D> vertices = objects[m].vertices;
+            }
 
-        // Retrieve the list of indexs to draw the triangles and polygonal faces
-        vector<int> triangles = objects[m].triangles;
-        vector<int> polygons = objects[m].polygons;
+        }
 
-        // Draw all triangles
-        for (int i=0; i<triangles.size(); i+=3) {
+        NodeHandle result = copy ? NodeHandle(copy) : node;
+        changed[node.get()] = result;
 
-            // First element refers to index of vertex, draw triangle based off of points
-            Point3D cVertex1 = vertices[triangles[i]];
-            Point3D cVertex2 = vertices[triangles[i+1]];
-            Point3D cVertex3 = vertices[triangles[i+2]];
+        return result;
 
-            // Draw each triangle as a new line frame
-            glBegin(GL_LINE_STRIP);
+    }
+};
 
-                glVertex3d(cVertex1.x + xpos, cVertex1.y + ypos, cVertex1.z + zpos);
-                glVertex3d(cVertex2.x + xpos, cVertex2.y + ypos, cVertex2.z + zpos);
-                glVertex3d(cVertex3.x + xpos, cVertex3.y + ypos, cVertex3.z + zpos);
+// This method returns the part after the last one of the run starting at part i (the end of its leaf, or last if that comes first). Every pool of a set of parts has the same leaves, so a pass over several pools takes one run of each at a time
+int getRunEnd (int i, int last) {
+    return min(last, (i & ~(partPoolWidth - 1)) + partPoolWidth);
+}
 
-            glEnd();
+// This struct is the parts of a rocket: a pool for each kind of data about them. The assembled parts are parts 0 to assembled - 1, and the workspace parts follow in the order they were added. A part refers to the shared catalog mesh instead of holding a copy, which also keeps the mesh pinned in the mesh cache
+struct PartWorld
+{
+    int size;
+    int assembled;
 
-        }
+    // The translation of each part from where it was added
+    PartPool<Point3D> transforms;
+    PartPool<MeshHandle> meshes;
+    PartPool<PartBounds> bounds;
+    PartPool<PartPhysics> physics;
+    PartPool<PartShape> shapes;
 
-        // Draw all quadrealateral polygonal frames
-        for (int i=0; i<polygons.size(); i+=4) {
+    // The index of the catalog entry each part was taken from (-1 once the entry is removed from the components text file)
+    PartPool<int> catalogIndices;
 
-            // First element refers to index of vertex, draw polygon based off of points
-            Point3D cVertex1 = vertices[polygons[i]];
-            Point3D cVertex2 = vertices[polygons[i+1]];
-            Point3D cVertex3 = vertices[polygons[i+2]];
-            Point3D cVertex4 = vertices[polygons[i+3]];
+    // The state flags of each part (PART_ASSEMBLED and PART_SELECTED)
+    PartPool<unsigned char> states;
 
-            // Draw the shape as a line frame
-            glBegin(GL_LINE_STRIP);
+    PartWorld () : size(0), assembled(0) {
+    }
+};
 
-                // Draw the four edges of the line strip (with translation)
-                glVertex3d(cVertex1.x + xpos, cVertex1.y + ypos, cVertex1.z + zpos);
-                glVertex3d(cVertex2.x + xpos, cVertex2.y + ypos, cVertex2.z + zpos);
-                glVertex3d(cVertex3.x + xpos, cVertex3.y + ypos, cVertex3.z + zpos);
-                glVertex3d(cVertex4.x + xpos, cVertex4.y + ypos, cVertex4.z + zpos);
+// This method returns the mesh of a component of the built-in catalog. The objects are copied straight out of the embedded arrays (they were optimized when the catalog was generated, so there is nothing to parse or process beyond decoding the index streams)
+vector<Object> loadEmbeddedObject (int index) {
 
-            glEnd();
+    const EmbeddedComponent &component = embeddedComponents[index];
 
-        }
+    vector<Object> objects(component.objectCount);
 
-    }
-}
+    for (int o=0; o<component.objectCount; o++) {
 
-// This void method renders a string (s) onto the screen at the given coordinates x, y with a given font
-void renderString (double x, double y, void* font, string s) {
+        const EmbeddedObject &source = embeddedObjects[component.firstObject + o];
+        Object &obj = objects[o];
 
-    // Set the rasterization coordinates
-    glRasterPos2i(x, y);
+        const double *vertex = &embeddedVertices[source.firstVertex * 3];
 
-    // Iterate through each character and render it independently
-    for (char c : s) {
+        obj.vertices.resize(source.vertexCount);
+
+        for (int v=0; v<source.vertexCount; v++) {
+            obj.vertices[v] = Point3D{vertex[v*3], vertex[v*3+1], vertex[v*3+2]};
+        }
+
+        decodeIndices(embeddedIndices + source.firstTriangle, source.triangleCount, obj.triangles);
+        decodeIndices(embeddedIndices + source.firstEdge, source.edgeCount, obj.edges);
 
-        // Draw the bitmap of the current character
-        glutBitmapCharacter(font, c);
+        obj.maxX = component.maxX;
+        obj.minX = component.minX;
+
+        obj.maxY = component.maxY;
+        obj.minY = component.minY;
+
+        obj.maxZ = component.maxZ;
+        obj.minZ = component.minZ;
 
     }
 
+    return objects;
+
 }
 
-// This integer will represent the current stage of the game
-int stage = 0;
+// This method returns the catalog metadata of a component of the built-in catalog
+CatalogInfo getEmbeddedInfo (int index) {
 
-// All Rocket objects/components loaded into the program to be used for custom rocket construction
-vector<vector<Object> > components;
-// The menu displaying the components for the player to select and add to the assembly
-vector<vector<Object> > menu;
-// This is a list of all objects that a user has selected but not applied to the rocket (i.e., in the "workspace" but not in assembly)
-vector<vector<Object> > workspace;
+    const EmbeddedComponent &component = embeddedComponents[index];
 
-// The union assembly variable used to represent the final assembly to be used in the simulation
-Union assembly;
+    CatalogInfo info;
 
-// Index/ID of the currently selected component to be moved (initialize with null value)
-int selected = -1;
-// Index/ID of the currently selected menu part to be added to the main assembly (initialize with null value)
-int menuSelection = -1;
+    info.entry.fileName = component.fileName;
+    info.entry.embedded = index;
+    info.entry.mass = component.mass;
+    info.entry.thrust = component.thrust;
+    info.entry.lift = component.lift;
+    info.entry.drag = component.drag;
 
-// The x and y coordinates of the left mouse click, scaled between 0 and 1000 (used to determine which menu item has been clicked
-double leftX = -1;
-double leftY = -1;
+    info.maxX = component.maxX;
+    info.minX = component.minX;
 
-// The translation values of the currently selected component
-double sxpos = 0;
-double sypos = 0;
-double szpos = 0;
+    info.maxY = component.maxY;
+    info.minY = component.minY;
 
-// Boolean variable stating whether the middle mouse button is being held
-bool mhold = false;
-// Global Perspective (gp) middle mouse button values (delta x, delta y, current x + y)
-int gpx1, gpx2, gpy1, gpy2, gpcx, gpcy;
+    info.maxZ = component.maxZ;
+    info.minZ = component.minZ;
 
-// Physics engine values - The following variables are constants for simulating a rocket launch
+    info.objectCount = component.objectCount;
+    info.vertexCount = component.vertexCount;
+    info.triangleCount = component.triangleCount;
+    info.polygonCount = component.polygonCount;
 
-// The current state of the rocket (assembly)
-double totalMass = 0;
-double totalThrust = 0;
-double totalLift = 0;
-double totalDrag = 0;
+    return info;
 
-// The vertical position at any point in time
-double v_pos = 0.0;
-// The vertical velocity at any point in time
-double v_vel = 0.0;
+}
 
-// The last time the time is recorded (used to record the change in, delta, time)
-double dtime = 0.0;
+// This method returns the number of bytes of memory held by a loaded component mesh (used for the mesh cache budget)
+size_t getMeshBytes (const vector<Object> &component) {
 
-// Gravitational acceleration on the surface of the Earth (assuming no increase in decelleration as rocket gors further up)
-const double g_accl = -9.8;
+    size_t bytes = sizeof(vector<Object>) + component.capacity() * sizeof(Object);
 
-// This boolean variable is used to determine whether the user has pressed B yet in the rocket launch screen
-bool BLASTOFF = false;
+    for (const Object &obj : component) {
+        bytes += (obj.vertices.capacity() + obj.normals.capacity()) * sizeof(Point3D);
+        bytes += (obj.triangles.capacity() + obj.polygons.capacity() + obj.elements.capacity() + obj.edges.capacity()) * sizeof(int);
+        bytes += obj.quantized.capacity() * sizeof(int16_t) + obj.shortEdges.capacity() * sizeof(uint16_t);
+    }
 
-// This void method takes in a list of items to be displayed "rotating" in display menu. The screen is assumed to be (0, 1000, 0, 1000, -1000, 1000). The method pipes the scaled models to the menu global vector
-void initMenu (vector<vector<Object> > items) {
+    return bytes;
 
-    // Draw each of the objects in the menu. Scale down first and then draw
-    for (vector<Object> objList : items) {
+}
 
-        // Create a new temporary vector of objects to store the scaled model
-        vector<Object> temp;
+// Compact meshes - with --compact-meshes, a mesh is compacted once its silhouette, mass properties and convex hull are worked out, leaving only what is drawn: every vertex as three 16-bit steps between the bounds of its object (6 bytes instead of 24), and the edges as 16-bit indices where the object has at most 65536 vertices. The triangles are dropped, as the polygons are once triangulated. The vertices are never expanded again: the draws hand the quantized values to OpenGL and fold the steps back into coordinates with the transform they are drawn with. One step is 1/65534 of the size of the model, far below a pixel at the scale the game shows models
 
-        for (Object obj : objList) {
+// Set with --compact-meshes
+bool compactMeshes = false;
 
-            Object nObj = scaleObject(obj, 200, 0, 200, 0, 200, -200);
-            temp.push_back(nObj);
+// The number of steps either side of the middle of the bounds of an object
+const int quantizedSteps = 32767;
 
-        }
+// This struct is the line frame of an object as OpenGL arrays: its vertices (full precision, or quantized), its edge indices, and the scale and origin that turn the stored vertex values into coordinates (1 and 0 for full precision vertices)
+struct EdgeArrays
+{
+    GLenum vertexType;
+    GLsizei vertexStride;
+    const void *vertices;
 
-        // Push the new temporary vector into the global menu variable
-        menu.push_back(temp);
+    GLenum indexType;
+    const void *indices;
+    int indexCount;
 
-    }
+    bool quantized;
+    double scale[3];
+    double origin[3];
+};
+
+// This method returns the scale (size of one step) and origin (middle) of the quantized values of an object along one axis
+void getQuantization (double minValue, double maxValue, double &scale, double &origin) {
+
+    origin = (minValue + maxValue) / 2;
+    scale = max(maxValue - minValue, 0.0) / 2 / quantizedSteps;
 
 }
 
-// This void method draws the intro screen
-void drawIntroScreen () {
+// This method returns the arrays to draw the line frame of an object with, in whichever form it is kept
+EdgeArrays getEdgeArrays (const Object &obj) {
 
-    // Draw a black background
-    glClearColor(0.0, 0.0, 0.0, 0.0);
+    EdgeArrays arrays;
 
-    // Render the introduction text across the screen
+    arrays.quantized = !obj.quantized.empty();
 
-    // Set the draw color to white
-    glColor3f(1.0, 1.0, 1.0);
+    if (arrays.quantized) {
 
-    // Render the intro text as seperate lines
-    renderString(10, 700, GLUT_BITMAP_HELVETICA_18, "You are the fearless Space Commander in Chief (SCC) of an alien race");
-    renderString(10, 650, GLUT_BITMAP_HELVETICA_18, "named the Kerugami. Posed with the previously thought insurmountable");
-    renderString(10, 600, GLUT_BITMAP_HELVETICA_18, "objective of making the Kerugami a space-faring species, you are given");
-    renderString(10, 550, GLUT_BITMAP_HELVETICA_18, "the necessary components to build and launch a rocket. ");
-    renderString(200, 400, GLUT_BITMAP_HELVETICA_18, "Are you ready to take on this daunting task?");
-    renderString(670, 250, GLUT_BITMAP_HELVETICA_18, " Press SPACE for YES");
-    renderString(520, 200, GLUT_BITMAP_HELVETICA_12, " [No has not been added as a feature to the game]");
+        arrays.vertexType = GL_SHORT;
+        arrays.vertexStride = 3 * sizeof(int16_t);
+        arrays.vertices = &obj.quantized[0];
 
-}
+        getQuantization(obj.minX, obj.maxX, arrays.scale[0], arrays.origin[0]);
+        getQuantization(obj.minY, obj.maxY, arrays.scale[1], arrays.origin[1]);
+        getQuantization(obj.minZ, obj.maxZ, arrays.scale[2], arrays.origin[2]);
 
-// This void method draws the menu vector on the side
-void drawMenu () {
+    } else {
 
-    // Double variables used to keep track of the starting position of each draw
-    double startX = 5.0;
-    double startY = 725.0;
-    double startZ = 1000.0;
+        arrays.vertexType = GL_DOUBLE;
+        arrays.vertexStride = sizeof(Point3D);
+        arrays.vertices = obj.vertices.empty() ? nullptr : &obj.vertices[0].x;
 
-    for (vector<Object> component : menu) {
+        for (int k=0; k<3; k++) {
+            arrays.scale[k] = 1;
+            arrays.origin[k] = 0;
+        }
 
-        // Set the polyon color to white
-        glColor3f(1, 1, 1);
+    }
 
-        // Draw a square polygon surrounding the current object
-        glBegin(GL_POLYGON);
-            glVertex3d(startX + 250, startY, startZ);
-            glVertex3d(startX + 250, startY + 250, startZ);
-            glVertex3d(startX, startY + 250, startZ);
-            glVertex3d(startX, startY, startZ);
-        glEnd();
+    if (!obj.shortEdges.empty()) {
 
-        // Draw a bounding box around the polygon
+        arrays.indexType = GL_UNSIGNED_SHORT;
+        arrays.indices = &obj.shortEdges[0];
+        arrays.indexCount = obj.shortEdges.size();
 
-        // Set the line drawing color to black
-        glColor3f(0, 0, 0);
+    } else {
 
-        // Draw a square polygon surrounding the current object
-        glBegin(GL_LINE_LOOP);
-            glVertex3d(startX, startY, 1200);
-            glVertex3d(startX + 250, startY, 1200);
-            glVertex3d(startX + 250, startY + 250, 1200);
-            glVertex3d(startX, startY + 250, 1200);
-        glEnd();
+        arrays.indexType = GL_UNSIGNED_INT;
+        arrays.indices = obj.edges.empty() ? nullptr : &obj.edges[0];
+        arrays.indexCount = obj.edges.size();
 
-        // Draw the actual mini-sized model at the correct starting position
+    }
 
-        glColor3f(0, 0, 1);
+    return arrays;
 
-        // Draw the component
-        drawObject(component, startX, startY, startZ);
-        // Increment the position for the next box
-        startY -= 250;
+}
+
+// This void method replaces the vertices, triangles and edges of an object with its compact form (only the line frame is left to draw, so the mesh must not be used for anything else afterwards)
+void compactObject (Object &obj) {
 
+    if (!obj.quantized.empty() || obj.vertices.empty()) {
+        return;
     }
 
-    // Draw user instructions (in text) underneath menu
+    double scale[3], origin[3];
 
-    // Set the text drawing color to black
-    glColor3f(0.0, 0.0, 0.0);
+    getQuantization(obj.minX, obj.maxX, scale[0], origin[0]);
+    getQuantization(obj.minY, obj.maxY, scale[1], origin[1]);
+    getQuantization(obj.minZ, obj.maxZ, scale[2], origin[2]);
 
-    // Draw text with user instruction menu
-    renderString(10, 180, GLUT_BITMAP_HELVETICA_12, "Use middle mouse button to rotate");
-    renderString(10, 145, GLUT_BITMAP_HELVETICA_12, "Left click on menu item to add a part");
-    renderString(10, 110, GLUT_BITMAP_HELVETICA_12, "Press 0-9 to select an unassembled part");
-    renderString(10, 75, GLUT_BITMAP_HELVETICA_12, "Press W,A,S,D,P,L to move selected part");
-    renderString(10, 40, GLUT_BITMAP_HELVETICA_12, "Press U to assemble wokspace");
-    renderString(10, 15, GLUT_BITMAP_HELVETICA_12, "(Assembled parts cannot be moved)");
+    obj.quantized.resize(obj.vertices.size() * 3);
 
-}
+    for (int v=0; v<obj.vertices.size(); v++) {
 
-// This method checks to see if any components needs to be added to the workspace
-void updateWorkspace () {// Scale the creen for the specific screen
+        const double values[3] = {obj.vertices[v].x, obj.vertices[v].y, obj.vertices[v].z};
 
-    // Check to see if the mouse left click selection lands on a valid menu item. Each menu item is bounded by a 250 by 250 box
-    if (leftX <= 250) {
+        for (int k=0; k<3; k++) {
 
-        // Get the current index of the selected component in the workspace based off the click position
-        int index = (int) (leftY/250);
+            double step = scale[k] > 0 ? round((values[k] - origin[k]) / scale[k]) : 0;
+
+            obj.quantized[v*3+k] = (int16_t) max(-(double) quantizedSteps, min((double) quantizedSteps, step));
 
-        // Check to see if the X value is inside the range of the menu
-        if (index < menu.size()) {
-            // Update the menu item at the selected menu "square" by adding it to the workspace
-            workspace.push_back(components[index]);
         }
 
     }
 
-}
+    if (obj.vertices.size() <= 65536) {
+        obj.shortEdges.assign(obj.edges.begin(), obj.edges.end());
+        vector<int>().swap(obj.edges);
+    }
 
-// This void method takes in a nested vector of objects and pipes all subobjects as objects in the assembly union. It also clears the entire workspace
-void assembleComponents(vector <vector <Object> > parts) {
+    vector<Point3D>().swap(obj.vertices);
+    vector<Point3D>().swap(obj.normals);
+    vector<int>().swap(obj.triangles);
 
-    // Iterate through every object group
-    for (int i=0; i<parts.size(); i++) {
+}
 
-        // Get the current set of components to be added to the assembly and removed from the workspace
-        vector<Object> objects = parts[i];
+// This method returns the physics engine values of a part taken from a catalog entry
+PartPhysics getPartPhysics (const ComponentEntry &entry) {
 
-        // Add the current sub-component/object group to the main assembly
-        assembly.components.push_back(objects);
-        workspace.erase(workspace.begin() + i);
+    PartPhysics physics;
+    physics.mass = entry.mass;
+    physics.thrust = entry.thrust;
+    physics.lift = entry.lift;
+    physics.drag = entry.drag;
 
-    }
+    return physics;
 
 }
 
-// This void method increments all the points at index in the components vector (pre-setting a translation)
-void setPreTranslate (vector< vector <Object> > &components, int index, int nx, int ny, int nz) {
+// This void method draws vector of objects with a translation of xpos, ypos, zpos
+void drawObject (const vector<Object> &objects, double xpos, double ypos, double zpos) {
+
+    glPushMatrix();
+    glTranslated(xpos, ypos, zpos);
 
-    // Get the pointer objects vector to be modified
-    vector<Object> &objects = components[selected];
+    // Draw the line frame of the triangles straight from the vertex and edge arrays (one call per object, each shared edge once)
+    glEnableClientState(GL_VERTEX_ARRAY);
 
-    // Iterate through all "sub-objects" within the current object and update each vertice seperately
-    for (int m=0; m<objects.size(); m++) {
+    for (const Object &obj : objects) {
 
-        // Get all vertices in the current sub-object
-        vector<Point3D> &vertices = objects[m].vertices;
+        EdgeArrays arrays = getEdgeArrays(obj);
 
-        // Iterate over all of the current vertices and increment each
-        for (int v=0; v<vertices.size(); v++) {
-            // Increment the current vertice
-            Point3D &cVertex = vertices[v];
-            cVertex.x += nx;
-            cVertex.y += ny;
-            cVertex.z += nz;
+        if (arrays.indexCount == 0) {
+            continue;
         }
 
-    }
+        glVertexPointer(3, arrays.vertexType, arrays.vertexStride, arrays.vertices);
 
-}
+        // Quantized vertices are turned back into coordinates by the transform they are drawn with
+        if (arrays.quantized) {
 
-// This void method draws the entire rocket assembly screen
-void drawRocketAssembly () {
+            glPushMatrix();
+            glTranslated(arrays.origin[0], arrays.origin[1], arrays.origin[2]);
+            glScaled(arrays.scale[0], arrays.scale[1], arrays.scale[2]);
 
-    // Draw a white background
-    glClearColor(1.0, 1.0, 1.0, 0.0);
+            glDrawElements(GL_LINES, arrays.indexCount, arrays.indexType, arrays.indices);
 
-    // Draw each of the different components in the current assembly
-    for (int i=0; i<assembly.components.size(); i++) {
+            glPopMatrix();
 
-        // Get the current obect to be drawn
-        vector<Object> obj = assembly.components[i];
+        } else {
 
-        double xtrans = 500;
-        double ytrans = 500;
-        double ztrans = 0;
+            glDrawElements(GL_LINES, arrays.indexCount, arrays.indexType, arrays.indices);
 
-        // Set color to the completed assembly union color black
-        glColor3d(0,0,0);
+        }
 
-        glPushMatrix();
+    }
 
-            glMatrixMode(GL_MODELVIEW);
+    glDisableClientState(GL_VERTEX_ARRAY);
 
-            // Rotate the global perspective
-            glRotated(gpcx, 0, 1000, 0);
-            glRotated(gpcy, 1000, 0, 0);
+    glPopMatrix();
 
-            drawObject(obj, xtrans, ytrans, ztrans);
+}
 
-        glPopMatrix();
+// Text rendering - the GLUT bitmap fonts are rasterized once into a texture atlas (on the first frame), and every string is laid out once into a batch of textured quads that is drawn with a single call. Layouts are cached by font and text, so a string that does not change is never laid out again
 
-    }
+// This struct is the texture atlas of one GLUT bitmap font: every printable character in a grid of equal cells, with the baseline the same distance up every cell
+struct GlyphAtlas
+{
+    void *font;
 
-    // Draw each of the different components in the current workspace (excluding assembly)
-    for (int i=0; i<workspace.size(); i++) {
+    // The cell size and the height of the baseline within a cell (in pixels)
+    int cellWidth;
+    int cellHeight;
+    int baseline;
 
-        // Get the current obect to be drawn
-        vector<Object> obj = workspace[i];
+    // The number of cells per row of the texture
+    int columns;
 
-        double xtrans = 500;
-        double ytrans = 500;
-        double ztrans = 0;
+    // How far each character moves the pen (in pixels)
+    int advance[128];
 
-        // Determine drawing color depending on whether the current element is the selected one to be moved
-        if (i == selected) {
-            // The element is selected, set draw color to green
-            glColor3d(0,1,0);
-            // Also move the component
-            xtrans += sxpos;
-            ytrans += sypos;
-            ztrans += szpos;
+    // The box around the pixels of each glyph within its cell (left, bottom, right, top in pixels; empty for blank glyphs). Quads only cover this box, which keeps the fill cost down
+    int ink[128][4];
 
-        } else {
-            // Otherwise, not selected. Set to default draw color (blue)
-            glColor3d(0,0,1);
-        }
+    // The atlas texture (0 until the atlas is built)
+    GLuint texture;
+};
 
-        glPushMatrix();
+// The laid out quads of one string, four vertices per character of x, y (in pixels from the start of the baseline), u and v
+struct TextLayout
+{
+    vector<GLfloat> vertices;
+    int quads;
+};
 
-            glMatrixMode(GL_MODELVIEW);
+// The size of every atlas texture
+const int glyphAtlasSize = 256;
 
-            // Rotate the global perspective
-            glRotated(gpcx, 0, 1000, 0);
-            glRotated(gpcy, 1000, 0, 0);
+// The fonts used by the game, with room for the descenders below and the accents above their glyphs
+GlyphAtlas glyphAtlases[2] = {
+    {GLUT_BITMAP_HELVETICA_12, 0, 20, 5, 0, {0}, {{0}}, 0},
+    {GLUT_BITMAP_HELVETICA_18, 0, 28, 7, 0, {0}, {{0}}, 0}
+};
 
-            drawObject(obj, xtrans, ytrans, ztrans);
+// Whether the atlases have been built (they are built on the first frame)
+bool glyphAtlasesBuilt = false;
 
-        glPopMatrix();
+// The laid out strings, by font and text. Only text that keeps changing (like the loading counter) adds new layouts, so the cache is simply emptied when it gets large
+map<pair<void*, string>, TextLayout> textLayouts;
 
-    }
+const int maxTextLayouts = 256;
 
-    // Draw the components menu
-    drawMenu();
+// This void method builds the atlas of every font. Every glyph is drawn with GLUT into the bottom left corner of the back buffer and copied into the atlas texture, so it must be called before the frame is cleared and drawn. Fonts whose atlas does not fit keep being drawn with GLUT
+void buildGlyphAtlases () {
 
-}
+    glyphAtlasesBuilt = true;
 
-// This void method draws the winning screen. Called when the player reaches "space" (a pre-determined height)
-void drawWinScreen () {
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
 
-    // Draw a black background
-    glClearColor(0.0, 0.0, 0.0, 0.0);
+    // The glyphs are drawn in window pixels, so the window has to be at least as big as the atlas
+    if (viewport[2] < glyphAtlasSize || viewport[3] < glyphAtlasSize) {
+        return;
+    }
 
-    // Render the winning text across the screen
+    GLfloat clearColor[4];
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
 
-    // Set the draw color to white
-    glColor3f(1.0, 1.0, 1.0);
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+    glDisable(GL_DEPTH_TEST);
 
-    // Render the intro text as seperate lines
-    renderString(450, 450, GLUT_BITMAP_HELVETICA_18, "Congratulations! You successful made it to space!");
-    renderString(550, 350, GLUT_BITMAP_HELVETICA_18, "What will be the next frontier?");
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(viewport[0], viewport[0] + viewport[2], viewport[1], viewport[1] + viewport[3], -1, 1);
 
-}
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
 
-// This void method draws the losing screen. Called when the player crashes their rocket during launch.
-void drawLosingScreen () {
+    glPushClientAttrib(GL_CLIENT_PIXEL_STORE_BIT);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    // Draw a black background
-    glClearColor(0.0, 0.0, 0.0, 0.0);
+    for (GlyphAtlas &atlas : glyphAtlases) {
 
-    // Render the losing text across the screen
+        int widest = 0;
 
-    // Set the draw color to white
-    glColor3f(1.0, 1.0, 1.0);
+        for (int c=0; c<128; c++) {
+            atlas.advance[c] = c >= 32 && c < 127 ? glutBitmapWidth(atlas.font, c) : 0;
+            widest = max(widest, atlas.advance[c]);
+        }
 
-    // Render the intro text as seperate lines
-    renderString(610, 420, GLUT_BITMAP_HELVETICA_18, "Uh oh! Rocket crashed!");
-    renderString(550, 350, GLUT_BITMAP_HELVETICA_18, "Back to the drawing boards!");
-    renderString(550, 250, GLUT_BITMAP_HELVETICA_18, "Press SPACE to restart");
+        // Leave a margin for glyphs that reach past their pen position
+        atlas.cellWidth = widest + 4;
+        atlas.columns = glyphAtlasSize / atlas.cellWidth;
 
+        if ((95 + atlas.columns - 1) / atlas.columns * atlas.cellHeight > glyphAtlasSize) {
+            continue;
+        }
 
-}
+        // Draw the glyphs in white on black
+        glClearColor(0, 0, 0, 0);
+        glClear(GL_COLOR_BUFFER_BIT);
+        glColor3f(1, 1, 1);
 
-// This void method sets up the constants for the current iteration of the rocket (assembly)
-void updateRocketPhysics () {
+        for (int c=32; c<127; c++) {
+
+            int cell = c - 32;
+
+            glRasterPos2i(viewport[0] + cell % atlas.columns * atlas.cellWidth + 2, viewport[1] + cell / atlas.columns * atlas.cellHeight + atlas.baseline);
+            glutBitmapCharacter(atlas.font, c);
+
+        }
+
+        // Read them back and keep them as the alpha of the atlas
+        vector<GLubyte> pixels(glyphAtlasSize * glyphAtlasSize);
 
-    // Zero all previous rocket values
-    totalMass = 0;
-    totalThrust = 0;
-    totalLift = 0;
-    totalDrag = 0;
+        glReadPixels(viewport[0], viewport[1], glyphAtlasSize, glyphAtlasSize, GL_LUMINANCE, GL_UNSIGNED_BYTE, &pixels[0]);
 
-    // Get the total values for mass, thrust, lift and drag on the rocket (assembly). Iterate through the entire assembly and retireve all components (and included subcomponent) data
-    for (vector<Object> temp_components : assembly.components) {
+        for (GLubyte &pixel : pixels) {
+            pixel = pixel > 127 ? 255 : 0;
+        }
+
+        // Find the ink box of every glyph
+        for (int c=32; c<127; c++) {
+
+            int cell = c - 32;
+            int cellX = cell % atlas.columns * atlas.cellWidth;
+            int cellY = cell / atlas.columns * atlas.cellHeight;
+
+            int *ink = atlas.ink[c];
+            ink[0] = atlas.cellWidth; ink[1] = atlas.cellHeight; ink[2] = 0; ink[3] = 0;
 
-        // Iterate through all sub components in the assembly
-        for (Object obj : temp_components) {
+            for (int y=0; y<atlas.cellHeight; y++) {
+                for (int x=0; x<atlas.cellWidth; x++) {
 
-            // Accumulate physics engine values
-            totalMass += obj.mass;
-            totalThrust += obj.thrust;
-            totalLift += obj.lift;
-            totalDrag += obj.drag;
+                    if (pixels[(cellY + y) * glyphAtlasSize + cellX + x]) {
+                        ink[0] = min(ink[0], x); ink[1] = min(ink[1], y);
+                        ink[2] = max(ink[2], x + 1); ink[3] = max(ink[3], y + 1);
+                    }
+
+                }
+            }
 
         }
 
+        glGenTextures(1, &atlas.texture);
+        glBindTexture(GL_TEXTURE_2D, atlas.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, glyphAtlasSize, glyphAtlasSize, 0, GL_ALPHA, GL_UNSIGNED_BYTE, &pixels[0]);
+
     }
 
-    // Update the initial vertical velocity to the total starting thrust
-    v_vel = totalThrust;
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPopClientAttrib();
 
-    // Reset vertical position (v_pos)
-    v_pos = 0;
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopMatrix();
+
+    glPopAttrib();
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
 
 }
 
-// This void method does translation operations on the assembled rocket based on its physics engine values
-void launchRocket () {
+// This method returns the atlas of a font (nullptr if the font has no atlas)
+GlyphAtlas *getGlyphAtlas (void *font) {
+
+    for (GlyphAtlas &atlas : glyphAtlases) {
+        if (atlas.font == font && atlas.texture != 0) {
+            return &atlas;
+        }
+    }
+
+    return nullptr;
+
+}
+
+// This method returns the layout of a string, laying it out the first time it is drawn
+const TextLayout &getTextLayout (const GlyphAtlas &atlas, const string &s) {
+
+    pair<void*, string> key(atlas.font, s);
+
+    map<pair<void*, string>, TextLayout>::iterator found = textLayouts.find(key);
+
+    if (found != textLayouts.end()) {
+        return found->second;
+    }
+
+    if (textLayouts.size() >= maxTextLayouts) {
+        textLayouts.clear();
+    }
+
+    TextLayout &layout = textLayouts[key];
+    layout.quads = 0;
+
+    int pen = 0;
+
+    for (char c : s) {
+
+        // Characters the atlas does not have are skipped
+        if (c < 32 || c >= 127) {
+            continue;
+        }
 
-    // Get the curretn elapsed time
-    const double time = glutGet(GLUT_ELAPSED_TIME) / 10000.0;
+        const int *ink = atlas.ink[(int) c];
 
-    // The current vertical acceleration
-    double v_accl = g_accl;
+        // Blank glyphs (like spaces) only move the pen
+        if (ink[2] > ink[0]) {
 
-    // Calculate the horizontal and vertical acceleration and velocity: Thrust is the initial vertical velocity, Lift is the initial vertical accelleration, and Drag is the rate of vertical decelleration (for thrust to decrease till 0)
+            int cell = c - 32;
 
-    // First, calculate additional vertical acceleration (lift minus drag)
-    if (totalLift > 0) {
+            // The ink box in the atlas, and where it goes relative to the pen (the glyph origin is 2 pixels into the cell, on the baseline)
+            GLfloat u0 = (GLfloat) (cell % atlas.columns * atlas.cellWidth + ink[0]) / glyphAtlasSize;
+            GLfloat v0 = (GLfloat) (cell / atlas.columns * atlas.cellHeight + ink[1]) / glyphAtlasSize;
+            GLfloat u1 = u0 + (GLfloat) (ink[2] - ink[0]) / glyphAtlasSize;
+            GLfloat v1 = v0 + (GLfloat) (ink[3] - ink[1]) / glyphAtlasSize;
 
-        // Get the total vertical acceleration by adding the current total lift to it
-        v_accl += totalLift;
+            GLfloat left = pen - 2 + ink[0];
+            GLfloat bottom = ink[1] - atlas.baseline;
+            GLfloat right = pen - 2 + ink[2];
+            GLfloat top = ink[3] - atlas.baseline;
 
-        // Decrease lift further if it is not already zero
-        totalLift -= totalDrag;
+            GLfloat quad[16] = {
+                left, bottom, u0, v0,
+                right, bottom, u1, v0,
+                right, top, u1, v1,
+                left, top, u0, v1
+            };
 
-    } else if (totalLift < 0) {
+            layout.vertices.insert(layout.vertices.end(), quad, quad + 16);
+            layout.quads++;
 
-        // If the lift is less than 0, set to to zero (drag should only decrease additional vertical acceleration)
-        totalLift = 0;
+        }
 
-        // Reset the vertical acceleration to only the gravitational decelleration
-        v_accl = g_accl;
+        pen += atlas.advance[(int) c];
 
     }
 
-    // Get the change in time
-    dtime = time - dtime;
+    return layout;
 
-    // Update the vertical velocity (accumulated acceleration over time)
-    v_vel += v_accl * dtime;
-    // update the vertical position (accumulated velocity over time)
-    v_pos += v_vel * dtime;
+}
 
-    // Check winning and losing conditions
+// This void method renders a string (s) onto the screen at the given coordinates x, y with a given font. The text is placed, coloured and depth tested like GLUT bitmap text, but drawn from the font's atlas in one call
+void renderString (double x, double y, void* font, string s) {
 
-    if (v_pos < 0) {
+    GlyphAtlas *atlas = getGlyphAtlas(font);
 
-        // If the rocket crashed (goes below ground), stop further calls. Print Losing Screen (stage 4)
-        stage = 4;
+    if (atlas == nullptr) {
 
-        // Reset BLASTOFF (so that a relaunch would not be instantly activated)
-        BLASTOFF = false;
+        // Set the rasterization coordinates
+        glRasterPos2i(x, y);
+
+        // Iterate through each character and render it independently
+        for (char c : s) {
+
+            // Draw the bitmap of the current character
+            glutBitmapCharacter(font, c);
+
+        }
 
         return;
 
-    } else if (v_pos >= 5000) {
+    }
 
-        // If the rocket has reached a pre-determined "space" height of 5000, print winning screen (stage 3)
-        stage = 3;
+    const TextLayout &layout = getTextLayout(*atlas, s);
 
-        // End the current method call
+    if (layout.quads == 0) {
         return;
+    }
+
+    // Find the window position GLUT would start the text at (text starting outside the view is not drawn, like a bitmap at an invalid raster position)
+    GLdouble modelview[16], projection[16];
+    GLint viewport[4];
+    GLdouble wx, wy, wz;
 
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
+    glGetDoublev(GL_PROJECTION_MATRIX, projection);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    if (!gluProject((int) x, (int) y, 0, modelview, projection, viewport, &wx, &wy, &wz) || wz < 0 || wz > 1) {
+        return;
     }
 
+    glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_COLOR_BUFFER_BIT);
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+    // Draw in window pixels at the depth of the start position (bitmaps start at the pixel the raster position falls in)
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    glOrtho(viewport[0], viewport[0] + viewport[2], viewport[1], viewport[1] + viewport[3], -1, 1);
+
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+    glTranslated(floor(wx + 0.001), floor(wy + 0.001), 1 - 2 * wz);
+
+    // Keep the pixels of the glyphs in the current colour and drop the rest
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, atlas->texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+    glEnable(GL_ALPHA_TEST);
+    glAlphaFunc(GL_GREATER, 0.5);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), &layout.vertices[0]);
+    glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), &layout.vertices[2]);
+
+    glDrawArrays(GL_QUADS, 0, layout.quads * 4);
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+
+    glPopClientAttrib();
+    glPopAttrib();
 
 }
 
-// This void method draws the rocket launch simulation
-void drawRocketLaunch ()
+// Job system - one shared pool of worker threads runs all background work (component loading, mesh loads, hot reloads, batch simulation). Every worker owns a deque of jobs: it pushes and pops its own jobs at the back and, when it runs out, steals from the front of another worker's deque. Idle workers park on a condition variable instead of spinning. Work that has to run on the render thread (anything touching GL or the game state) goes through a separate main-thread queue that is drained between frames
+
+// This struct is one unit of work for the job system. A job becomes runnable once it has been submitted and every job it depends on has finished
+struct Job
 {
+    function<void()> work;
 
-    // Draw a shifting color background (the higher you are, the blacker the background becomes to emulate space)
-    glClearColor(1.0 - v_pos * 0.0005, 1.0- v_pos * 0.0005, 1.0- v_pos * 0.0005, 0.0);
+    // The number of unfinished jobs this job waits for, plus one until it is submitted
+    atomic<int> pending;
+    atomic<bool> finished;
 
-    // Translate/Center the global perspective view (observer)
-    glTranslated(-100, 0, 0);
+    // The jobs waiting for this one (guarded by lock)
+    mutex lock;
+    vector<shared_ptr<Job> > dependents;
+};
 
-    // Rotate the entire global perspective view (observer)
-    glRotated(30, 1, 0, 1);
+// A reference to a job (the job is freed once it has finished and nothing refers to it)
+typedef shared_ptr<Job> JobHandle;
 
-    glPushMatrix();
+// This struct is the deque of jobs of one worker thread
+struct WorkerQueue
+{
+    mutex lock;
+    deque<JobHandle> jobs;
+};
 
-    // Draw the ground
-    glBegin(GL_POLYGON);
+// This struct holds the state shared by the worker threads
+struct JobSystem
+{
+    // The deques of the worker threads
+    vector<unique_ptr<WorkerQueue> > queues;
 
-    // Set the color to green
-    glColor3f(0.0, 1.0, 0.0);
+    // The number of runnable jobs waiting in all deques, and the number of parked workers
+    atomic<int> queuedJobs;
+    atomic<int> parkedWorkers;
 
-    // To simulate the rockjet moving forwards without moving the entire perspective, move the ground backwards
-    double height = -200 - v_pos;
+    // Parked workers wait here for new jobs
+    mutex parkLock;
+    condition_variable parkSignal;
+
+    // The deque that jobs submitted from outside the pool go to next (spreads them over the workers)
+    atomic<unsigned> nextQueue;
+};
 
-    // Draw the ground plane at the new vertical position
-    glVertex3d(10000, height, 10000);
-    glVertex3d(-10000, height, 10000);
-    glVertex3d(-10000, height, -10000);
-    glVertex3d(10000, height, -10000);
+// The job system. It is never destroyed: the workers are detached and may still be parked on it while the program exits
+JobSystem &jobSystem = *new JobSystem();
 
-    glEnd();
+// The index of the current thread's deque (-1 on threads that are not workers)
+thread_local int workerIndex = -1;
 
-    glPopMatrix();
+// This void method puts a runnable job on a deque (the current worker's own, or the next one in turn when called from outside the pool) and wakes a parked worker
+void enqueueJob (const JobHandle &job) {
+
+    int index = workerIndex >= 0 ? workerIndex : (int) (jobSystem.nextQueue.fetch_add(1, memory_order_relaxed) % jobSystem.queues.size());
 
-    // Draw each of the different components in the current assembly
-    for (int i=0; i<assembly.components.size(); i++)
     {
+        lock_guard<mutex> guard(jobSystem.queues[index]->lock);
+        jobSystem.queues[index]->jobs.push_back(job);
+    }
 
-        // Get the current obect to be drawn
-        vector<Object> obj = assembly.components[i];
+    jobSystem.queuedJobs.fetch_add(1);
 
-        glPushMatrix();
+    // Taking the park lock orders the wake-up after a worker's last check for jobs, so it cannot be missed
+    if (jobSystem.parkedWorkers.load() > 0) {
+        lock_guard<mutex> guard(jobSystem.parkLock);
+        jobSystem.parkSignal.notify_one();
+    }
 
-        // Initialize the matrix modelview mode for glDraw display
-        glMatrixMode(GL_MODELVIEW);
+}
 
-        // Setr rocket color to blue
-        glColor3d(0, 0, 1);
+// This method takes a runnable job: the newest one from the given deque first, otherwise the oldest one from any other deque. Returns an empty handle if there is none
+JobHandle takeJob (int ownIndex) {
 
-        // Draw the rocket
-        drawObject(obj, 550, 0, -300);
+    int count = jobSystem.queues.size();
 
-        glPopMatrix();
+    if (jobSystem.queuedJobs.load(memory_order_relaxed) == 0) {
+        return JobHandle();
+    }
+
+    if (ownIndex >= 0) {
+
+        WorkerQueue &own = *jobSystem.queues[ownIndex];
+        lock_guard<mutex> guard(own.lock);
+
+        if (!own.jobs.empty()) {
+            JobHandle job = own.jobs.back();
+            own.jobs.pop_back();
+            jobSystem.queuedJobs.fetch_sub(1);
+            return job;
+        }
+
+    }
+
+    // Steal, starting after our own deque so that thieves spread out
+    for (int i=1; i<=count; i++) {
+
+        WorkerQueue &victim = *jobSystem.queues[(max(ownIndex, 0) + i) % count];
+        lock_guard<mutex> guard(victim.lock);
+
+        if (!victim.jobs.empty()) {
+            JobHandle job = victim.jobs.front();
+            victim.jobs.pop_front();
+            jobSystem.queuedJobs.fetch_sub(1);
+            return job;
+        }
 
     }
+
+    return JobHandle();
+
 }
 
-// This void method clears the entire workspace and assembly
-void launchNewWorkspace () {
+// This void method runs a job and then releases the jobs that were waiting for it
+void executeJob (const JobHandle &job) {
+
+    job->work();
+
+    vector<JobHandle> dependents;
 
-    // Delete everything in the workspace
-    workspace.erase(workspace.begin(), workspace.end());
+    {
+        lock_guard<mutex> guard(job->lock);
+        job->finished.store(true, memory_order_release);
+        dependents.swap(job->dependents);
+    }
 
-    // Delete everything in the assembly
-    assembly.components.erase(assembly.components.begin(), assembly.components.end());
+    for (const JobHandle &dependent : dependents) {
+        if (dependent->pending.fetch_sub(1) == 1) {
+            enqueueJob(dependent);
+        }
+    }
 
 }
 
-// This is the default display method called by redraws. It contains code to distinguish the current stage of the game and draw the appropriate screen
-void display(void) {
+// This void method is the loop of one worker thread: run jobs while there are any, park while there are none
+void runWorker (int index) {
 
-    // Clear the current color and depth buffer
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    workerIndex = index;
 
-    // Draw the appropriate "stage" of the game depending on the user response
-    switch (stage) {
+    while (true) {
 
-        // Stage 0: intro screen
-        case 0:
+        JobHandle job = takeJob(index);
 
-            // Scale the creen for the specific screen
-            glLoadIdentity();
-            glOrtho(0, 1000, 0, 1000, -1200, 1200);
+        if (job) {
+            executeJob(job);
+            continue;
+        }
 
-            // Draw the intro screen
-            drawIntroScreen();
-            break;
+        unique_lock<mutex> guard(jobSystem.parkLock);
 
-        // Stage 1: rocket assembly screen
-        case 1:
+        jobSystem.parkedWorkers.fetch_add(1);
+        jobSystem.parkSignal.wait(guard, []() { return jobSystem.queuedJobs.load() > 0; });
+        jobSystem.parkedWorkers.fetch_sub(1);
 
-            // Scale the creen for the specific screen
-            glLoadIdentity();
-            glOrtho(0, 1000, 0, 1000, -1200, 1200);
+    }
+
+}
+
+// This void method starts the worker threads (one per core, leaving one for the render thread)
+void startJobSystem () {
+
+    jobSystem.queuedJobs.store(0);
+    jobSystem.parkedWorkers.store(0);
+    jobSystem.nextQueue.store(0);
+
+    int count = (int) thread::hardware_concurrency() - 1;
+
+    if (count < 1) {
+        count = 1;
+    }
+
+    for (int i=0; i<count; i++) {
+        jobSystem.queues.push_back(unique_ptr<WorkerQueue>(new WorkerQueue()));
+    }
+
+    for (int i=0; i<count; i++) {
+        thread(runWorker, i).detach();
+    }
+
+}
+
+// This method creates a job that has not been submitted yet (so that dependencies can still be added)
+JobHandle createJob (function<void()> work) {
+
+    JobHandle job = make_shared<Job>();
+    job->work = work;
+    job->pending.store(1);
+    job->finished.store(false);
+
+    return job;
+
+}
+
+// This void method makes after wait for before to finish. after must not have been submitted yet
+void addJobDependency (const JobHandle &before, const JobHandle &after) {
+
+    lock_guard<mutex> guard(before->lock);
+
+    if (!before->finished.load(memory_order_acquire)) {
+        after->pending.fetch_add(1);
+        before->dependents.push_back(after);
+    }
+
+}
+
+// This void method submits a job. It runs as soon as every job it depends on has finished
+void submitJob (const JobHandle &job) {
+
+    if (job->pending.fetch_sub(1) == 1) {
+        enqueueJob(job);
+    }
+
+}
+
+// This method creates and submits a job in one go
+JobHandle runJob (function<void()> work) {
+
+    JobHandle job = createJob(work);
+    submitJob(job);
+
+    return job;
+
+}
+
+// This void method waits for a job to finish. A pool thread runs other jobs in the meantime, so waiting from inside a job cannot starve the pool; any other thread (the render thread) just waits, so it never picks up somebody else's long job
+void waitForJob (const JobHandle &job) {
+
+    while (!job->finished.load(memory_order_acquire)) {
+
+        JobHandle other = workerIndex >= 0 ? takeJob(workerIndex) : JobHandle();
+
+        if (other) {
+            executeJob(other);
+        } else {
+            this_thread::yield();
+        }
+
+    }
+
+}
+
+// This void method runs body(first, last) over the range begin to end in chunks of about grain indices, spread over the pool, and returns when every chunk is done. The chunks are handed out through a shared counter, so a chunk costs one atomic increment and fine-grained chunks stay cheap, and a second counter tells when they have all finished. The calling thread works on the range too, but on nothing else: while the last chunks finish on other threads it only waits, so a frame calling this never ends up running an unrelated background job (a terrain tile or a whole mesh load), and helper jobs that start after every chunk has been taken are not waited for
+void parallelFor (int begin, int end, int grain, function<void(int, int)> body) {
+
+    if (end <= begin) {
+        return;
+    }
+
+    grain = max(grain, 1);
+
+    int chunks = (end - begin + grain - 1) / grain;
+
+    // A single chunk is not worth a job
+    if (chunks == 1) {
+        body(begin, end);
+        return;
+    }
+
+    shared_ptr<atomic<int> > nextChunk = make_shared<atomic<int> >(0);
+    shared_ptr<atomic<int> > doneChunks = make_shared<atomic<int> >(0);
+
+    // A helper that only starts once every chunk is taken returns without touching body (which may be gone by then)
+    function<void()> worker = [=]() {
+
+        for (int chunk = nextChunk->fetch_add(1); chunk < chunks; chunk = nextChunk->fetch_add(1)) {
+
+            int first = begin + chunk * grain;
+            body(first, min(first + grain, end));
+
+            doneChunks->fetch_add(1, memory_order_release);
+
+        }
+
+    };
+
+    // One job per worker at most (each one keeps taking chunks until there are none left)
+    int helpers = min(chunks - 1, (int) jobSystem.queues.size());
+
+    for (int i=0; i<helpers; i++) {
+        runJob(worker);
+    }
+
+    worker();
+
+    // Every chunk is taken; the ones still running are running on other threads
+    while (doneChunks->load(memory_order_acquire) < chunks) {
+        this_thread::yield();
+    }
+
+}
+
+// This struct is one task for the render thread
+struct MainThreadTask
+{
+    function<void()> work;
+    MainThreadTask *next;
+};
+
+// Lock-free stack of tasks for the render thread. Any thread pushes, the render thread takes the whole stack at once between frames
+atomic<MainThreadTask*> mainThreadTasks(nullptr);
+
+// This void method queues work to run on the render thread between frames (for anything that touches GL or the game state)
+void runOnMainThread (function<void()> work) {
+
+    MainThreadTask *task = new MainThreadTask();
+    task->work = work;
+    task->next = mainThreadTasks.load(memory_order_relaxed);
+
+    while (!mainThreadTasks.compare_exchange_weak(task->next, task, memory_order_release, memory_order_relaxed)) {
+    }
+
+}
+
+// This void method runs every queued render thread task, in the order they were queued. Called from the render thread only
+void runMainThreadTasks () {
+
+    // Take the entire stack (it is in reverse order of queueing)
+    MainThreadTask *head = mainThreadTasks.exchange(nullptr, memory_order_acquire);
+
+    vector<MainThreadTask*> tasks;
+
+    for (MainThreadTask *task = head; task != nullptr; task = task->next) {
+        tasks.push_back(task);
+    }
+
+    for (int i=tasks.size()-1; i>=0; i--) {
+        tasks[i]->work();
+        delete tasks[i];
+    }
+
+}
+
+// Aerodynamics - the drag area of the rocket comes from the shapes of its parts. Every component's silhouette along the flight axis is rasterized once, when its mesh first loads, and kept with the component in the mesh cache. The rocket's drag area is that of all its parts' silhouettes laid over each other, where each cell takes the drag of the part highest up over it, so a part tucked in behind a wider one adds no drag
+
+// The size of a silhouette cell in model units, and the most cells along either side of one silhouette (larger components get coarser cells)
+const double silhouetteCellSize = 1;
+const int maxSilhouetteCells = 256;
+
+// The drag coefficient of a face square to the flow, and of a face along it (skin friction and the wake behind the part). A sloped face gets the difference times the square of the sine of its slope, as in Newton's impact theory of drag
+const double bluntDragCoefficient = 1.2;
+const double sleekDragCoefficient = 0.15;
+
+// The physics drag area of one square model unit (a blunt part about 100 units across comes out close to the fixed 0.05 every part was given before)
+const double dragAreaScale = 5e-6;
+
+// This method rasterizes the silhouette of a component mesh along the flight axis. The rows of the grid are spread over the job system, and each triangle is drawn into every cell whose centre it covers, keeping the highest surface
+SilhouetteHandle buildSilhouette (const vector<Object> &objects) {
+
+    shared_ptr<Silhouette> silhouette = make_shared<Silhouette>();
+
+    // Gather the corners of every triangle (three per triangle), and their bounds seen from above
+    vector<Point3D> corners;
+
+    double minX = numeric_limits<double>::max();
+    double maxX = -numeric_limits<double>::max();
+    double minZ = numeric_limits<double>::max();
+    double maxZ = -numeric_limits<double>::max();
+
+    for (const Object &obj : objects) {
+        for (int index : obj.triangles) {
+
+            const Point3D &p = obj.vertices[index];
+
+            corners.push_back(p);
+
+            minX = min(minX, p.x);
+            maxX = max(maxX, p.x);
+            minZ = min(minZ, p.z);
+            maxZ = max(maxZ, p.z);
+
+        }
+    }
+
+    silhouette->frontalArea = 0;
+    silhouette->dragArea = 0;
+
+    if (corners.empty()) {
+        silhouette->minX = 0;
+        silhouette->minZ = 0;
+        silhouette->cellSize = silhouetteCellSize;
+        silhouette->columns = 0;
+        silhouette->rows = 0;
+        return silhouette;
+    }
+
+    double cellSize = max(silhouetteCellSize, max(maxX - minX, maxZ - minZ) / maxSilhouetteCells);
+
+    int columns = max(1, (int) ceil((maxX - minX) / cellSize));
+    int rows = max(1, (int) ceil((maxZ - minZ) / cellSize));
+
+    silhouette->minX = minX;
+    silhouette->minZ = minZ;
+    silhouette->cellSize = cellSize;
+    silhouette->columns = columns;
+    silhouette->rows = rows;
+    silhouette->top.assign(columns * rows, -numeric_limits<float>::infinity());
+    silhouette->coefficient.assign(columns * rows, 0);
+
+    vector<float> &top = silhouette->top;
+    vector<float> &coefficient = silhouette->coefficient;
+
+    // Each chunk owns a band of rows, so no two chunks write the same cell
+    parallelFor(0, rows, 16, [&](int first, int last) {
+
+        double low = minZ + first * cellSize;
+        double high = minZ + last * cellSize;
+
+        for (size_t t=0; t<corners.size(); t+=3) {
+
+            const Point3D &a = corners[t];
+            const Point3D &b = corners[t+1];
+            const Point3D &c = corners[t+2];
+
+            if (max(a.z, max(b.z, c.z)) < low || min(a.z, min(b.z, c.z)) > high) {
+                continue;
+            }
+
+            // Twice the area of the triangle seen from above (signed). Faces along the flight axis cover nothing
+            double area = (b.x - a.x) * (c.z - a.z) - (c.x - a.x) * (b.z - a.z);
+
+            if (fabs(area) < 1e-12) {
+                continue;
+            }
+
+            // The face normal (only its length is needed, its Y part is the area seen from above)
+            double nx = (b.y - a.y) * (c.z - a.z) - (b.z - a.z) * (c.y - a.y);
+            double nz = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+
+            double slope = area * area / (area * area + nx * nx + nz * nz);
+            float faceCoefficient = sleekDragCoefficient + (bluntDragCoefficient - sleekDragCoefficient) * slope;
+
+            // The cells whose centres fall inside the triangle's bounds
+            int firstColumn = max(0, (int) ceil((min(a.x, min(b.x, c.x)) - minX) / cellSize - 0.5));
+            int lastColumn = min(columns - 1, (int) floor((max(a.x, max(b.x, c.x)) - minX) / cellSize - 0.5));
+            int firstRow = max(first, (int) ceil((min(a.z, min(b.z, c.z)) - minZ) / cellSize - 0.5));
+            int lastRow = min(last - 1, (int) floor((max(a.z, max(b.z, c.z)) - minZ) / cellSize - 0.5));
+
+            for (int row=firstRow; row<=lastRow; row++) {
+
+                double pz = minZ + (row + 0.5) * cellSize;
+
+                for (int column=firstColumn; column<=lastColumn; column++) {
+
+                    double px = minX + (column + 0.5) * cellSize;
+
+                    // Barycentric weights of the cell centre (slightly inclusive, so that no cell falls through the crack between two triangles)
+                    double wa = ((b.x - px) * (c.z - pz) - (c.x - px) * (b.z - pz)) / area;
+                    double wb = ((px - a.x) * (c.z - a.z) - (c.x - a.x) * (pz - a.z)) / area;
+                    double wc = 1 - wa - wb;
+
+                    if (wa < -1e-9 || wb < -1e-9 || wc < -1e-9) {
+                        continue;
+                    }
+
+                    float height = wa * a.y + wb * b.y + wc * c.y;
+                    int cell = row * columns + column;
+
+                    if (height > top[cell]) {
+                        top[cell] = height;
+                        coefficient[cell] = faceCoefficient;
+                    }
+
+                }
+
+            }
+
+        }
+
+    });
+
+    for (size_t cell=0; cell<top.size(); cell++) {
+        if (top[cell] > -numeric_limits<float>::infinity()) {
+            silhouette->frontalArea += cellSize * cellSize;
+            silhouette->dragArea += coefficient[cell] * cellSize * cellSize;
+        }
+    }
+
+    return silhouette;
+
+}
+
+// This method returns the drag area of parts first to last - 1, in physics units, reading only their shapes and transforms. Their silhouettes are laid over each other at the parts' offsets (on a grid as coarse as the coarsest one), and each cell takes the drag coefficient of the part highest up over it
+double getDragArea (const PartWorld &world, int first, int last) {
+
+    // The silhouette and offset of every part that has one
+    vector<const Silhouette*> shaped;
+    vector<Point3D> offsets;
+
+    double cellSize = 0;
+
+    double minX = numeric_limits<double>::max();
+    double maxX = -numeric_limits<double>::max();
+    double minZ = numeric_limits<double>::max();
+    double maxZ = -numeric_limits<double>::max();
+
+    for (int run=first; run<last; run=getRunEnd(run, last)) {
+
+        const PartShape *shapes = world.shapes.getRun(run);
+        const Point3D *transforms = world.transforms.getRun(run);
+
+        for (int k=0; k<getRunEnd(run, last)-run; k++) {
+
+            if (!shapes[k].silhouette || shapes[k].silhouette->columns == 0) {
+                continue;
+            }
+
+            const Silhouette &s = *shapes[k].silhouette;
+            const Point3D &offset = transforms[k];
+
+            shaped.push_back(&s);
+            offsets.push_back(offset);
+            cellSize = max(cellSize, s.cellSize);
+
+            minX = min(minX, offset.x + s.minX);
+            maxX = max(maxX, offset.x + s.minX + s.columns * s.cellSize);
+            minZ = min(minZ, offset.z + s.minZ);
+            maxZ = max(maxZ, offset.z + s.minZ + s.rows * s.cellSize);
+
+        }
+
+    }
+
+    if (shaped.empty()) {
+        return 0;
+    }
+
+    int columns = max(1, (int) ceil((maxX - minX) / cellSize));
+    int rows = max(1, (int) ceil((maxZ - minZ) / cellSize));
+
+    // The sum of the drag coefficients of every row (one slot per row, so the chunks never share one)
+    vector<double> rowDrag(rows, 0);
+
+    parallelFor(0, rows, 16, [&](int first, int last) {
+
+        for (int row=first; row<last; row++) {
+
+            double z = minZ + (row + 0.5) * cellSize;
+
+            for (int column=0; column<columns; column++) {
+
+                double x = minX + (column + 0.5) * cellSize;
+
+                double front = -numeric_limits<double>::infinity();
+                double drag = 0;
+
+                for (int p=0; p<(int) shaped.size(); p++) {
+
+                    const Silhouette &s = *shaped[p];
+                    const Point3D &offset = offsets[p];
+
+                    int partColumn = (int) floor((x - offset.x - s.minX) / s.cellSize);
+                    int partRow = (int) floor((z - offset.z - s.minZ) / s.cellSize);
+
+                    if (partColumn < 0 || partColumn >= s.columns || partRow < 0 || partRow >= s.rows) {
+                        continue;
+                    }
+
+                    int cell = partRow * s.columns + partColumn;
+                    double height = s.top[cell] + offset.y;
+
+                    if (height > front) {
+                        front = height;
+                        drag = s.coefficient[cell];
+                    }
+
+                }
+
+                rowDrag[row] += drag;
+
+            }
+
+        }
+
+    });
+
+    double dragArea = 0;
+
+    for (double drag : rowDrag) {
+        dragArea += drag;
+    }
+
+    return dragArea * cellSize * cellSize * dragAreaScale;
+
+}
+
+// Mass properties - the volume, centre of mass and inertia tensor of a closed mesh come from sums over its triangles (the divergence theorem turns the integrals over the solid into integrals over its surface). Each triangle and the origin make a tetrahedron whose signed volume and moments have closed forms, and adding them up over the whole surface leaves those of the solid. The sums run over batches of triangles in parallel, two triangles at a time with SSE2, and are kept per component like the silhouette. The assembly's mass properties are built up one part at a time with the parallel axis theorem as the parts are assembled
+
+// The number of moment sums: the volume, the three first moments (x, y, z), the three second moments (xx, yy, zz) and the three products (xy, yz, zx)
+const int massMomentCount = 10;
+
+// The number of triangles in one batch of the moment sums (even, so that the SSE2 pairs never straddle two batches)
+const int massBatchSize = 4096;
+
+// This void method adds the moment sums of triangles first to last to sums. corners holds the nine coordinates of each of count triangles as nine arrays one after another (the x of every first corner, then the y of every first corner, and so on), so that two triangles load at once. The sums are left unscaled: the volume is the first one over 6, the first moments are over 24 and the second moments and products over 120
+void sumMassMoments (const double *corners, int count, int first, int last, double *sums) {
+
+    const double *ax = corners;
+    const double *ay = corners + count;
+    const double *az = corners + count * 2;
+    const double *bx = corners + count * 3;
+    const double *by = corners + count * 4;
+    const double *bz = corners + count * 5;
+    const double *cx = corners + count * 6;
+    const double *cy = corners + count * 7;
+    const double *cz = corners + count * 8;
+
+    int i = first;
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    __m128d total[massMomentCount];
+
+    for (int k=0; k<massMomentCount; k++) {
+        total[k] = _mm_setzero_pd();
+    }
+
+    for (; i + 2 <= last; i += 2) {
+
+        __m128d x0 = _mm_loadu_pd(&ax[i]), y0 = _mm_loadu_pd(&ay[i]), z0 = _mm_loadu_pd(&az[i]);
+        __m128d x1 = _mm_loadu_pd(&bx[i]), y1 = _mm_loadu_pd(&by[i]), z1 = _mm_loadu_pd(&bz[i]);
+        __m128d x2 = _mm_loadu_pd(&cx[i]), y2 = _mm_loadu_pd(&cy[i]), z2 = _mm_loadu_pd(&cz[i]);
+
+        // Six times the signed volume of the tetrahedron of the origin and the triangle
+        __m128d det = _mm_add_pd(_mm_add_pd(
+            _mm_mul_pd(x0, _mm_sub_pd(_mm_mul_pd(y1, z2), _mm_mul_pd(z1, y2))),
+            _mm_mul_pd(y0, _mm_sub_pd(_mm_mul_pd(z1, x2), _mm_mul_pd(x1, z2)))),
+            _mm_mul_pd(z0, _mm_sub_pd(_mm_mul_pd(x1, y2), _mm_mul_pd(y1, x2))));
+
+        __m128d sx = _mm_add_pd(_mm_add_pd(x0, x1), x2);
+        __m128d sy = _mm_add_pd(_mm_add_pd(y0, y1), y2);
+        __m128d sz = _mm_add_pd(_mm_add_pd(z0, z1), z2);
+
+        __m128d xx = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(x0, x0), _mm_mul_pd(x1, x1)), _mm_mul_pd(x2, x2)), _mm_mul_pd(sx, sx));
+        __m128d yy = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(y0, y0), _mm_mul_pd(y1, y1)), _mm_mul_pd(y2, y2)), _mm_mul_pd(sy, sy));
+        __m128d zz = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(z0, z0), _mm_mul_pd(z1, z1)), _mm_mul_pd(z2, z2)), _mm_mul_pd(sz, sz));
+        __m128d xy = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(x0, y0), _mm_mul_pd(x1, y1)), _mm_mul_pd(x2, y2)), _mm_mul_pd(sx, sy));
+        __m128d yz = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(y0, z0), _mm_mul_pd(y1, z1)), _mm_mul_pd(y2, z2)), _mm_mul_pd(sy, sz));
+        __m128d zx = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(z0, x0), _mm_mul_pd(z1, x1)), _mm_mul_pd(z2, x2)), _mm_mul_pd(sz, sx));
+
+        total[0] = _mm_add_pd(total[0], det);
+        total[1] = _mm_add_pd(total[1], _mm_mul_pd(det, sx));
+        total[2] = _mm_add_pd(total[2], _mm_mul_pd(det, sy));
+        total[3] = _mm_add_pd(total[3], _mm_mul_pd(det, sz));
+        total[4] = _mm_add_pd(total[4], _mm_mul_pd(det, xx));
+        total[5] = _mm_add_pd(total[5], _mm_mul_pd(det, yy));
+        total[6] = _mm_add_pd(total[6], _mm_mul_pd(det, zz));
+        total[7] = _mm_add_pd(total[7], _mm_mul_pd(det, xy));
+        total[8] = _mm_add_pd(total[8], _mm_mul_pd(det, yz));
+        total[9] = _mm_add_pd(total[9], _mm_mul_pd(det, zx));
+
+    }
+
+    // Add the two halves of every sum
+    for (int k=0; k<massMomentCount; k++) {
+
+        double pair[2];
+        _mm_storeu_pd(pair, total[k]);
+
+        sums[k] += pair[0] + pair[1];
+
+    }
+#endif
+
+    // The same, one triangle at a time (the triangle left over, or everything without SSE2)
+    for (; i < last; i++) {
+
+        double det = ax[i] * (by[i] * cz[i] - bz[i] * cy[i]) + ay[i] * (bz[i] * cx[i] - bx[i] * cz[i]) + az[i] * (bx[i] * cy[i] - by[i] * cx[i]);
+
+        double sx = ax[i] + bx[i] + cx[i];
+        double sy = ay[i] + by[i] + cy[i];
+        double sz = az[i] + bz[i] + cz[i];
+
+        sums[0] += det;
+        sums[1] += det * sx;
+        sums[2] += det * sy;
+        sums[3] += det * sz;
+        sums[4] += det * (ax[i] * ax[i] + bx[i] * bx[i] + cx[i] * cx[i] + sx * sx);
+        sums[5] += det * (ay[i] * ay[i] + by[i] * by[i] + cy[i] * cy[i] + sy * sy);
+        sums[6] += det * (az[i] * az[i] + bz[i] * bz[i] + cz[i] * cz[i] + sz * sz);
+        sums[7] += det * (ax[i] * ay[i] + bx[i] * by[i] + cx[i] * cy[i] + sx * sy);
+        sums[8] += det * (ay[i] * az[i] + by[i] * bz[i] + cy[i] * cz[i] + sy * sz);
+        sums[9] += det * (az[i] * ax[i] + bz[i] * bx[i] + cz[i] * cx[i] + sz * sx);
+
+    }
+
+}
+
+// This void method adds the inertia of a point mass at offset d to inertia (the parallel axis theorem: moving a body's inertia from its centre of mass to a point d away adds that of its mass at d). A negative mass moves it the other way
+void addParallelAxis (double *inertia, double mass, Point3D d) {
+
+    inertia[0] += mass * (d.y * d.y + d.z * d.z);
+    inertia[1] += mass * (d.x * d.x + d.z * d.z);
+    inertia[2] += mass * (d.x * d.x + d.y * d.y);
+    inertia[3] -= mass * d.x * d.y;
+    inertia[4] -= mass * d.y * d.z;
+    inertia[5] -= mass * d.z * d.x;
+
+}
+
+// This struct is one edge of a triangle, for matching the triangles on either side of it: its two vertices (numbered across all objects) as one key, the smaller first, and whether the triangle runs along it from the smaller to the larger
+struct WindingEdge
+{
+    uint64_t key;
+    int triangle;
+    bool forward;
+
+    bool operator< (const WindingEdge &other) const {
+        return key < other.key;
+    }
+};
+
+// This method works out which triangles of a mesh to turn round so that every connected piece of it winds outwards. Two triangles on either side of an edge wind the same way if they run along it in opposite directions, so starting from any triangle of a piece, the winding spreads to the rest across shared edges; the piece is then turned inside out if it encloses a negative volume. Each piece is taken to be solid on its own. Returns one flag per triangle, in the order the objects list them
+vector<char> getOutwardWinding (const vector<Object> &objects) {
+
+    vector<WindingEdge> edges;
+    vector<Point3D> corners;
+
+    uint64_t vertexBase = 0;
+
+    for (const Object &obj : objects) {
+
+        for (size_t i=0; i+2<obj.triangles.size(); i+=3) {
+            for (int k=0; k<3; k++) {
+
+                uint64_t a = vertexBase + obj.triangles[i + k];
+                uint64_t b = vertexBase + obj.triangles[i + (k + 1) % 3];
+
+                WindingEdge edge;
+                edge.key = min(a, b) << 32 | max(a, b);
+                edge.triangle = corners.size() / 3;
+                edge.forward = a < b;
+                edges.push_back(edge);
+
+            }
+
+            for (int k=0; k<3; k++) {
+                corners.push_back(obj.vertices[obj.triangles[i + k]]);
+            }
+        }
+
+        vertexBase += obj.vertices.size();
+
+    }
+
+    int count = corners.size() / 3;
+
+    // Triangle t's edges are edges[t * 3 ...] before sorting: remember where each one goes, and where each run of the same edge starts and ends
+    vector<int> order(edges.size());
+
+    for (size_t e=0; e<edges.size(); e++) {
+        order[e] = e;
+    }
+
+    stable_sort(order.begin(), order.end(), [&edges](int a, int b) {
+        return edges[a] < edges[b];
+    });
+
+    vector<int> slot(edges.size()), runStart(edges.size()), runEnd(edges.size());
+
+    for (size_t e=0; e<order.size(); e++) {
+        slot[order[e]] = e;
+        runStart[e] = e > 0 && edges[order[e - 1]].key == edges[order[e]].key ? runStart[e - 1] : e;
+    }
+
+    for (size_t e=order.size(); e-- > 0; ) {
+        runEnd[e] = e + 1 < order.size() && edges[order[e + 1]].key == edges[order[e]].key ? runEnd[e + 1] : e + 1;
+    }
+
+    vector<char> flipped(count, 0);
+    vector<char> visited(count, 0);
+    vector<int> piece;
+
+    for (int first=0; first<count; first++) {
+
+        if (visited[first]) {
+            continue;
+        }
+
+        // Spread the winding of the first triangle over its piece, adding up the volume it encloses on the way
+        piece.clear();
+        piece.push_back(first);
+        visited[first] = 1;
+
+        double volume = 0;
+
+        for (size_t next=0; next<piece.size(); next++) {
+
+            int t = piece[next];
+
+            const Point3D &a = corners[t * 3];
+            const Point3D &b = corners[t * 3 + 1];
+            const Point3D &c = corners[t * 3 + 2];
+
+            double det = dotMultiplyP3D(a, crossMultiplyP3D(b, c));
+            volume += flipped[t] ? -det : det;
+
+            for (int k=0; k<3; k++) {
+
+                int own = slot[t * 3 + k];
+
+                for (int e=runStart[own]; e<runEnd[own]; e++) {
+
+                    const WindingEdge &other = edges[order[e]];
+
+                    if (visited[other.triangle]) {
+                        continue;
+                    }
+
+                    // Running along the edge the same way as this triangle means winding the other way round
+                    visited[other.triangle] = 1;
+                    flipped[other.triangle] = flipped[t] ^ (other.forward == edges[t * 3 + k].forward);
+                    piece.push_back(other.triangle);
+
+                }
+
+            }
+
+        }
+
+        if (volume < 0) {
+            for (int t : piece) {
+                flipped[t] ^= 1;
+            }
+        }
+
+    }
+
+    return flipped;
+
+}
+
+// This method returns the mass properties of a component mesh filled with a density of 1. The mesh should be closed; its faces may wind either way round, even mixed within one piece (see getOutwardWinding). A mesh that encloses no volume (a flat or open one) is taken to be a solid box filling its bounds
+MassPropertiesHandle buildMassProperties (const vector<Object> &objects) {
+
+    int count = 0;
+
+    for (const Object &obj : objects) {
+        count += obj.triangles.size() / 3;
+    }
+
+    vector<char> flipped = getOutwardWinding(objects);
+
+    // Lay the corners out as nine arrays (with the triangles that wind inwards turned round), and find the bounds on the way
+    vector<double> corners(count * 9);
+
+    Point3D low = {numeric_limits<double>::max(), numeric_limits<double>::max(), numeric_limits<double>::max()};
+    Point3D high = {-numeric_limits<double>::max(), -numeric_limits<double>::max(), -numeric_limits<double>::max()};
+
+    int t = 0;
+
+    for (const Object &obj : objects) {
+        for (size_t i=0; i+2<obj.triangles.size(); i+=3, t++) {
+            for (int k=0; k<3; k++) {
+
+                const Point3D &p = obj.vertices[obj.triangles[i + (flipped[t] && k > 0 ? 3 - k : k)]];
+
+                corners[count * (k*3) + t] = p.x;
+                corners[count * (k*3+1) + t] = p.y;
+                corners[count * (k*3+2) + t] = p.z;
+
+                low = Point3D{min(low.x, p.x), min(low.y, p.y), min(low.z, p.z)};
+                high = Point3D{max(high.x, p.x), max(high.y, p.y), max(high.z, p.z)};
+
+            }
+        }
+    }
+
+    // One set of sums per batch, added up in batch order afterwards so the result does not depend on which worker took which batch
+    int batches = (count + massBatchSize - 1) / massBatchSize;
+    vector<double> partial(batches * massMomentCount, 0.0);
+
+    parallelFor(0, count, massBatchSize, [&](int first, int last) {
+        sumMassMoments(corners.data(), count, first, last, &partial[(first / massBatchSize) * massMomentCount]);
+    });
+
+    double sums[massMomentCount] = {0};
+
+    for (int b=0; b<batches; b++) {
+        for (int k=0; k<massMomentCount; k++) {
+            sums[k] += partial[b * massMomentCount + k];
+        }
+    }
+
+    shared_ptr<MassProperties> shape = make_shared<MassProperties>();
+
+    double volume = sums[0] / 6;
+    Point3D size = count > 0 ? subtractP3D(high, low) : Point3D{0, 0, 0};
+    double boxVolume = size.x * size.y * size.z;
+
+    if (count == 0 || volume <= boxVolume * 1e-9) {
+
+        shape->mass = boxVolume;
+        shape->centre = count > 0 ? Point3D{(low.x + high.x) / 2, (low.y + high.y) / 2, (low.z + high.z) / 2} : Point3D{0, 0, 0};
+
+        shape->inertia[0] = boxVolume * (size.y * size.y + size.z * size.z) / 12;
+        shape->inertia[1] = boxVolume * (size.x * size.x + size.z * size.z) / 12;
+        shape->inertia[2] = boxVolume * (size.x * size.x + size.y * size.y) / 12;
+        shape->inertia[3] = 0;
+        shape->inertia[4] = 0;
+        shape->inertia[5] = 0;
+
+        return shape;
+
+    }
+
+    shape->mass = volume;
+    shape->centre = Point3D{sums[1] / 24 / volume, sums[2] / 24 / volume, sums[3] / 24 / volume};
+
+    // The inertia about the origin...
+    double xx = sums[4] / 120;
+    double yy = sums[5] / 120;
+    double zz = sums[6] / 120;
+
+    shape->inertia[0] = yy + zz;
+    shape->inertia[1] = xx + zz;
+    shape->inertia[2] = xx + yy;
+    shape->inertia[3] = -sums[7] / 120;
+    shape->inertia[4] = -sums[8] / 120;
+    shape->inertia[5] = -sums[9] / 120;
+
+    // ...moved to the centre of mass
+    addParallelAxis(shape->inertia, -volume, shape->centre);
+
+    return shape;
+
+}
+
+// This method returns the mass properties of a part: its component's shape scaled to the part's mass, at the part's offset. A part without a known shape counts as a point mass at its offset
+MassProperties getPartMass (const PartPhysics &physics, const PartShape &shape, const Point3D &offset) {
+
+    MassProperties body = MassProperties();
+    body.mass = physics.mass;
+    body.centre = offset;
+
+    if (shape.mass && shape.mass->mass > 0) {
+
+        double density = physics.mass / shape.mass->mass;
+
+        body.centre.x += shape.mass->centre.x;
+        body.centre.y += shape.mass->centre.y;
+        body.centre.z += shape.mass->centre.z;
+
+        for (int k=0; k<6; k++) {
+            body.inertia[k] = shape.mass->inertia[k] * density;
+        }
+
+    }
+
+    return body;
+
+}
+
+// This void method adds a body to total: the masses add up, the centre of mass is their weighted average, and both inertia tensors are moved to the new centre of mass with the parallel axis theorem
+void addMass (MassProperties &total, const MassProperties &body) {
+
+    double mass = total.mass + body.mass;
+
+    if (mass <= 0) {
+        return;
+    }
+
+    Point3D centre;
+    centre.x = (total.centre.x * total.mass + body.centre.x * body.mass) / mass;
+    centre.y = (total.centre.y * total.mass + body.centre.y * body.mass) / mass;
+    centre.z = (total.centre.z * total.mass + body.centre.z * body.mass) / mass;
+
+    addParallelAxis(total.inertia, total.mass, subtractP3D(total.centre, centre));
+
+    for (int k=0; k<6; k++) {
+        total.inertia[k] += body.inertia[k];
+    }
+
+    addParallelAxis(total.inertia, body.mass, subtractP3D(body.centre, centre));
+
+    total.mass = mass;
+    total.centre = centre;
+
+}
+
+// Collision proxies - every component gets a convex hull when its mesh first loads (quickhull), kept with the component like its silhouette, and the rocket's hull is built from the hulls of its parts. Contact tests go through GJK, which only ever asks a shape for its support point (its farthest point in a direction), so a test costs the same however detailed the meshes are
+
+// The most corners a convex hull keeps. Quickhull adds the farthest point left out first, so stopping early leaves a hull that misses the mesh by at most the distance of the farthest point not added
+const int maxHullVertices = 64;
+
+// This struct is one face of a convex hull while quickhull builds it: its corners, its outward plane, and the points outside it still to be added (with the farthest one)
+struct QuickhullFace
+{
+    int v[3];
+
+    Point3D normal;
+    double offset;
+
+    vector<int> outside;
+    int farthest;
+    double farthestDistance;
+
+    bool alive;
+};
+
+// This method returns a quickhull face through corners a, b and c of points, facing away from the point inside
+QuickhullFace makeQuickhullFace (const vector<Point3D> &points, int a, int b, int c, Point3D inside) {
+
+    QuickhullFace face;
+    face.v[0] = a;
+    face.v[1] = b;
+    face.v[2] = c;
+    face.normal = normalize(crossMultiplyP3D(subtractP3D(points[b], points[a]), subtractP3D(points[c], points[a])));
+    face.offset = dotMultiplyP3D(face.normal, points[a]);
+    face.farthest = -1;
+    face.farthestDistance = 0;
+    face.alive = true;
+
+    if (dotMultiplyP3D(face.normal, inside) > face.offset) {
+        swap(face.v[1], face.v[2]);
+        face.normal = scaleP3D(face.normal, -1);
+        face.offset = -face.offset;
+    }
+
+    return face;
+
+}
+
+// This void method hands each of the given points to the first of faces first to last that it is outside of (by more than epsilon). Points inside all of them are inside the hull and are dropped
+void assignOutsidePoints (const vector<Point3D> &points, const vector<int> &candidates, vector<QuickhullFace> &faces, int first, int last, double epsilon) {
+
+    for (int index : candidates) {
+        for (int f=first; f<last; f++) {
+
+            QuickhullFace &face = faces[f];
+            double distance = dotMultiplyP3D(face.normal, points[index]) - face.offset;
+
+            if (distance > epsilon) {
+
+                face.outside.push_back(index);
+
+                if (distance > face.farthestDistance) {
+                    face.farthest = index;
+                    face.farthestDistance = distance;
+                }
+
+                break;
+
+            }
+
+        }
+    }
+
+}
+
+// This method returns the convex hull of a set of points, with quickhull: start from a tetrahedron of extreme points, then keep adding the point farthest outside the hull, replacing the faces it can see with a cone of faces from their outline to the point. Points that lie in a plane or on a line get the box around them instead
+HullHandle buildConvexHull (const vector<Point3D> &points) {
+
+    shared_ptr<ConvexHull> hull = make_shared<ConvexHull>();
+
+    hull->minX = hull->minY = hull->minZ = 0;
+    hull->maxX = hull->maxY = hull->maxZ = 0;
+
+    if (points.empty()) {
+        return hull;
+    }
+
+    // The extreme points along each axis (min x, max x, min y, ...)
+    int extremes[6] = {0, 0, 0, 0, 0, 0};
+
+    for (int i=0; i<(int) points.size(); i++) {
+
+        const Point3D &p = points[i];
+
+        if (p.x < points[extremes[0]].x) extremes[0] = i;
+        if (p.x > points[extremes[1]].x) extremes[1] = i;
+        if (p.y < points[extremes[2]].y) extremes[2] = i;
+        if (p.y > points[extremes[3]].y) extremes[3] = i;
+        if (p.z < points[extremes[4]].z) extremes[4] = i;
+        if (p.z > points[extremes[5]].z) extremes[5] = i;
+
+    }
+
+    Point3D low = {points[extremes[0]].x, points[extremes[2]].y, points[extremes[4]].z};
+    Point3D high = {points[extremes[1]].x, points[extremes[3]].y, points[extremes[5]].z};
+
+    double epsilon = max(getMagnitude(subtractP3D(high, low)), 1.0) * 1e-9;
+
+    // The first tetrahedron: the two extreme points farthest apart, the point farthest from the line through them, and the point farthest from the plane through all three
+    int a = extremes[0];
+    int b = extremes[1];
+
+    for (int i=0; i<6; i++) {
+        for (int j=i+1; j<6; j++) {
+            if (getMagnitude(subtractP3D(points[extremes[i]], points[extremes[j]])) > getMagnitude(subtractP3D(points[a], points[b]))) {
+                a = extremes[i];
+                b = extremes[j];
+            }
+        }
+    }
+
+    Point3D axis = subtractP3D(points[b], points[a]);
+
+    int c = a;
+    double lineDistance = 0;
+
+    for (int i=0; i<(int) points.size(); i++) {
+
+        double distance = getMagnitude(crossMultiplyP3D(axis, subtractP3D(points[i], points[a])));
+
+        if (distance > lineDistance) {
+            lineDistance = distance;
+            c = i;
+        }
+
+    }
+
+    int d = a;
+    double planeDistance = 0;
+
+    if (lineDistance > epsilon * getMagnitude(axis)) {
+
+        Point3D normal = normalize(crossMultiplyP3D(axis, subtractP3D(points[c], points[a])));
+
+        for (int i=0; i<(int) points.size(); i++) {
+
+            double distance = fabs(dotMultiplyP3D(normal, subtractP3D(points[i], points[a])));
+
+            if (distance > planeDistance) {
+                planeDistance = distance;
+                d = i;
+            }
+
+        }
+
+    }
+
+    if (planeDistance <= epsilon) {
+
+        // Flat: the box around the points (as thin as they are) stands in for the hull
+        for (int corner=0; corner<8; corner++) {
+            hull->vertices.push_back(Point3D{corner & 1 ? high.x : low.x, corner & 2 ? high.y : low.y, corner & 4 ? high.z : low.z});
+        }
+
+    } else {
+
+        Point3D inside = scaleP3D(addP3D(addP3D(points[a], points[b]), addP3D(points[c], points[d])), 0.25);
+
+        vector<QuickhullFace> faces;
+        faces.push_back(makeQuickhullFace(points, a, b, c, inside));
+        faces.push_back(makeQuickhullFace(points, a, b, d, inside));
+        faces.push_back(makeQuickhullFace(points, a, c, d, inside));
+        faces.push_back(makeQuickhullFace(points, b, c, d, inside));
+
+        vector<int> candidates;
+
+        for (int i=0; i<(int) points.size(); i++) {
+            if (i != a && i != b && i != c && i != d) {
+                candidates.push_back(i);
+            }
+        }
+
+        assignOutsidePoints(points, candidates, faces, 0, 4, epsilon);
+
+        for (int added=4; added<maxHullVertices; added++) {
+
+            // The point farthest outside any face
+            int eyeFace = -1;
+
+            for (int f=0; f<(int) faces.size(); f++) {
+                if (faces[f].alive && faces[f].farthest >= 0 && (eyeFace < 0 || faces[f].farthestDistance > faces[eyeFace].farthestDistance)) {
+                    eyeFace = f;
+                }
+            }
+
+            if (eyeFace < 0) {
+                break;
+            }
+
+            int eye = faces[eyeFace].farthest;
+
+            // Every face the point can see goes. Its outline (the edges of the visible faces that are not shared by two of them) is the horizon
+            set<pair<int, int> > visibleEdges;
+            candidates.clear();
+
+            for (QuickhullFace &face : faces) {
+
+                if (!face.alive || dotMultiplyP3D(face.normal, points[eye]) - face.offset <= epsilon) {
+                    continue;
+                }
+
+                face.alive = false;
+
+                for (int k=0; k<3; k++) {
+                    visibleEdges.insert(make_pair(face.v[k], face.v[(k+1)%3]));
+                }
+
+                for (int index : face.outside) {
+                    if (index != eye) {
+                        candidates.push_back(index);
+                    }
+                }
+
+                face.outside.clear();
+
+            }
+
+            // A cone of new faces from the horizon to the point, then the points outside the old faces are shared out among them
+            int firstNew = faces.size();
+
+            for (const pair<int, int> &edge : visibleEdges) {
+                if (visibleEdges.count(make_pair(edge.second, edge.first)) == 0) {
+                    faces.push_back(makeQuickhullFace(points, edge.first, edge.second, eye, inside));
+                }
+            }
+
+            assignOutsidePoints(points, candidates, faces, firstNew, faces.size(), epsilon);
+
+        }
+
+        // Keep the corners of the remaining faces, renumbered
+        map<int, int> corners;
+
+        for (const QuickhullFace &face : faces) {
+
+            if (!face.alive) {
+                continue;
+            }
+
+            for (int k=0; k<3; k++) {
+
+                if (corners.count(face.v[k]) == 0) {
+                    corners[face.v[k]] = hull->vertices.size();
+                    hull->vertices.push_back(points[face.v[k]]);
+                }
+
+                hull->faces.push_back(corners[face.v[k]]);
+
+            }
+
+        }
+
+    }
+
+    hull->minX = low.x;
+    hull->maxX = high.x;
+    hull->minY = low.y;
+    hull->maxY = high.y;
+    hull->minZ = low.z;
+    hull->maxZ = high.z;
+
+    return hull;
+
+}
+
+// This method returns the convex hull of a component mesh
+HullHandle buildMeshHull (const vector<Object> &objects) {
+
+    vector<Point3D> points;
+
+    for (const Object &obj : objects) {
+        points.insert(points.end(), obj.vertices.begin(), obj.vertices.end());
+    }
+
+    return buildConvexHull(points);
+
+}
+
+// Shared catalog - a catalog can be published once into shared memory (KSP --publish-catalog <name>) and used by any number of processes started with --shared-catalog <name>. They map the segment read-only instead of parsing and processing the models, so they start at once: the silhouettes, mass properties and convex hulls the flight needs were worked out by the publisher. The flight code reads those as vectors, so each process copies them out of the segment, but only once per component however many parts use it, and only when the component is first used; the game also copies a mesh out when it is drawn. The indices of a component are checked when it is first read, so attaching only reads the headers of the segment. While a shared catalog is attached it takes the place of the built-in catalog. The segment layout and the attach code are in sharedCatalog.h
+
+// The attached shared catalog (base is nullptr if none is)
+SharedCatalog sharedCatalog = SharedCatalog();
+
+// This method returns the shared memory name of a catalog (POSIX names start with a slash)
+string getSharedSegmentName (const string &name) {
+
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+
+}
+
+// This struct is what a process has taken from one component of the shared catalog: whether its indices have been checked (and were valid), and the one copy of its silhouette, mass properties and convex hull every part using it shares
+struct SharedComponentCopies
+{
+    bool checked;
+    bool valid;
+
+    SilhouetteHandle silhouette;
+    MassPropertiesHandle shape;
+    HullHandle hull;
+};
+
+// The copies taken from the components of the shared catalog (mesh loads run on the job system, so they are locked)
+vector<SharedComponentCopies> sharedCopies;
+mutex sharedCopiesLock;
+
+// This method returns the copies of component index of the shared catalog, checking its indices the first time (sharedCopiesLock must be held)
+SharedComponentCopies &getSharedCopies (int index) {
+
+    if (sharedCopies.size() != getSharedHeader(sharedCatalog).components.count) {
+        sharedCopies.assign(getSharedHeader(sharedCatalog).components.count, SharedComponentCopies());
+    }
+
+    SharedComponentCopies &copies = sharedCopies[index];
+
+    if (!copies.checked) {
+
+        copies.checked = true;
+        copies.valid = areSharedComponentIndicesValid(sharedCatalog, index);
+
+        if (!copies.valid) {
+            cout << "The shared catalog component " << index + 1 << " is damaged, and is used without its mesh and hull" << endl;
+        }
+
+    }
+
+    return copies;
+
+}
+
+// This method returns the catalog metadata of a component of the shared catalog
+CatalogInfo getSharedInfo (int index) {
+
+    const SharedComponent &component = getSharedComponent(sharedCatalog, index);
+
+    CatalogInfo info;
+
+    info.entry.fileName = string(getSharedArray<char>(sharedCatalog, component.name), component.name.count);
+    info.entry.embedded = index;
+    info.entry.mass = component.mass;
+    info.entry.thrust = component.thrust;
+    info.entry.lift = component.lift;
+    info.entry.drag = component.drag;
+
+    info.maxX = component.maxX;
+    info.minX = component.minX;
+
+    info.maxY = component.maxY;
+    info.minY = component.minY;
+
+    info.maxZ = component.maxZ;
+    info.minZ = component.minZ;
+
+    info.objectCount = component.objects.count;
+    info.vertexCount = component.vertexCount;
+    info.triangleCount = component.triangleCount;
+    info.polygonCount = component.polygonCount;
+
+    return info;
+
+}
+
+// This method returns a copy of the mesh of a component of the shared catalog (already processed by the publisher, so it is copied out as it is). A component with damaged indices has an empty mesh
+vector<Object> loadSharedObject (int index) {
+
+    {
+        lock_guard<mutex> guard(sharedCopiesLock);
+
+        if (!getSharedCopies(index).valid) {
+            return vector<Object>();
+        }
+    }
+
+    const SharedComponent &component = getSharedComponent(sharedCatalog, index);
+    const SharedObject *sources = getSharedArray<SharedObject>(sharedCatalog, component.objects);
+
+    vector<Object> objects(component.objects.count);
+
+    for (int o=0; o<objects.size(); o++) {
+
+        const SharedObject &source = sources[o];
+        Object &obj = objects[o];
+
+        const Point3D *vertices = getSharedArray<Point3D>(sharedCatalog, source.vertices);
+        const int32_t *triangles = getSharedArray<int32_t>(sharedCatalog, source.triangles);
+        const int32_t *edges = getSharedArray<int32_t>(sharedCatalog, source.edges);
+
+        obj.vertices.assign(vertices, vertices + source.vertices.count);
+        obj.triangles.assign(triangles, triangles + source.triangles.count);
+        obj.edges.assign(edges, edges + source.edges.count);
+
+        obj.maxX = component.maxX;
+        obj.minX = component.minX;
+
+        obj.maxY = component.maxY;
+        obj.minY = component.minY;
+
+        obj.maxZ = component.maxZ;
+        obj.minZ = component.minZ;
+
+    }
+
+    return objects;
+
+}
+
+// This method returns the silhouette of a component of the shared catalog (copied out the first time)
+SilhouetteHandle getSharedSilhouette (int index) {
+
+    lock_guard<mutex> guard(sharedCopiesLock);
+    SharedComponentCopies &copies = getSharedCopies(index);
+
+    if (copies.silhouette) {
+        return copies.silhouette;
+    }
+
+    const SharedComponent &component = getSharedComponent(sharedCatalog, index);
+    const float *top = getSharedArray<float>(sharedCatalog, component.top);
+    const float *coefficient = getSharedArray<float>(sharedCatalog, component.coefficient);
+
+    shared_ptr<Silhouette> silhouette = make_shared<Silhouette>();
+
+    silhouette->minX = component.silhouetteMinX;
+    silhouette->minZ = component.silhouetteMinZ;
+    silhouette->cellSize = component.cellSize;
+    silhouette->columns = component.columns;
+    silhouette->rows = component.rows;
+    silhouette->top.assign(top, top + component.top.count);
+    silhouette->coefficient.assign(coefficient, coefficient + component.coefficient.count);
+    silhouette->frontalArea = component.frontalArea;
+    silhouette->dragArea = component.dragArea;
+
+    copies.silhouette = silhouette;
+
+    return silhouette;
+
+}
+
+// This method returns the mass properties of a component of the shared catalog (copied out the first time)
+MassPropertiesHandle getSharedMassProperties (int index) {
+
+    lock_guard<mutex> guard(sharedCopiesLock);
+    SharedComponentCopies &copies = getSharedCopies(index);
+
+    if (copies.shape) {
+        return copies.shape;
+    }
+
+    const SharedComponent &component = getSharedComponent(sharedCatalog, index);
+
+    shared_ptr<MassProperties> shape = make_shared<MassProperties>();
+
+    shape->mass = component.volume;
+    shape->centre = Point3D{component.centre[0], component.centre[1], component.centre[2]};
+    copy(component.inertia, component.inertia + 6, shape->inertia);
+
+    copies.shape = shape;
+
+    return shape;
+
+}
+
+// This method returns the convex hull of a component of the shared catalog (copied out the first time). A component with damaged indices has no hull, so one is built from its (empty) mesh instead
+HullHandle getSharedHull (int index) {
+
+    lock_guard<mutex> guard(sharedCopiesLock);
+    SharedComponentCopies &copies = getSharedCopies(index);
+
+    if (copies.hull || !copies.valid) {
+        return copies.hull;
+    }
+
+    const SharedComponent &component = getSharedComponent(sharedCatalog, index);
+    const Point3D *vertices = getSharedArray<Point3D>(sharedCatalog, component.hullVertices);
+    const int32_t *faces = getSharedArray<int32_t>(sharedCatalog, component.hullFaces);
+
+    shared_ptr<ConvexHull> hull = make_shared<ConvexHull>();
+
+    hull->vertices.assign(vertices, vertices + component.hullVertices.count);
+    hull->faces.assign(faces, faces + component.hullFaces.count * 3);
+
+    hull->maxX = component.hullMaxX;
+    hull->minX = component.hullMinX;
+
+    hull->maxY = component.hullMaxY;
+    hull->minY = component.hullMinY;
+
+    hull->maxZ = component.hullMaxZ;
+    hull->minZ = component.hullMinZ;
+
+    copies.hull = hull;
+
+    return hull;
+
+}
+
+// This method returns the number of components of the built-in catalog (or of the shared catalog, while one is attached)
+int getBuiltInCount () {
+
+    return sharedCatalog.base ? (int) getSharedHeader(sharedCatalog).components.count : embeddedComponentCount;
+
+}
+
+// This method returns the catalog metadata of a component of the built-in catalog (or of the shared catalog, while one is attached)
+CatalogInfo getBuiltInInfo (int index) {
+
+    return sharedCatalog.base ? getSharedInfo(index) : getEmbeddedInfo(index);
+
+}
+
+// This method returns the mesh of a component of the built-in catalog (or of the shared catalog, while one is attached)
+vector<Object> loadBuiltInObject (int index) {
+
+    return sharedCatalog.base ? loadSharedObject(index) : loadEmbeddedObject(index);
+
+}
+
+// This method appends count elements (size bytes in all) to a shared catalog being laid out, 8-byte aligned, and returns where they are
+SharedArray appendSharedArray (vector<char> &bytes, const void *values, size_t size, uint64_t count) {
+
+    bytes.resize((bytes.size() + 7) / 8 * 8);
+
+    SharedArray array = {bytes.size(), count};
+
+    bytes.insert(bytes.end(), (const char*) values, (const char*) values + size);
+
+    return array;
+
+}
+
+// This method processes every component of a catalog and publishes it as the shared catalog called name, replacing any catalog published under that name before (processes already using it keep their mapping). Returns false if a model cannot be read or the segment cannot be created
+bool publishSharedCatalog (const string &name, const vector<ComponentEntry> &entries) {
+
+#ifdef _WIN32
+    cout << "Shared catalogs need POSIX shared memory" << endl;
+    return false;
+#else
+    // The header and the component records come first; the arrays follow them
+    vector<char> bytes(sizeof(SharedCatalogHeader) + entries.size() * sizeof(SharedComponent));
+    vector<SharedComponent> components(entries.size());
+
+    for (int i=0; i<entries.size(); i++) {
+
+        const ComponentEntry &entry = entries[i];
+        SharedComponent &component = components[i];
+
+        CatalogInfo info;
+
+        if (entry.embedded >= 0) {
+            info = getBuiltInInfo(entry.embedded);
+        } else if (!scanObject(entry.fileName, info)) {
+            cout << "Could not read " << entry.fileName << endl;
+            return false;
+        }
+
+        vector<Object> mesh = entry.embedded >= 0 ? loadBuiltInObject(entry.embedded) : loadObject(entry.fileName);
+
+        SilhouetteHandle silhouette = buildSilhouette(mesh);
+        MassPropertiesHandle shape = buildMassProperties(mesh);
+        HullHandle hull = buildMeshHull(mesh);
+
+        component.name = appendSharedArray(bytes, entry.fileName.data(), entry.fileName.size(), entry.fileName.size());
+
+        component.mass = entry.mass;
+        component.thrust = entry.thrust;
+        component.lift = entry.lift;
+        component.drag = entry.drag;
+
+        component.maxX = info.maxX;
+        component.minX = info.minX;
+        component.maxY = info.maxY;
+        component.minY = info.minY;
+        component.maxZ = info.maxZ;
+        component.minZ = info.minZ;
+
+        component.vertexCount = info.vertexCount;
+        component.triangleCount = info.triangleCount;
+        component.polygonCount = info.polygonCount;
+        component.reserved = 0;
+
+        vector<SharedObject> objects(mesh.size());
+
+        for (int o=0; o<mesh.size(); o++) {
+
+            const Object &obj = mesh[o];
+
+            objects[o].vertices = appendSharedArray(bytes, obj.vertices.data(), obj.vertices.size() * sizeof(Point3D), obj.vertices.size());
+            objects[o].triangles = appendSharedArray(bytes, obj.triangles.data(), obj.triangles.size() * sizeof(int32_t), obj.triangles.size());
+            objects[o].edges = appendSharedArray(bytes, obj.edges.data(), obj.edges.size() * sizeof(int32_t), obj.edges.size());
+
+        }
+
+        component.objects = appendSharedArray(bytes, objects.data(), objects.size() * sizeof(SharedObject), objects.size());
+
+        component.silhouetteMinX = silhouette->minX;
+        component.silhouetteMinZ = silhouette->minZ;
+        component.cellSize = silhouette->cellSize;
+        component.columns = silhouette->columns;
+        component.rows = silhouette->rows;
+        component.frontalArea = silhouette->frontalArea;
+        component.dragArea = silhouette->dragArea;
+        component.top = appendSharedArray(bytes, silhouette->top.data(), silhouette->top.size() * sizeof(float), silhouette->top.size());
+        component.coefficient = appendSharedArray(bytes, silhouette->coefficient.data(), silhouette->coefficient.size() * sizeof(float), silhouette->coefficient.size());
+
+        component.volume = shape->mass;
+        component.centre[0] = shape->centre.x;
+        component.centre[1] = shape->centre.y;
+        component.centre[2] = shape->centre.z;
+        copy(shape->inertia, shape->inertia + 6, component.inertia);
+
+        component.hullVertices = appendSharedArray(bytes, hull->vertices.data(), hull->vertices.size() * sizeof(Point3D), hull->vertices.size());
+        component.hullFaces = appendSharedArray(bytes, hull->faces.data(), hull->faces.size() * sizeof(int32_t), hull->faces.size() / 3);
+
+        component.hullMaxX = hull->maxX;
+        component.hullMinX = hull->minX;
+        component.hullMaxY = hull->maxY;
+        component.hullMinY = hull->minY;
+        component.hullMaxZ = hull->maxZ;
+        component.hullMinZ = hull->minZ;
+
+    }
+
+    if (!components.empty()) {
+        memcpy(&bytes[sizeof(SharedCatalogHeader)], components.data(), components.size() * sizeof(SharedComponent));
+    }
+
+    SharedCatalogHeader header = SharedCatalogHeader();
+    copy(sharedCatalogMagic, sharedCatalogMagic + 4, header.magic);
+    header.version = sharedCatalogVersion;
+    header.size = bytes.size();
+    header.components.offset = sizeof(SharedCatalogHeader);
+    header.components.count = components.size();
+
+    // A fresh segment, so that a process attaching while it is written never sees a mix of two catalogs
+    string segmentName = getSharedSegmentName(name);
+
+    shm_unlink(segmentName.c_str());
+
+    int file = shm_open(segmentName.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+
+    if (file < 0 || ftruncate(file, bytes.size()) != 0) {
+
+        cout << "Could not create the shared catalog " << name << endl;
+
+        if (file >= 0) {
+            close(file);
+            shm_unlink(segmentName.c_str());
+        }
+
+        return false;
+
+    }
+
+    char *view = (char*) mmap(nullptr, bytes.size(), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+
+    close(file);
+
+    if (view == MAP_FAILED) {
+        cout << "Could not map the shared catalog " << name << endl;
+        shm_unlink(segmentName.c_str());
+        return false;
+    }
+
+    // The header goes in last: until it is there, the segment is not a catalog to the processes attaching
+    memcpy(view + sizeof(SharedCatalogHeader), &bytes[sizeof(SharedCatalogHeader)], bytes.size() - sizeof(SharedCatalogHeader));
+    atomic_thread_fence(memory_order_release);
+    memcpy(view, &header, sizeof(header));
+
+    munmap(view, bytes.size());
+
+    cout << "Published " << components.size() << " components (" << bytes.size() / 1024 << " KB) as the shared catalog " << name << endl;
+
+    return true;
+#endif
+
+}
+
+// This method removes the shared catalog called name (processes already using it keep their mapping). Returns false if there is none
+bool unpublishSharedCatalog (const string &name) {
+
+#ifdef _WIN32
+    cout << "Shared catalogs need POSIX shared memory" << endl;
+    return false;
+#else
+    if (shm_unlink(getSharedSegmentName(name).c_str()) != 0) {
+        cout << "There is no shared catalog " << name << endl;
+        return false;
+    }
+
+    return true;
+#endif
+
+}
+
+// This method returns the convex hull of a hull together with the hull of a part (at its offset). Only the corners of the two hulls go into the new one, so adding a part costs the same whatever the detail of its mesh
+HullHandle addHull (const HullHandle &hull, const HullHandle &partHull, const Point3D &offset) {
+
+    vector<Point3D> points;
+
+    if (hull) {
+        points = hull->vertices;
+    }
+
+    if (partHull) {
+        for (const Point3D &p : partHull->vertices) {
+            points.push_back(addP3D(p, offset));
+        }
+    }
+
+    return buildConvexHull(points);
+
+}
+
+// This method returns the support point of a set of points moved by offset: the point farthest along direction d (the farthest point of their convex hull)
+Point3D getSupportPoint (const vector<Point3D> &points, Point3D offset, Point3D d) {
+
+    int best = 0;
+    double bestDistance = -numeric_limits<double>::max();
+
+    for (int i=0; i<(int) points.size(); i++) {
+
+        double distance = dotMultiplyP3D(points[i], d);
+
+        if (distance > bestDistance) {
+            bestDistance = distance;
+            best = i;
+        }
+
+    }
+
+    return addP3D(points[best], offset);
+
+}
+
+// This method returns the point of triangle a, b, c closest to the origin, and puts the corners of the feature it lies on (a corner, an edge or the whole triangle) in feature. The origin's region is found from the corners out (the Voronoi region tests from Ericson's Real-Time Collision Detection)
+Point3D getClosestOnTriangle (Point3D a, Point3D b, Point3D c, Point3D *feature, int &count) {
+
+    Point3D ab = subtractP3D(b, a);
+    Point3D ac = subtractP3D(c, a);
+
+    double d1 = -dotMultiplyP3D(ab, a);
+    double d2 = -dotMultiplyP3D(ac, a);
+
+    if (d1 <= 0 && d2 <= 0) {
+        feature[0] = a;
+        count = 1;
+        return a;
+    }
+
+    double d3 = -dotMultiplyP3D(ab, b);
+    double d4 = -dotMultiplyP3D(ac, b);
+
+    if (d3 >= 0 && d4 <= d3) {
+        feature[0] = b;
+        count = 1;
+        return b;
+    }
+
+    double vc = d1 * d4 - d3 * d2;
+
+    if (vc <= 0 && d1 >= 0 && d3 <= 0) {
+        feature[0] = a;
+        feature[1] = b;
+        count = 2;
+        return addP3D(a, scaleP3D(ab, d1 / (d1 - d3)));
+    }
+
+    double d5 = -dotMultiplyP3D(ab, c);
+    double d6 = -dotMultiplyP3D(ac, c);
+
+    if (d6 >= 0 && d5 <= d6) {
+        feature[0] = c;
+        count = 1;
+        return c;
+    }
+
+    double vb = d5 * d2 - d1 * d6;
+
+    if (vb <= 0 && d2 >= 0 && d6 <= 0) {
+        feature[0] = a;
+        feature[1] = c;
+        count = 2;
+        return addP3D(a, scaleP3D(ac, d2 / (d2 - d6)));
+    }
+
+    double va = d3 * d6 - d5 * d4;
+
+    if (va <= 0 && d4 - d3 >= 0 && d5 - d6 >= 0) {
+        feature[0] = b;
+        feature[1] = c;
+        count = 2;
+        return addP3D(b, scaleP3D(subtractP3D(c, b), (d4 - d3) / ((d4 - d3) + (d5 - d6))));
+    }
+
+    feature[0] = a;
+    feature[1] = b;
+    feature[2] = c;
+    count = 3;
+
+    double denominator = 1 / (va + vb + vc);
+
+    return addP3D(a, addP3D(scaleP3D(ab, vb * denominator), scaleP3D(ac, vc * denominator)));
+
+}
+
+// This method returns the point of a GJK simplex (a point, segment, triangle or tetrahedron) closest to the origin, and reduces the simplex to the corners of the feature that point lies on. A tetrahedron with the origin inside is left as it is (the returned point is then the origin)
+Point3D reduceSimplex (Point3D *simplex, int &count) {
+
+    Point3D origin = {0, 0, 0};
+
+    if (count == 1) {
+        return simplex[0];
+    }
+
+    if (count == 2) {
+
+        Point3D ab = subtractP3D(simplex[1], simplex[0]);
+        double t = -dotMultiplyP3D(simplex[0], ab) / max(dotMultiplyP3D(ab, ab), 1e-300);
+
+        if (t <= 0) {
+            count = 1;
+            return simplex[0];
+        }
+
+        if (t >= 1) {
+            simplex[0] = simplex[1];
+            count = 1;
+            return simplex[0];
+        }
+
+        return addP3D(simplex[0], scaleP3D(ab, t));
+
+    }
+
+    if (count == 3) {
+        return getClosestOnTriangle(simplex[0], simplex[1], simplex[2], simplex, count);
+    }
+
+    // A tetrahedron: the closest point is on one of the faces the origin is in front of (on the other side from the fourth corner), or the origin is inside
+    static const int faces[4][4] = {{0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}};
+
+    Point3D best = origin;
+    double bestDistance = numeric_limits<double>::max();
+    Point3D bestFeature[3];
+    int bestCount = 0;
+
+    for (int f=0; f<4; f++) {
+
+        Point3D a = simplex[faces[f][0]];
+        Point3D b = simplex[faces[f][1]];
+        Point3D c = simplex[faces[f][2]];
+        Point3D d = simplex[faces[f][3]];
+
+        Point3D normal = crossMultiplyP3D(subtractP3D(b, a), subtractP3D(c, a));
+
+        if (-dotMultiplyP3D(normal, a) * dotMultiplyP3D(normal, subtractP3D(d, a)) > 0) {
+            continue;
+        }
+
+        Point3D feature[3];
+        int featureCount;
+        Point3D closest = getClosestOnTriangle(a, b, c, feature, featureCount);
+        double distance = dotMultiplyP3D(closest, closest);
+
+        if (distance < bestDistance) {
+
+            best = closest;
+            bestDistance = distance;
+            bestCount = featureCount;
+
+            for (int k=0; k<featureCount; k++) {
+                bestFeature[k] = feature[k];
+            }
+
+        }
+
+    }
+
+    if (bestCount == 0) {
+        return origin;
+    }
+
+    for (int k=0; k<bestCount; k++) {
+        simplex[k] = bestFeature[k];
+    }
+
+    count = bestCount;
+
+    return best;
+
+}
+
+// This method returns true if the convex hulls of two sets of points overlap (the first moved by offset), with GJK: it looks for the origin in the Minkowski difference of the two shapes, keeping a simplex of support points and moving it towards the origin one support point at a time. Shapes that only touch count as overlapping, so a hull resting on the ground is in contact with it
+bool isIntersecting (const vector<Point3D> &a, Point3D offset, const vector<Point3D> &b) {
+
+    Point3D origin = {0, 0, 0};
+
+    Point3D simplex[4];
+    int count = 1;
+
+    Point3D d = {0, 1, 0};
+    simplex[0] = subtractP3D(getSupportPoint(a, offset, d), getSupportPoint(b, origin, scaleP3D(d, -1)));
+
+    // The point of the simplex closest to the origin
+    Point3D closest = simplex[0];
+
+    for (int iteration=0; iteration<64; iteration++) {
+
+        // The origin is on (or in) the simplex
+        if (dotMultiplyP3D(closest, closest) < 1e-18) {
+            return true;
+        }
+
+        d = scaleP3D(closest, -1);
+
+        Point3D p = subtractP3D(getSupportPoint(a, offset, d), getSupportPoint(b, origin, scaleP3D(d, -1)));
+
+        // The difference reaches no further than this towards the origin, so it cannot contain it
+        if (dotMultiplyP3D(p, d) <= 0) {
+            return false;
+        }
+
+        simplex[count++] = p;
+        closest = reduceSimplex(simplex, count);
+
+    }
+
+    // Not settled (the shapes are only just touching): count it as contact
+    return true;
+
+}
+
+// This integer will represent the current stage of the game
+int stage = 0;
+
+// The index of every component in the components text file, in menu order (the lightweight metadata only, the meshes live in the mesh cache). Sized by the background loader before catalogSize is published
+vector<CatalogInfo> catalog;
+// The parts of the rocket being built (the version of the edit history being shown): the assembled parts, and the parts that a user has selected but not applied to the rocket (i.e., in the "workspace" but not in assembly)
+PartWorld partWorld;
+
+// The number of entries in the catalog. Stays at -1 until the background loader has parsed the components text file and sized the catalog (release/acquire publishes the sizing to the render thread)
+atomic<int> catalogSize(-1);
+// One flag per catalog entry, set once catalog[i] has been scanned and will no longer be written by the loader threads
+unique_ptr<atomic<bool>[]> componentReady;
+// The number of components that have finished loading (used for the progress indicator)
+atomic<int> componentsLoaded(0);
+
+// The path of the components text file (watched for changes once every component has loaded). Only read when there is no built-in catalog, or when one is given with --components <file>
+string componentsFileName = "Components.txt";
+bool externalCatalog = false;
+
+// This struct is one change to the catalog, applied on the render thread between frames. It is one of: a resize (entries added/removed in the components text file), a changed entry from the component watcher, or a mesh that finished loading on demand
+struct ComponentUpdate
+{
+    // The catalog size after a resize, or -1 for any other update
+    int newCatalogSize;
+    // For a resize: the new index of every entry before it, or -1 if it was removed
+    vector<int> remap;
+
+    int index;
+
+    // Set when the entry changed in the components text file (info holds its new physics values and metadata)
+    bool entryChanged;
+    CatalogInfo info;
+    // Set when the entry's model changed, so any loaded copy of the old mesh is out of date
+    bool meshChanged;
+
+    // A mesh loaded on demand (with its silhouette, mass properties and convex hull), for the cache generation it was requested in
+    MeshHandle mesh;
+    SilhouetteHandle silhouette;
+    MassPropertiesHandle shape;
+    HullHandle hull;
+    int generation;
+};
+
+// This struct is one slot of the mesh cache (one per catalog entry)
+struct MeshCacheEntry
+{
+    // The loaded mesh, or empty if it is not resident
+    MeshHandle mesh;
+    size_t bytes;
+
+    // The silhouette, mass properties and convex hull of the entry's model. They are small, so they stay when the mesh is evicted and are only computed once per model
+    SilhouetteHandle silhouette;
+    MassPropertiesHandle shape;
+    HullHandle hull;
+
+    // Whether a background load has been requested and has not arrived yet
+    bool loading;
+    // Renewed (from meshGenerations) whenever the entry's model changes or the entry moves to another slot, so that loads of the old model are dropped when they arrive
+    int generation;
+
+    // The position of the entry in meshLRU while it is resident
+    list<int>::iterator lru;
+};
+
+// The mesh cache. Only touched by the render thread: meshes are requested by the menu and by placed parts, loaded in the background, and evicted least recently used first when over meshBudget
+vector<MeshCacheEntry> meshCache;
+// The catalog indices of the resident meshes, most recently used first
+list<int> meshLRU;
+// The total bytes of the resident meshes
+size_t meshCacheBytes = 0;
+// The last mesh cache generation handed out (generations are never reused, so a load can only match the slot it was requested for)
+int meshGenerations = 0;
+// The number of bytes of meshes that may stay resident (placed parts are pinned and can push the cache over this). Set with --mesh-budget <megabytes>
+size_t meshBudget = 256 * 1024 * 1024;
+
+// The index of the first catalog entry shown in the menu (the menu scrolls so that only the visible entries need their meshes loaded)
+int menuScroll = 0;
+// The number of 250 by 250 menu boxes that fit above the instructions
+const int menuSlots = 3;
+
+// The mass properties of the assembly (in the coordinates of the part offsets), added to part by part as the parts are assembled
+MassProperties assemblyMass = MassProperties();
+
+// The convex hull of the assembly (in the same coordinates), also grown part by part
+HullHandle assemblyHull;
+
+// This struct holds the totals of the physics engine values of an assembly, added to part by part as the parts are assembled
+struct AssemblyTotals
+{
+    int parts;
+
+    double mass;
+    double thrust;
+    double lift;
+    double drag;
+
+    // The air drag area of the assembly as a whole (worked out again when parts are added, as a new part can shield or be shielded by the others)
+    double dragArea;
+};
+
+// The totals of the assembly
+AssemblyTotals assemblyTotals = AssemblyTotals();
+
+// The possible outcomes of a flight
+const int FLIGHT_ACTIVE = 0;
+const int FLIGHT_CRASHED = 1;
+const int FLIGHT_SPACE = 2;
+const int FLIGHT_LANDED = 3;
+
+// How far ahead the launch of an assembly is predicted (in simulation time). A rocket still in the air by then is shown as still flying
+const double predictionTime = 1000;
+
+// This struct is the predicted launch of an assembly, worked out once each time the assembly changes so that it can be shown while building
+struct FlightPrediction
+{
+    // False while there is nothing to launch
+    bool valid;
+
+    // The outcome (FLIGHT_ACTIVE if the rocket is still in the air when the prediction stops), the highest altitude and the time it is reached (in simulation time, both infinity for a rocket that escapes the planet)
+    int outcome;
+    double maxAltitude;
+    double apogeeTime;
+
+    // The time the rocket reaches space (-1 if it does not)
+    double spaceTime;
+};
+
+// The predicted launch of the assembly
+FlightPrediction assemblyPrediction = FlightPrediction();
+
+// This method predicts the launch of an assembly with the given totals, convex hull and mass properties (defined with the launch simulation further down)
+FlightPrediction predictFlight (const AssemblyTotals &totals, const HullHandle &hull, const MassProperties &mass);
+
+// This struct is one version of the rocket being built, kept for undo and redo. The pools of its parts share every unchanged node with the versions before and after it, and the values worked out from the assembly (mass properties, hull, totals and predicted launch) are kept so that switching versions does not work them out again
+struct EditState
+{
+    PartWorld world;
+
+    MassProperties mass;
+    HullHandle hull;
+    AssemblyTotals totals;
+    FlightPrediction prediction;
+};
+
+// Every version of the rocket since the workspace was last cleared, oldest first, and the index of the version being shown (the versions after it can be redone)
+vector<EditState> editHistory(1, EditState());
+int editIndex = 0;
+
+// Index/ID of the currently selected menu part to be added to the main assembly (initialize with null value)
+int menuSelection = -1;
+
+// The x and y coordinates of the left mouse click, scaled between 0 and 1000 (used to determine which menu item has been clicked
+double leftX = -1;
+double leftY = -1;
+
+// The translation values of the currently selected component
+double sxpos = 0;
+double sypos = 0;
+double szpos = 0;
+
+// Boolean variable stating whether the middle mouse button is being held
+bool mhold = false;
+// Global Perspective (gp) middle mouse button values (delta x, delta y, current x + y)
+int gpx1, gpx2, gpy1, gpy2, gpcx, gpcy;
+
+// Physics engine values - The following variables are constants for simulating a rocket launch
+
+// The vertical position at any point in time (the render thread's copy, taken from the latest simulation snapshot)
+double v_pos = 0.0;
+// The vertical velocity at any point in time
+double v_vel = 0.0;
+
+// Pi (M_PI is not part of standard C++)
+const double pi = 3.14159265358979323846;
+
+// Gravitational acceleration on the surface of the planet (it falls off with the inverse square of the distance to the planet's centre as the rocket goes further up)
+constexpr double g_accl = -9.8;
+
+// The radius of the planet and the scale height of its atmosphere (the height over which the air density drops by a factor of e), in the same units as v_pos
+constexpr double planetRadius = 40000;
+constexpr double atmosphereScaleHeight = 600;
+
+// The height at which the rocket has reached "space" (and the player wins)
+const double spaceHeight = 5000;
+
+// The altitude above which the air is thin enough to ignore (12 scale heights, where the air density is below one millionth). An unpowered rocket above it coasts along its orbit instead of being integrated step by step
+constexpr double vacuumHeight = 12 * atmosphereScaleHeight;
+
+// The gravitational parameter of the planet (surface gravity times the radius squared)
+constexpr double gravityParameter = -g_accl * planetRadius * planetRadius;
+
+// How fast drag wears lift down, per unit of drag and unit of simulation time. The original simulation took one unit of drag off the lift every frame at around 60 frames per second, i.e. 600 times per unit of simulation time (10 seconds)
+const double liftDecayRate = 600;
+
+// This boolean variable is used to determine whether the user has pressed B yet in the rocket launch screen
+bool BLASTOFF = false;
+
+// The angle of the rocket from the vertical at launch, in degrees towards downrange (set with A and D on the launch screen before blastoff)
+double launchPitch = 0;
+const double launchPitchStep = 5;
+const double maxLaunchPitch = 85;
+
+// The convex hull of the rocket as it stands on the pad: tilted by the launch pitch about its centre of mass, and moved up or down so that its lowest point is at height 0 (the pad). Empty until the rocket is assembled
+HullHandle launchHull;
+
+// The height of the pad on the launch screen, in the coordinates of the part offsets (the lowest point of the tilted rocket, or 200 below its origin if it has no hull)
+double padLevel = -200;
+
+// The fastest the rocket may touch down and still land rather than crash (in units of height per unit of simulation time)
+const double safeLandingSpeed = 10;
+
+// The moment the program started (the game clock counts from here)
+const chrono::steady_clock::time_point startTime = chrono::steady_clock::now();
+
+// While recording or replaying an input log, the game clock only moves once per frame: it is the time in the frame record of the frame being drawn (-1 when neither, and the clock is the wall clock). Recording and replay both take it from the records, so they see exactly the same times. Set by the render thread, read by the simulation thread
+atomic<double> frameClock(-1);
+
+// This method returns the game clock in milliseconds. All simulation timing goes through here so that a replayed session sees exactly the times of the recorded one
+double getElapsedMillis () {
+
+    double frame = frameClock.load(memory_order_relaxed);
+
+    if (frame >= 0) {
+        return frame;
+    }
+
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+
+}
+
+// This method returns true if catalog entry index has been scanned and published by the background loader (safe to read catalog[index])
+bool isComponentReady (int index) {
+
+    return index >= 0 && index < catalogSize.load(memory_order_acquire) && componentReady[index].load(memory_order_acquire);
+
+}
+
+// This void method applies a catalog update on the render thread (defined with the other update code further down)
+void applyComponentUpdate (ComponentUpdate *update);
+
+// This void method hands a catalog update to the render thread (called from the component watcher and the mesh loads)
+void postComponentUpdate (ComponentUpdate *update) {
+
+    runOnMainThread([update]() { applyComponentUpdate(update); });
+
+}
+
+// This void method loads the mesh of a catalog entry in the background and posts it to the render thread, along with its silhouette, mass properties and convex hull (computed from the mesh unless they are already known)
+void loadMeshAsync (int index, ComponentEntry entry, int generation, SilhouetteHandle silhouette, MassPropertiesHandle shape, HullHandle hull) {
+
+    ComponentUpdate *update = new ComponentUpdate();
+    update->newCatalogSize = -1;
+    update->index = index;
+    update->entryChanged = false;
+    update->meshChanged = false;
+
+    vector<Object> mesh = entry.embedded >= 0 ? loadBuiltInObject(entry.embedded) : loadObject(entry.fileName);
+
+    // A shared catalog comes with them worked out
+    if (sharedCatalog.base && entry.embedded >= 0) {
+        silhouette = silhouette ? silhouette : getSharedSilhouette(entry.embedded);
+        shape = shape ? shape : getSharedMassProperties(entry.embedded);
+        hull = hull ? hull : getSharedHull(entry.embedded);
+    }
+
+    update->silhouette = silhouette ? silhouette : buildSilhouette(mesh);
+    update->shape = shape ? shape : buildMassProperties(mesh);
+    update->hull = hull ? hull : buildMeshHull(mesh);
+    update->generation = generation;
+
+    // Everything but drawing is done with the full precision mesh
+    if (compactMeshes) {
+        for (Object &obj : mesh) {
+            compactObject(obj);
+        }
+    }
+
+    update->mesh = make_shared<const vector<Object> >(move(mesh));
+
+    postComponentUpdate(update);
+
+}
+
+// This void method makes sure the mesh cache has one slot per catalog entry
+void syncMeshCache () {
+
+    int total = catalogSize.load(memory_order_acquire);
+
+    if (total > (int) meshCache.size()) {
+
+        MeshCacheEntry blank;
+        blank.bytes = 0;
+        blank.loading = false;
+        blank.generation = 0;
+
+        meshCache.resize(total, blank);
+
+    }
+
+}
+
+// This void method drops the mesh at index from the cache (placed parts using it keep their own reference)
+void evictMesh (int index) {
+
+    MeshCacheEntry &slot = meshCache[index];
+
+    if (!slot.mesh) {
+        return;
+    }
+
+    meshLRU.erase(slot.lru);
+    meshCacheBytes -= slot.bytes;
+
+    slot.mesh.reset();
+    slot.bytes = 0;
+
+}
+
+// This void method evicts the least recently used meshes until the cache fits its budget. Meshes referenced by placed parts are pinned and skipped
+void trimMeshCache () {
+
+    list<int>::iterator it = meshLRU.end();
+
+    while (meshCacheBytes > meshBudget && it != meshLRU.begin()) {
+
+        --it;
+
+        int index = *it;
+
+        // Pinned: something besides the cache holds the mesh
+        if (meshCache[index].mesh.use_count() > 1) {
+            continue;
+        }
+
+        // Step past the entry before it is erased from the list
+        list<int>::iterator victim = it;
+        ++it;
+
+        evictMesh(*victim);
+
+    }
+
+}
+
+// This method returns the mesh of catalog entry index if it is resident (marking it as recently used). Otherwise it starts loading it in the background and returns an empty handle; the mesh will be there in a later frame
+MeshHandle requestMesh (int index) {
+
+    if (!isComponentReady(index)) {
+        return MeshHandle();
+    }
+
+    syncMeshCache();
+
+    MeshCacheEntry &slot = meshCache[index];
+
+    if (slot.mesh) {
+
+        // Move to the front of the LRU list
+        meshLRU.splice(meshLRU.begin(), meshLRU, slot.lru);
+        return slot.mesh;
+
+    }
+
+    if (!slot.loading) {
+        slot.loading = true;
+        ComponentEntry entry = catalog[index].entry;
+        int generation = slot.generation;
+        SilhouetteHandle silhouette = slot.silhouette;
+        MassPropertiesHandle shape = slot.shape;
+        HullHandle hull = slot.hull;
+
+        runJob([index, entry, generation, silhouette, shape, hull]() { loadMeshAsync(index, entry, generation, silhouette, shape, hull); });
+    }
+
+    return MeshHandle();
+
+}
+
+// This void method multiplies the current matrix so that a component mesh drawn at the origin is scaled down into the menu box at x, y, z (keeping its aspect ratio). This replaces keeping a second, pre-scaled copy of every mesh for the menu
+void applyMenuTransform (const CatalogInfo &info, double x, double y, double z) {
+
+    double sizeY = info.maxY - info.minY;
+    double sizeZ = info.maxZ - info.minZ;
+
+    // Flat models would divide by zero
+    if (sizeY <= 0) {
+        sizeY = 1;
+    }
+
+    if (sizeZ <= 0) {
+        sizeZ = 1;
+    }
+
+    // Fit the height to 200, scale the width by the same amount, and fit the depth between -200 and 200
+    glTranslated(x, y, z - 200);
+    glScaled(200 / sizeY, 200 / sizeY, 400 / sizeZ);
+    glTranslated(-info.minX, -info.minY, -info.minZ);
+
+}
+
+// This void method draws a progress bar and text for the background component loading at x, y (with the given colour). Nothing is drawn once every component is ready
+void drawLoadingProgress (double x, double y, double r, double g, double b) {
+
+    int total = catalogSize.load(memory_order_acquire);
+    int loaded = componentsLoaded.load(memory_order_acquire);
+
+    // Every component is loaded, no indicator needed
+    if (total >= 0 && loaded >= total) {
+        return;
+    }
+
+    glColor3f(r, g, b);
+
+    // The components text file has not even been read yet
+    if (total < 0) {
+        renderString(x, y, GLUT_BITMAP_HELVETICA_12, "Reading components...");
+        return;
+    }
+
+    renderString(x, y + 15, GLUT_BITMAP_HELVETICA_12, "Loading components: " + to_string(loaded) + " / " + to_string(total));
+
+    // Draw the outline of the bar followed by the filled portion
+    glBegin(GL_LINE_LOOP);
+        glVertex3d(x, y, 1200);
+        glVertex3d(x + 240, y, 1200);
+        glVertex3d(x + 240, y + 10, 1200);
+        glVertex3d(x, y + 10, 1200);
+    glEnd();
+
+    double filled = 240.0 * loaded / total;
+
+    glBegin(GL_POLYGON);
+        glVertex3d(x, y, 1200);
+        glVertex3d(x + filled, y, 1200);
+        glVertex3d(x + filled, y + 10, 1200);
+        glVertex3d(x, y + 10, 1200);
+    glEnd();
+
+}
+
+// This void method draws the intro screen
+void drawIntroScreen () {
+
+    // Draw a black background
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+
+    // Show how far along the background component loading is
+    drawLoadingProgress(10, 60, 1.0, 1.0, 1.0);
+
+    // Render the introduction text across the screen
+
+    // Set the draw color to white
+    glColor3f(1.0, 1.0, 1.0);
+
+    // Render the intro text as seperate lines
+    renderString(10, 700, GLUT_BITMAP_HELVETICA_18, "You are the fearless Space Commander in Chief (SCC) of an alien race");
+    renderString(10, 650, GLUT_BITMAP_HELVETICA_18, "named the Kerugami. Posed with the previously thought insurmountable");
+    renderString(10, 600, GLUT_BITMAP_HELVETICA_18, "objective of making the Kerugami a space-faring species, you are given");
+    renderString(10, 550, GLUT_BITMAP_HELVETICA_18, "the necessary components to build and launch a rocket. ");
+    renderString(200, 400, GLUT_BITMAP_HELVETICA_18, "Are you ready to take on this daunting task?");
+    renderString(670, 250, GLUT_BITMAP_HELVETICA_18, " Press SPACE for YES");
+    renderString(520, 200, GLUT_BITMAP_HELVETICA_12, " [No has not been added as a feature to the game]");
+
+}
+
+// This void method draws the visible page of the menu on the side
+void drawMenu () {
+
+    // Double variables used to keep track of the starting position of each draw
+    double startX = 5.0;
+    double startY = 725.0;
+    double startZ = 1000.0;
+
+    // Only the entries that the background loader has published may be read
+    int total = catalogSize.load(memory_order_acquire);
+
+    // Only the visible entries are drawn (and so only their meshes are requested)
+    for (int i=menuScroll; i<total && i<menuScroll+menuSlots; i++) {
+
+        // Set the polyon color to white
+        glColor3f(1, 1, 1);
+
+        // Draw a square polygon surrounding the current object
+        glBegin(GL_POLYGON);
+            glVertex3d(startX + 250, startY, startZ);
+            glVertex3d(startX + 250, startY + 250, startZ);
+            glVertex3d(startX, startY + 250, startZ);
+            glVertex3d(startX, startY, startZ);
+        glEnd();
+
+        // Draw a bounding box around the polygon
+
+        // Set the line drawing color to black
+        glColor3f(0, 0, 0);
+
+        // Draw a square polygon surrounding the current object
+        glBegin(GL_LINE_LOOP);
+            glVertex3d(startX, startY, 1200);
+            glVertex3d(startX + 250, startY, 1200);
+            glVertex3d(startX + 250, startY + 250, 1200);
+            glVertex3d(startX, startY + 250, 1200);
+        glEnd();
+
+        // Draw the actual mini-sized model at the correct starting position (or a placeholder if it is still loading)
+        MeshHandle mesh = requestMesh(i);
+
+        if (mesh) {
+
+            glColor3f(0, 0, 1);
+
+            // Draw the component scaled into the box
+            glPushMatrix();
+
+                applyMenuTransform(catalog[i], startX, startY, startZ);
+                drawObject(*mesh, 0, 0, 0);
+
+            glPopMatrix();
+
+        } else {
+
+            glColor3f(0.5, 0.5, 0.5);
+
+            renderString(startX + 90, startY + 120, GLUT_BITMAP_HELVETICA_12, "Loading...");
+
+        }
+
+        // Increment the position for the next box
+        startY -= 250;
+
+    }
+
+    // Show which page of the menu is visible
+    if (total > menuSlots) {
+
+        glColor3f(0.0, 0.0, 0.0);
+
+        int last = min(menuScroll + menuSlots, total);
+        renderString(10, 205, GLUT_BITMAP_HELVETICA_12, "Parts " + to_string(menuScroll + 1) + "-" + to_string(last) + " of " + to_string(total) + " (scroll or Page Up/Down)");
+
+    }
+
+    // Show the loading progress while there are still components to come
+    drawLoadingProgress(740, 20, 0.0, 0.0, 0.0);
+
+    // Draw user instructions (in text) underneath menu
+
+    // Set the text drawing color to black
+    glColor3f(0.0, 0.0, 0.0);
+
+    // Draw text with user instruction menu
+    renderString(10, 180, GLUT_BITMAP_HELVETICA_12, "Use middle mouse button to rotate");
+    renderString(10, 152, GLUT_BITMAP_HELVETICA_12, "Left click on menu item to add a part");
+    renderString(10, 124, GLUT_BITMAP_HELVETICA_12, "Press 0-9 to select an unassembled part");
+    renderString(10, 96, GLUT_BITMAP_HELVETICA_12, "Press W,A,S,D,P,L to move selected part");
+    renderString(10, 68, GLUT_BITMAP_HELVETICA_12, "Press U to assemble wokspace");
+    renderString(10, 40, GLUT_BITMAP_HELVETICA_12, "Press Z to undo, Y to redo");
+    renderString(10, 15, GLUT_BITMAP_HELVETICA_12, "(Assembled parts cannot be moved)");
+
+}
+
+// Part systems - the passes over the parts of the rocket. Each one takes the pools it needs a run of 32 parts at a time (see getRunEnd) and reads them straight through
+
+// This method returns the bounds of a component mesh
+PartBounds getMeshBounds (const vector<Object> &mesh) {
+
+    PartBounds bounds = {1, 0, 1, 0, 1, 0};
+
+    // Every object of a mesh carries the bounds of the whole model
+    if (!mesh.empty()) {
+
+        const Object &model = mesh.front();
+
+        bounds.minX = model.minX;
+        bounds.maxX = model.maxX;
+        bounds.minY = model.minY;
+        bounds.maxY = model.maxY;
+        bounds.minZ = model.minZ;
+        bounds.maxZ = model.maxZ;
+
+    }
+
+    return bounds;
+
+}
+
+// This void method adds a new part to the workspace of a rocket: a part of the given catalog entry, with its mesh, shape and physics engine values, where it was added
+void addPart (PartWorld &world, int catalogIndex, const MeshHandle &mesh, const PartShape &shape, const PartPhysics &physics) {
+
+    world.transforms = world.transforms.push_back(Point3D{0, 0, 0});
+    world.meshes = world.meshes.push_back(mesh);
+    world.bounds = world.bounds.push_back(getMeshBounds(*mesh));
+    world.physics = world.physics.push_back(physics);
+    world.shapes = world.shapes.push_back(shape);
+    world.catalogIndices = world.catalogIndices.push_back(catalogIndex);
+    world.states = world.states.push_back(0);
+
+    world.size++;
+
+}
+
+// This method returns the number of the selected part, or -1 if none is, reading only the state flags of the workspace parts (assembled parts cannot be selected)
+int getSelectedPart (const PartWorld &world) {
+
+    for (int run=world.assembled; run<world.size; run=getRunEnd(run, world.size)) {
+
+        const unsigned char *states = world.states.getRun(run);
+
+        for (int k=0; k<getRunEnd(run, world.size)-run; k++) {
+            if (states[k] & PART_SELECTED) {
+                return run + k;
+            }
+        }
+
+    }
+
+    return -1;
+
+}
+
+// This void method selects a workspace part (or none, for -1) in place of the selected one
+void selectPart (PartWorld &world, int part) {
+
+    int selected = getSelectedPart(world);
+
+    if (selected == part) {
+        return;
+    }
+
+    if (selected >= 0) {
+        world.states = world.states.set(selected, world.states[selected] & ~PART_SELECTED);
+    }
+
+    if (part >= 0) {
+        world.states = world.states.set(part, world.states[part] | PART_SELECTED);
+    }
+
+}
+
+// This void method draws parts first to last - 1 at (x, y, z) plus their transforms, reading only the transforms, meshes and state flags. Assembled parts are drawn in the given colour and workspace parts in blue, except the selected one: green, and moved by the move not applied yet
+void drawParts (const PartWorld &world, int first, int last, double x, double y, double z, double r, double g, double b) {
+
+    for (int run=first; run<last; run=getRunEnd(run, last)) {
+
+        const Point3D *transforms = world.transforms.getRun(run);
+        const MeshHandle *meshes = world.meshes.getRun(run);
+        const unsigned char *states = world.states.getRun(run);
+
+        for (int k=0; k<getRunEnd(run, last)-run; k++) {
+
+            double xtrans = x + transforms[k].x;
+            double ytrans = y + transforms[k].y;
+            double ztrans = z + transforms[k].z;
+
+            if (states[k] & PART_ASSEMBLED) {
+
+                glColor3d(r, g, b);
+
+            } else if (states[k] & PART_SELECTED) {
+
+                glColor3d(0, 1, 0);
+
+                xtrans += sxpos;
+                ytrans += sypos;
+                ztrans += szpos;
+
+            } else {
+
+                glColor3d(0, 0, 1);
+
+            }
+
+            drawObject(*meshes[k], xtrans, ytrans, ztrans);
+
+        }
+
+    }
+
+}
+
+// This method returns the bounds of parts first to last - 1 together (with their transforms), reading only the bounds and transforms. Parts with empty models are left out
+PartBounds getPartsBounds (const PartWorld &world, int first, int last) {
+
+    PartBounds total = {1000000, -1000000, 1000000, -1000000, 1000000, -1000000};
+
+    for (int run=first; run<last; run=getRunEnd(run, last)) {
+
+        const PartBounds *bounds = world.bounds.getRun(run);
+        const Point3D *transforms = world.transforms.getRun(run);
+
+        for (int k=0; k<getRunEnd(run, last)-run; k++) {
+
+            if (bounds[k].maxX < bounds[k].minX) {
+                continue;
+            }
+
+            total.minX = min(total.minX, bounds[k].minX + transforms[k].x);
+            total.maxX = max(total.maxX, bounds[k].maxX + transforms[k].x);
+            total.minY = min(total.minY, bounds[k].minY + transforms[k].y);
+            total.maxY = max(total.maxY, bounds[k].maxY + transforms[k].y);
+            total.minZ = min(total.minZ, bounds[k].minZ + transforms[k].z);
+            total.maxZ = max(total.maxZ, bounds[k].maxZ + transforms[k].z);
+
+        }
+
+    }
+
+    return total;
+
+}
+
+// This void method adds the physics engine values of a part to the totals of an assembly (the drag area is left to the caller)
+void addTotals (AssemblyTotals &totals, const PartPhysics &physics) {
+
+    totals.parts++;
+    totals.mass += physics.mass;
+    totals.thrust += physics.thrust;
+    totals.lift += physics.lift;
+    totals.drag += physics.drag;
+
+}
+
+// This void method adds parts first to last - 1 to the mass properties, convex hull and totals of an assembly made of the parts before them, reading only their physics values, shapes and transforms. The drag area is worked out again for parts 0 to last - 1, as a new part can shield or be shielded by the others
+void addPartPhysics (const PartWorld &world, int first, int last, MassProperties &mass, HullHandle &hull, AssemblyTotals &totals) {
+
+    for (int run=first; run<last; run=getRunEnd(run, last)) {
+
+        const PartPhysics *physics = world.physics.getRun(run);
+        const PartShape *shapes = world.shapes.getRun(run);
+        const Point3D *transforms = world.transforms.getRun(run);
+
+        for (int k=0; k<getRunEnd(run, last)-run; k++) {
+
+            addMass(mass, getPartMass(physics[k], shapes[k], transforms[k]));
+            hull = addHull(hull, shapes[k].hull, transforms[k]);
+            addTotals(totals, physics[k]);
+
+        }
+
+    }
+
+    totals.dragArea = getDragArea(world, 0, last);
+
+}
+
+// This void method saves the current parts as a new version after an edit. Any versions that had been undone are dropped, as a new edit replaces them
+void recordEdit () {
+
+    editHistory.erase(editHistory.begin() + editIndex + 1, editHistory.end());
+
+    EditState state;
+    state.world = partWorld;
+    state.mass = assemblyMass;
+    state.hull = assemblyHull;
+    state.totals = assemblyTotals;
+    state.prediction = assemblyPrediction;
+
+    editHistory.push_back(state);
+    editIndex++;
+
+}
+
+// This void method shows the version of the rocket at index of the edit history. Only pool roots and handles are copied, so switching takes the same time however big the rocket is
+void restoreEdit (int index) {
+
+    editIndex = index;
+
+    const EditState &state = editHistory[index];
+
+    partWorld = state.world;
+    assemblyMass = state.mass;
+    assemblyHull = state.hull;
+    assemblyTotals = state.totals;
+    assemblyPrediction = state.prediction;
+
+    // The selected part may not exist in this version
+    selectPart(partWorld, -1);
+    sxpos = 0;
+    sypos = 0;
+    szpos = 0;
+
+}
+
+// This void method undoes the last edit. A move that has not been applied yet (the part is still selected) is simply dropped
+void undoEdit () {
+
+    if (getSelectedPart(partWorld) != -1 && (sxpos != 0 || sypos != 0 || szpos != 0)) {
+
+        sxpos = 0;
+        sypos = 0;
+        szpos = 0;
+
+    } else if (editIndex > 0) {
+
+        restoreEdit(editIndex - 1);
+
+    }
+
+}
+
+// This void method redoes the last undone edit
+void redoEdit () {
+
+    if (editIndex + 1 < (int) editHistory.size()) {
+        restoreEdit(editIndex + 1);
+    }
+
+}
+
+// This void method forgets every version of the rocket and starts the history again from the current (normally empty) one
+void clearEditHistory () {
+
+    editHistory.clear();
+    editIndex = -1;
+
+    recordEdit();
+
+}
+
+// This method checks to see if any components needs to be added to the workspace
+void updateWorkspace () {// Scale the creen for the specific screen
+
+    // Check to see if the mouse left click selection lands on a valid menu item. Each menu item is bounded by a 250 by 250 box
+    if (leftX <= 250) {
+
+        // Get the current index of the selected component in the workspace based off the click position (and the menu scroll)
+        int slot = (int) (leftY/250);
+        int index = menuScroll + slot;
+
+        // Check to see if the X value is inside the visible range of the menu (and that the component's mesh has been loaded)
+        MeshHandle mesh = slot < menuSlots ? requestMesh(index) : MeshHandle();
+
+        if (mesh) {
+
+            // Update the menu item at the selected menu "square" by adding it to the workspace (sharing the catalog mesh)
+            PartShape shape;
+            shape.silhouette = meshCache[index].silhouette;
+            shape.mass = meshCache[index].shape;
+            shape.hull = meshCache[index].hull;
+
+            addPart(partWorld, index, mesh, shape, getPartPhysics(catalog[index].entry));
+            recordEdit();
+
+        }
+
+    }
+
+}
+
+// This void method assembles every part in the workspace onto the rocket, which empties the workspace. The parts stay where they are in the pools and are only marked as assembled
+void assembleComponents () {
+
+    PartWorld &world = partWorld;
+
+    if (world.assembled == world.size) {
+        return;
+    }
+
+    addPartPhysics(world, world.assembled, world.size, assemblyMass, assemblyHull, assemblyTotals);
+    assemblyPrediction = predictFlight(assemblyTotals, assemblyHull, assemblyMass);
+
+    // No part stays selected
+    PartPool<unsigned char>::Changes changed;
+
+    world.states = world.states.change([&](int part, unsigned char &state) {
+
+        if (part < world.assembled) {
+            return false;
+        }
+
+        state = PART_ASSEMBLED;
+
+        return true;
+
+    }, changed);
+
+    world.assembled = world.size;
+    recordEdit();
+
+}
+
+// This void method moves the workspace part numbered part by the given amounts (pre-setting a translation). Only the part's transform changes, in a new version of the transform pool; the shared mesh itself is never modified
+void setPreTranslate (int part, int nx, int ny, int nz) {
+
+    if (nx == 0 && ny == 0 && nz == 0) {
+        return;
+    }
+
+    Point3D transform = partWorld.transforms[part];
+
+    transform.x += nx;
+    transform.y += ny;
+    transform.z += nz;
+
+    partWorld.transforms = partWorld.transforms.set(part, transform);
+    recordEdit();
+
+}
+
+// This method formats a distance or speed as a whole number (printed from the double, so values beyond the range of an int, like the apoapsis of a nearly escaping orbit, still come out right)
+string formatWhole (double value) {
+
+    char text[64];
+    snprintf(text, sizeof(text), "%.0f", value);
+
+    return text;
+
+}
+
+// This void method draws the predicted launch of the assembly in the top right corner of the assembly screen
+void drawPrediction () {
+
+    const FlightPrediction &prediction = assemblyPrediction;
+
+    if (!prediction.valid) {
+        return;
+    }
+
+    string outcome;
+
+    if (prediction.outcome == FLIGHT_SPACE) {
+        outcome = "Reaches space";
+    } else if (prediction.outcome == FLIGHT_CRASHED) {
+        outcome = "Crashes";
+    } else if (prediction.outcome == FLIGHT_LANDED) {
+        outcome = prediction.maxAltitude < 1 ? "Does not lift off" : "Lands safely";
+    } else {
+        outcome = "Still flying after " + to_string((int) (predictionTime * 10)) + " seconds";
+    }
+
+    glColor3f(0.0, 0.0, 0.0);
+
+    // Simulation time runs at a tenth of a second per second
+    renderString(700, 970, GLUT_BITMAP_HELVETICA_12, "Predicted launch: " + outcome);
+    if (isinf(prediction.maxAltitude)) {
+        renderString(700, 945, GLUT_BITMAP_HELVETICA_12, "Max altitude: escapes the planet");
+    } else {
+        renderString(700, 945, GLUT_BITMAP_HELVETICA_12, "Max altitude: " + formatWhole(prediction.maxAltitude));
+        renderString(700, 920, GLUT_BITMAP_HELVETICA_12, "Time to max altitude: " + formatWhole(prediction.apogeeTime * 10) + " seconds");
+    }
+
+    if (prediction.spaceTime >= 0) {
+        renderString(700, 895, GLUT_BITMAP_HELVETICA_12, "Reaches space at t=" + formatWhole(prediction.spaceTime * 10) + " seconds");
+    }
+
+}
+
+// This void method draws the entire rocket assembly screen
+void drawRocketAssembly () {
+
+    // Draw a white background
+    glClearColor(1.0, 1.0, 1.0, 0.0);
+
+    // Draw every part: the completed assembly in black, and the workspace parts after it
+    glPushMatrix();
+
+        glMatrixMode(GL_MODELVIEW);
+
+        // Rotate the global perspective
+        glRotated(gpcx, 0, 1000, 0);
+        glRotated(gpcy, 1000, 0, 0);
+
+        drawParts(partWorld, 0, partWorld.size, 500, 500, 0, 0, 0, 0);
+
+    glPopMatrix();
+
+    // Mark the centre of mass of the assembly with a red dot
+    if (assemblyMass.mass > 0) {
+
+        glPushAttrib(GL_POINT_BIT);
+        glPushMatrix();
+
+            glMatrixMode(GL_MODELVIEW);
+
+            glRotated(gpcx, 0, 1000, 0);
+            glRotated(gpcy, 1000, 0, 0);
+
+            glPointSize(8);
+            glColor3d(1, 0, 0);
+
+            glBegin(GL_POINTS);
+            glVertex3d(500 + assemblyMass.centre.x, 500 + assemblyMass.centre.y, assemblyMass.centre.z);
+            glEnd();
+
+        glPopMatrix();
+        glPopAttrib();
+
+    }
+
+    // Show how the rocket would fly if it were launched now
+    drawPrediction();
+
+    // Draw the components menu
+    drawMenu();
+
+}
+
+// This void method draws the winning screen. Called when the player reaches "space" (a pre-determined height)
+void drawWinScreen () {
+
+    // Draw a black background
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+
+    // Render the winning text across the screen
+
+    // Set the draw color to white
+    glColor3f(1.0, 1.0, 1.0);
+
+    // Render the intro text as seperate lines
+    renderString(450, 450, GLUT_BITMAP_HELVETICA_18, "Congratulations! You successful made it to space!");
+    renderString(550, 350, GLUT_BITMAP_HELVETICA_18, "What will be the next frontier?");
+
+}
+
+// This void method draws the losing screen. Called when the player crashes their rocket during launch.
+void drawLosingScreen () {
+
+    // Draw a black background
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+
+    // Render the losing text across the screen
+
+    // Set the draw color to white
+    glColor3f(1.0, 1.0, 1.0);
+
+    // Render the intro text as seperate lines
+    renderString(610, 420, GLUT_BITMAP_HELVETICA_18, "Uh oh! Rocket crashed!");
+    renderString(550, 350, GLUT_BITMAP_HELVETICA_18, "Back to the drawing boards!");
+    renderString(550, 250, GLUT_BITMAP_HELVETICA_18, "Press SPACE to restart");
+
+
+}
+
+// How far above the pad the hull of a rocket stands at launch
+const double padClearance = 1e-3;
+
+// This method returns true if a hull at the given altitude, the given distance downrange of the launch site, touches the terrain (defined with the terrain further down)
+bool isTouchingGround (const ConvexHull &hull, double downrange, double altitude);
+
+// This method tilts a hull by pitch degrees (about the centre of mass, like the rocket is drawn) and stands it on the pad. level is set to the height the pad was at before (-200 without a hull)
+HullHandle getLaunchHull (const HullHandle &hull, const MassProperties &mass, double pitch, double &level) {
+
+    if (!hull || hull->vertices.empty()) {
+        level = -200;
+        return HullHandle();
+    }
+
+    double angle = pitch * pi / 180;
+    Point3D centre = mass.centre;
+
+    vector<Point3D> points;
+
+    for (const Point3D &p : hull->vertices) {
+
+        Point3D d = subtractP3D(p, centre);
+
+        points.push_back(Point3D{centre.x + d.x * cos(angle) + d.y * sin(angle), centre.y - d.x * sin(angle) + d.y * cos(angle), centre.z + d.z});
+
+    }
+
+    level = numeric_limits<double>::max();
+
+    for (const Point3D &p : points) {
+        level = min(level, p.y);
+    }
+
+    // Stand it just clear of the pad: GJK counts a hull resting on the ground as touching it, and a rocket on the pad has not touched down
+    for (Point3D &p : points) {
+        p.y -= level - padClearance;
+    }
+
+    HullHandle standing = buildConvexHull(points);
+
+    // Make sure it really is clear (the pad is flat, but the hull is rebuilt from the tilted points), raising it further if not
+    for (double raise=padClearance; standing && isTouchingGround(*standing, 0, 0) && raise < 1; raise *= 2) {
+
+        for (Point3D &p : points) {
+            p.y += raise;
+        }
+
+        standing = buildConvexHull(points);
+
+    }
+
+    return standing;
+
+}
+
+// This void method tilts the hull of the assembly by the launch pitch and stands it on the pad
+void updateLaunchHull () {
+    launchHull = getLaunchHull(assemblyHull, assemblyMass, launchPitch, padLevel);
+}
+
+// This void method sets up the constants for the current iteration of the rocket (assembly)
+void updateRocketPhysics () {
+
+    updateLaunchHull();
+
+    // Update the initial vertical velocity to the total starting thrust (the totals are summed from the parts' physics values as they are assembled)
+    v_vel = assemblyTotals.thrust;
+
+    // Reset vertical position (v_pos)
+    v_pos = 0;
+
+}
+
+// Altitude lookup tables - gravity and air density at any altitude are sampled from tables generated at compile time, so the simulation step pays for an interpolation instead of pow/exp calls
+
+// This struct is a list of integer indices as template arguments (used to expand one table entry per index)
+template <int... I>
+struct IndexList
+{
+};
+
+// This struct joins two index lists, offsetting the second by the length of the first
+template <class A, class B>
+struct JoinIndexLists;
+
+template <int... A, int... B>
+struct JoinIndexLists<IndexList<A...>, IndexList<B...> >
+{
+    typedef IndexList<A..., (int) sizeof...(A) + B...> type;
+};
+
+// This struct builds the index list 0 to N-1. It halves N at each level so that the template depth stays logarithmic
+template <int N>
+struct MakeIndexList
+{
+    typedef typename JoinIndexLists<typename MakeIndexList<N / 2>::type, typename MakeIndexList<N - N / 2>::type>::type type;
+};
+
+template <>
+struct MakeIndexList<0>
+{
+    typedef IndexList<> type;
+};
+
+template <>
+struct MakeIndexList<1>
+{
+    typedef IndexList<0> type;
+};
+
+// This method returns the Taylor series of e^x from the given term onwards (accurate for small x)
+constexpr double constExpSeries (double x, double term, int n) {
+    return n > 24 ? term : term + constExpSeries(x, term * x / n, n + 1);
+}
+
+// This method returns e^x at compile time. Large arguments are halved until the series converges quickly, then the result is squared back up
+constexpr double constExp (double x) {
+    return (x < -0.5 || x > 0.5) ? constExp(x / 2) * constExp(x / 2) : constExpSeries(x, 1, 1);
+}
+
+// The number of entries in each altitude table and the altitude they cover (from the ground up). Above the top of the tables the models are evaluated directly
+const int altitudeTableSize = 1024;
+constexpr double altitudeTableTop = 20000;
+constexpr double altitudeTableStep = altitudeTableTop / (altitudeTableSize - 1);
+
+// The gravity model: inverse square of the distance to the planet's centre
+struct GravityModel
+{
+    static constexpr double at (double altitude) {
+        return g_accl * (planetRadius / (planetRadius + altitude)) * (planetRadius / (planetRadius + altitude));
+    }
+
+    // The rate of change with altitude
+    static constexpr double slope (double altitude) {
+        return -2 * at(altitude) / (planetRadius + altitude);
+    }
+};
+
+// The atmosphere model: exponential air density, 1 at the ground
+struct AirDensityModel
+{
+    static constexpr double at (double altitude) {
+        return constExp(-altitude / atmosphereScaleHeight);
+    }
+
+    // The rate of change with altitude
+    static constexpr double slope (double altitude) {
+        return -at(altitude) / atmosphereScaleHeight;
+    }
+};
+
+// This struct is a table of a model sampled at evenly spaced altitudes
+template <int N>
+struct AltitudeTable
+{
+    double values[N];
+};
+
+// This method samples the model F at every index of the list (at compile time when used in a constexpr initializer)
+template <class F, int... I>
+constexpr AltitudeTable<sizeof...(I)> buildAltitudeTable (IndexList<I...>) {
+    return {{ F::at(I * altitudeTableStep)... }};
+}
+
+constexpr AltitudeTable<altitudeTableSize> gravityTable = buildAltitudeTable<GravityModel>(MakeIndexList<altitudeTableSize>::type());
+constexpr AltitudeTable<altitudeTableSize> airDensityTable = buildAltitudeTable<AirDensityModel>(MakeIndexList<altitudeTableSize>::type());
+
+static_assert(gravityTable.values[0] == g_accl, "gravity table must start at surface gravity");
+static_assert(airDensityTable.values[0] > 0.999999 && airDensityTable.values[0] < 1.000001, "air density table must start at 1");
+
+// Forward-mode automatic differentiation - a dual number carries a value along with its derivatives with respect to N inputs, and every operation on it applies the chain rule to them. The launch simulation is written for any scalar type, so running it on dual numbers instead of doubles gives the derivatives of the whole flight with respect to the inputs in the same single run
+
+// This struct is a dual number: a value and its derivatives (the gradient) with respect to N inputs
+template <int N>
+struct Dual
+{
+    double value;
+    double gradient[N];
+
+    Dual () {
+    }
+
+    // A constant (all derivatives 0)
+    Dual (double v) : value(v) {
+
+        for (int i=0; i<N; i++) {
+            gradient[i] = 0;
+        }
+
+    }
+};
+
+// This method returns input number i with the given value (its derivative with respect to itself is 1)
+template <int N>
+Dual<N> makeDualInput (double value, int i) {
+
+    Dual<N> r(value);
+    r.gradient[i] = 1;
+    return r;
+
+}
+
+// This method returns f(x) given f(x) and f'(x) (the chain rule)
+template <int N>
+inline Dual<N> applyChainRule (const Dual<N> &x, double value, double derivative) {
+
+    Dual<N> r;
+    r.value = value;
+
+    for (int i=0; i<N; i++) {
+        r.gradient[i] = derivative * x.gradient[i];
+    }
+
+    return r;
+
+}
+
+// The arithmetic operators of dual numbers (each with the product, quotient or sum rule), with doubles mixed in as constants
+template <int N>
+inline Dual<N> operator- (const Dual<N> &a) {
+    return applyChainRule(a, -a.value, -1);
+}
+
+template <int N>
+inline Dual<N> operator+ (const Dual<N> &a, const Dual<N> &b) {
+
+    Dual<N> r;
+    r.value = a.value + b.value;
+
+    for (int i=0; i<N; i++) {
+        r.gradient[i] = a.gradient[i] + b.gradient[i];
+    }
+
+    return r;
+
+}
+
+template <int N>
+inline Dual<N> operator- (const Dual<N> &a, const Dual<N> &b) {
+
+    Dual<N> r;
+    r.value = a.value - b.value;
+
+    for (int i=0; i<N; i++) {
+        r.gradient[i] = a.gradient[i] - b.gradient[i];
+    }
+
+    return r;
+
+}
+
+template <int N>
+inline Dual<N> operator* (const Dual<N> &a, const Dual<N> &b) {
+
+    Dual<N> r;
+    r.value = a.value * b.value;
+
+    for (int i=0; i<N; i++) {
+        r.gradient[i] = a.gradient[i] * b.value + a.value * b.gradient[i];
+    }
+
+    return r;
+
+}
+
+template <int N>
+inline Dual<N> operator/ (const Dual<N> &a, const Dual<N> &b) {
+
+    Dual<N> r;
+    r.value = a.value / b.value;
+
+    for (int i=0; i<N; i++) {
+        r.gradient[i] = (a.gradient[i] - r.value * b.gradient[i]) / b.value;
+    }
+
+    return r;
+
+}
+
+template <int N>
+inline Dual<N> operator+ (const Dual<N> &a, double b) {
+    return applyChainRule(a, a.value + b, 1);
+}
+
+template <int N>
+inline Dual<N> operator+ (double a, const Dual<N> &b) {
+    return applyChainRule(b, a + b.value, 1);
+}
+
+template <int N>
+inline Dual<N> operator- (const Dual<N> &a, double b) {
+    return applyChainRule(a, a.value - b, 1);
+}
+
+template <int N>
+inline Dual<N> operator- (double a, const Dual<N> &b) {
+    return applyChainRule(b, a - b.value, -1);
+}
+
+template <int N>
+inline Dual<N> operator* (const Dual<N> &a, double b) {
+    return applyChainRule(a, a.value * b, b);
+}
+
+template <int N>
+inline Dual<N> operator* (double a, const Dual<N> &b) {
+    return applyChainRule(b, a * b.value, a);
+}
+
+template <int N>
+inline Dual<N> operator/ (const Dual<N> &a, double b) {
+    return applyChainRule(a, a.value / b, 1 / b);
+}
+
+template <int N>
+inline Dual<N> operator/ (double a, const Dual<N> &b) {
+    return applyChainRule(b, a / b.value, -a / (b.value * b.value));
+}
+
+template <int N>
+inline Dual<N> &operator+= (Dual<N> &a, const Dual<N> &b) {
+    return a = a + b;
+}
+
+template <int N>
+inline Dual<N> &operator-= (Dual<N> &a, const Dual<N> &b) {
+    return a = a - b;
+}
+
+// Dual numbers compare by their values
+template <int N>
+inline bool operator< (const Dual<N> &a, double b) {
+    return a.value < b;
+}
+
+template <int N>
+inline bool operator> (const Dual<N> &a, double b) {
+    return a.value > b;
+}
+
+template <int N>
+inline bool operator<= (const Dual<N> &a, double b) {
+    return a.value <= b;
+}
+
+// The functions the launch simulation needs, for dual numbers
+template <int N>
+inline Dual<N> sqrt (const Dual<N> &x) {
+
+    double root = sqrt(x.value);
+    return applyChainRule(x, root, root > 0 ? 0.5 / root : 0);
+
+}
+
+template <int N>
+inline Dual<N> sin (const Dual<N> &x) {
+    return applyChainRule(x, sin(x.value), cos(x.value));
+}
+
+template <int N>
+inline Dual<N> cos (const Dual<N> &x) {
+    return applyChainRule(x, cos(x.value), -sin(x.value));
+}
+
+// These methods return the value of a scalar (without the derivatives of a dual number)
+inline double getValue (double x) {
+    return x;
+}
+
+template <int N>
+inline double getValue (const Dual<N> &x) {
+    return x.value;
+}
+
+// These methods evaluate the model F directly (used above the altitude tables)
+template <class F>
+inline double evaluateModel (double altitude) {
+    return F::at(altitude);
+}
+
+template <class F, int N>
+inline Dual<N> evaluateModel (const Dual<N> &altitude) {
+    return applyChainRule(altitude, F::at(altitude.value), F::slope(altitude.value));
+}
+
+// This method linearly interpolates an altitude table. Altitudes below the ground use the first entry, and altitudes above the table use the model itself
+template <class F, class T>
+inline T sampleAltitudeTable (const AltitudeTable<altitudeTableSize> &table, const T &altitude) {
+
+    if (altitude <= 0) {
+        return T(table.values[0]);
+    }
+
+    T position = altitude * (1.0 / altitudeTableStep);
+    int index = (int) getValue(position);
+
+    if (index >= altitudeTableSize - 1) {
+        return evaluateModel<F>(altitude);
+    }
+
+    T t = position - index;
+
+    return table.values[index] + (table.values[index + 1] - table.values[index]) * t;
+
+}
+
+// This method returns the gravitational acceleration at the given altitude
+template <class T>
+inline T getGravity (const T &altitude) {
+    return sampleAltitudeTable<GravityModel>(gravityTable, altitude);
+}
+
+// This method returns the air density at the given altitude (1 at the ground)
+template <class T>
+inline T getAirDensity (const T &altitude) {
+    return sampleAltitudeTable<AirDensityModel>(airDensityTable, altitude);
+}
+
+// This struct is the state of the rocket during the launch simulation (also used for its rate of change), with any scalar type T. The flight is in the plane through the planet's centre and the launch site, in polar coordinates around the centre
+template <class T>
+struct BasicFlightState
+{
+    // Vertical position (the altitude) and velocity
+    T pos;
+    T vel;
+    // The remaining additional acceleration along the rocket (worn down by drag)
+    T lift;
+
+    // How far the rocket has gone around the planet (radians from the launch site) and its horizontal velocity. Both stay 0 for a rocket launched straight up
+    T angle;
+    T hvel;
+};
+
+typedef BasicFlightState<double> FlightState;
+
+// This method returns a + b * h for flight states (used to build the intermediate stages of the integrators)
+template <class T>
+BasicFlightState<T> addScaled (const BasicFlightState<T> &a, const BasicFlightState<T> &b, double h) {
+
+    BasicFlightState<T> r;
+    r.pos = a.pos + b.pos * h;
+    r.vel = a.vel + b.vel * h;
+    r.lift = a.lift + b.lift * h;
+    r.angle = a.angle + b.angle * h;
+    r.hvel = a.hvel + b.hvel * h;
+    return r;
+
+}
+
+// This struct holds the constant values of the rocket used by the launch simulation, with any scalar type T
+template <class T>
+struct BasicFlightParams
+{
+    // How fast the lift wears off
+    T drag;
+    // The total mass and the air drag area (drag coefficient times frontal area) of the rocket
+    T mass;
+    T dragArea;
+    // The angle of the rocket from the vertical, towards downrange (radians). Lift pushes along the rocket
+    T pitch;
+    // The rocket's convex hull as it stood on the pad (with the pad at height 0), for the ground contact tests. Without one, the rocket touches the ground when its altitude goes below 0
+    HullHandle hull;
+};
+
+typedef BasicFlightParams<double> FlightParams;
+
+// This method returns the rate of change of the flight state: gravity always pulls the rocket down (weaker further up), the air slows it down (less further up), lift pushes it along the rocket while there is any left, and drag wears the lift down at a constant rate until it is gone. Moving sideways around a round planet adds the centrifugal and Coriolis terms of the polar coordinates (both 0 for a vertical flight)
+template <class T>
+BasicFlightState<T> getFlightDerivative (const BasicFlightState<T> &state, const BasicFlightParams<T> &params) {
+
+    T radius = planetRadius + state.pos;
+
+    BasicFlightState<T> d;
+    d.pos = state.vel;
+    d.vel = getGravity(state.pos) + state.hvel * state.hvel / radius;
+    d.lift = 0;
+    d.angle = state.hvel / radius;
+    d.hvel = -state.vel * state.hvel / radius;
+
+    // Air resistance: half the air density times the speed squared times the drag area, against the direction of motion
+    if (params.mass > 0) {
+
+        T speed = sqrt(state.vel * state.vel + state.hvel * state.hvel);
+        T resistance = 0.5 * getAirDensity(state.pos) * speed * params.dragArea / params.mass;
+
+        d.vel -= resistance * state.vel;
+        d.hvel -= resistance * state.hvel;
+
+    }
+
+    if (state.lift > 0) {
+        d.vel += state.lift * cos(params.pitch);
+        d.hvel += state.lift * sin(params.pitch);
+        d.lift = -params.drag * liftDecayRate;
+    }
+
+    return d;
+
+}
+
+// This void method keeps the lift from going below zero (drag should only decrease additional vertical acceleration)
+template <class T>
+void clampLift (BasicFlightState<T> &state) {
+
+    if (state.lift < 0) {
+        state.lift = T(0);
+    }
+
+}
+
+// The step size of the fixed step integrators, and the starting step of the adaptive one, in units of simulation time (one frame at 60 frames per second). Set with --flight-step
+double flightStep = 1.0 / 600;
+
+// The interface shared by every launch integrator: try to advance the state by h, and return the time actually advanced, setting nextH to the step to try next. Adaptive integrators may advance by less than h when their error estimate requires it, and pick nextH to match it; fixed step integrators always take h and set nextH to flightStep (h may have been cut short to end on time)
+typedef double (*FlightIntegrator) (FlightState &state, const FlightParams &params, double h, double &nextH);
+
+// Explicit Euler (the original simulation): both position and velocity use the rates at the start of the step
+double stepExplicitEuler (FlightState &state, const FlightParams &params, double h, double &nextH) {
+
+    FlightState d = getFlightDerivative(state, params);
+
+    state = addScaled(state, d, h);
+    clampLift(state);
+
+    nextH = flightStep;
+
+    return h;
+
+}
+
+// Semi-implicit (symplectic) Euler: the velocity is updated first and the new velocity moves the position
+double stepSemiImplicitEuler (FlightState &state, const FlightParams &params, double h, double &nextH) {
+
+    FlightState d = getFlightDerivative(state, params);
+
+    state.vel += d.vel * h;
+    state.hvel += d.hvel * h;
+    state.pos += state.vel * h;
+    state.angle += state.hvel / (planetRadius + state.pos) * h;
+    state.lift += d.lift * h;
+    clampLift(state);
+
+    nextH = flightStep;
+
+    return h;
+
+}
+
+// Classic fourth order Runge-Kutta
+double stepRK4 (FlightState &state, const FlightParams &params, double h, double &nextH) {
+
+    FlightState k1 = getFlightDerivative(state, params);
+    FlightState k2 = getFlightDerivative(addScaled(state, k1, h / 2), params);
+    FlightState k3 = getFlightDerivative(addScaled(state, k2, h / 2), params);
+    FlightState k4 = getFlightDerivative(addScaled(state, k3, h), params);
+
+    state.pos += h / 6 * (k1.pos + 2 * k2.pos + 2 * k3.pos + k4.pos);
+    state.vel += h / 6 * (k1.vel + 2 * k2.vel + 2 * k3.vel + k4.vel);
+    state.lift += h / 6 * (k1.lift + 2 * k2.lift + 2 * k3.lift + k4.lift);
+    state.angle += h / 6 * (k1.angle + 2 * k2.angle + 2 * k3.angle + k4.angle);
+    state.hvel += h / 6 * (k1.hvel + 2 * k2.hvel + 2 * k3.hvel + k4.hvel);
+    clampLift(state);
+
+    nextH = flightStep;
+
+    return h;
+
+}
+
+// The error tolerance of the adaptive integrator (absolute and relative, per state component). Set with --flight-tolerance
+double flightTolerance = 1e-6;
+
+// Adaptive Runge-Kutta 4(5) (Dormand-Prince), with any scalar type T (the step sizes follow the values only): the fifth order solution is kept and its difference to the embedded fourth order one estimates the error. Steps that are too inaccurate are retried smaller, and the next step grows or shrinks to match the tolerance
+template <class T>
+double integrateRK45 (BasicFlightState<T> &state, const BasicFlightParams<T> &params, double h, double &nextH) {
+
+    while (true) {
+
+        BasicFlightState<T> k1 = getFlightDerivative(state, params);
+
+        BasicFlightState<T> y2 = addScaled(state, k1, h / 5);
+        BasicFlightState<T> k2 = getFlightDerivative(y2, params);
+
+        BasicFlightState<T> y3 = addScaled(addScaled(state, k1, h * 3 / 40), k2, h * 9 / 40);
+        BasicFlightState<T> k3 = getFlightDerivative(y3, params);
+
+        BasicFlightState<T> y4 = addScaled(addScaled(addScaled(state, k1, h * 44 / 45), k2, -h * 56 / 15), k3, h * 32 / 9);
+        BasicFlightState<T> k4 = getFlightDerivative(y4, params);
+
+        BasicFlightState<T> y5 = addScaled(addScaled(addScaled(addScaled(state, k1, h * 19372 / 6561), k2, -h * 25360 / 2187), k3, h * 64448 / 6561), k4, -h * 212 / 729);
+        BasicFlightState<T> k5 = getFlightDerivative(y5, params);
+
+        BasicFlightState<T> y6 = addScaled(addScaled(addScaled(addScaled(addScaled(state, k1, h * 9017 / 3168), k2, -h * 355 / 33), k3, h * 46732 / 5247), k4, h * 49 / 176), k5, -h * 5103 / 18656);
+        BasicFlightState<T> k6 = getFlightDerivative(y6, params);
+
+        // The fifth order solution
+        BasicFlightState<T> y = addScaled(addScaled(addScaled(addScaled(addScaled(state, k1, h * 35 / 384), k3, h * 500 / 1113), k4, h * 125 / 192), k5, -h * 2187 / 6784), k6, h * 11 / 84);
+        BasicFlightState<T> k7 = getFlightDerivative(y, params);
+
+        // The difference to the embedded fourth order solution
+        double e1 = 71.0 / 57600, e3 = -71.0 / 16695, e4 = 71.0 / 1920, e5 = -17253.0 / 339200, e6 = 22.0 / 525, e7 = -1.0 / 40;
+
+        BasicFlightState<T> err;
+        err.pos = h * (e1 * k1.pos + e3 * k3.pos + e4 * k4.pos + e5 * k5.pos + e6 * k6.pos + e7 * k7.pos);
+        err.vel = h * (e1 * k1.vel + e3 * k3.vel + e4 * k4.vel + e5 * k5.vel + e6 * k6.vel + e7 * k7.vel);
+        err.lift = h * (e1 * k1.lift + e3 * k3.lift + e4 * k4.lift + e5 * k5.lift + e6 * k6.lift + e7 * k7.lift);
+        err.angle = h * (e1 * k1.angle + e3 * k3.angle + e4 * k4.angle + e5 * k5.angle + e6 * k6.angle + e7 * k7.angle);
+        err.hvel = h * (e1 * k1.hvel + e3 * k3.hvel + e4 * k4.hvel + e5 * k5.hvel + e6 * k6.hvel + e7 * k7.hvel);
+
+        // The largest error relative to the tolerance
+        double ratio = max(fabs(getValue(err.pos)) / (flightTolerance * (1 + fabs(getValue(y.pos)))),
+                       max(fabs(getValue(err.vel)) / (flightTolerance * (1 + fabs(getValue(y.vel)))),
+                           fabs(getValue(err.lift)) / (flightTolerance * (1 + fabs(getValue(y.lift))))));
+
+        ratio = max(ratio, max(fabs(getValue(err.angle)) / (flightTolerance * (1 + fabs(getValue(y.angle)))),
+                               fabs(getValue(err.hvel)) / (flightTolerance * (1 + fabs(getValue(y.hvel))))));
+
+        // Scale the step by the usual safety factor, within 0.2 to 5 times the current one
+        double scale = ratio > 0 ? 0.9 * pow(ratio, -0.2) : 5;
+        scale = max(0.2, min(5.0, scale));
+
+        if (ratio <= 1 || h < 1e-9) {
+
+            state = y;
+            clampLift(state);
+
+            nextH = h * scale;
+            return h;
+
+        }
+
+        h *= scale;
+
+    }
+
+}
+
+// The adaptive Runge-Kutta 4(5) integrator on doubles
+double stepRK45 (FlightState &state, const FlightParams &params, double h, double &nextH) {
+    return integrateRK45(state, params, h, nextH);
+}
+
+// The available integrators (selected with --integrator euler|semi|rk4|rk45)
+FlightIntegrator flightIntegrator = stepRK45;
+
+// This method returns whether the rocket in the given state is clear of the ground (FLIGHT_ACTIVE), or has touched it: FLIGHT_LANDED if slowly enough, FLIGHT_CRASHED if not (defined with the terrain further down)
+int getGroundContact (const FlightState &state, const FlightParams &params);
+
+// This method returns the outcome of a flight in the given state
+int getFlightOutcome (const FlightState &state, const FlightParams &params) {
+
+    int contact = getGroundContact(state, params);
+
+    if (contact != FLIGHT_ACTIVE) {
+        return contact;
+    } else if (state.pos >= spaceHeight) {
+        return FLIGHT_SPACE;
+    }
+
+    return FLIGHT_ACTIVE;
+
+}
+
+// This method advances the flight state by duration with the selected integrator, stopping early if the rocket crashes or reaches space. adaptiveStep is the caller's step size (carried from call to call, and only changed by the adaptive integrator). Returns the number of steps taken
+int advanceFlight (FlightState &state, const FlightParams &params, double duration, double &adaptiveStep) {
+
+    int steps = 0;
+    double elapsed = 0;
+
+    while (elapsed < duration && getFlightOutcome(state, params) == FLIGHT_ACTIVE) {
+
+        elapsed += flightIntegrator(state, params, min(adaptiveStep, duration - elapsed), adaptiveStep);
+        steps++;
+
+    }
+
+    return steps;
+
+}
+
+// This struct is the result of simulating an entire flight, with any scalar type T (the highest altitude carries its derivatives on dual numbers)
+template <class T>
+struct BasicFlightResult
+{
+    int outcome;
+    T maxAltitude;
+    // The time the highest altitude was reached
+    double apogeeTime;
+    // The time space height was reached (-1 if it was not)
+    double spaceTime;
+    double time;
+    int steps;
+};
+
+typedef BasicFlightResult<double> FlightResult;
+
+// These methods return the value of a flight state or flight values (without the derivatives of dual numbers)
+inline const FlightState &getValue (const FlightState &state) {
+    return state;
+}
+
+inline const FlightParams &getValue (const FlightParams &params) {
+    return params;
+}
+
+template <int N>
+FlightState getValue (const BasicFlightState<Dual<N> > &state) {
+
+    FlightState r;
+    r.pos = state.pos.value;
+    r.vel = state.vel.value;
+    r.lift = state.lift.value;
+    r.angle = state.angle.value;
+    r.hvel = state.hvel.value;
+    return r;
+
+}
+
+template <int N>
+FlightParams getValue (const BasicFlightParams<Dual<N> > &params) {
+
+    FlightParams r;
+    r.drag = params.drag.value;
+    r.mass = params.mass.value;
+    r.dragArea = params.dragArea.value;
+    r.pitch = params.pitch.value;
+    r.hull = params.hull;
+    return r;
+
+}
+
+// This method takes one step of a simulated flight on doubles with the selected integrator, no longer than limit. adaptiveStep is the step size to try (carried from step to step, and only changed by the adaptive integrator). Returns the time taken
+inline double stepFlight (FlightState &state, const FlightParams &params, double limit, double &adaptiveStep) {
+
+    return flightIntegrator(state, params, min(adaptiveStep, limit), adaptiveStep);
+
+}
+
+// This method takes one step of a simulated flight on dual numbers, always with the adaptive integrator (the others only take doubles)
+template <int N>
+inline double stepFlight (BasicFlightState<Dual<N> > &state, const BasicFlightParams<Dual<N> > &params, double limit, double &adaptiveStep) {
+    return integrateRK45(state, params, min(adaptiveStep, limit), adaptiveStep);
+}
+
+// This method returns true if a rocket in the given state can coast on rails (defined with the orbits further down)
+bool canCoast (const FlightState &state);
+
+// This method works out the highest altitude a rocket coasting on rails in the given state reaches along its orbit (its apoapsis), and how long it takes to get there from the mean anomaly now, with the orbit worked out as in getOrbit. Both are infinity if it escapes the planet
+template <class T>
+void getCoastApogee (const BasicFlightState<T> &state, T &apogee, double &rise) {
+
+    T radius = planetRadius + state.pos;
+    T alpha = 2 / radius - (state.vel * state.vel + state.hvel * state.hvel) / gravityParameter;
+
+    if (alpha <= 0) {
+        apogee = T(numeric_limits<double>::infinity());
+        rise = numeric_limits<double>::infinity();
+        return;
+    }
+
+    // e cos E and e sin E, for the eccentricity and the eccentric anomaly now (the apoapsis is at E = pi)
+    T ecos = 1 - radius * alpha;
+    T esin = radius * state.vel * sqrt(alpha / gravityParameter);
+
+    apogee = (1 + sqrt(ecos * ecos + esin * esin)) / alpha - planetRadius;
+
+    double meanNow = atan2(getValue(esin), getValue(ecos)) - getValue(esin);
+    double ahead = fmod(pi - meanNow + 2 * pi, 2 * pi);
+
+    rise = ahead / sqrt(gravityParameter * getValue(alpha) * getValue(alpha) * getValue(alpha));
+
+}
+
+// This method simulates an entire flight from the given state until it touches the ground or runs out of time (used to evaluate designs without drawing them), on doubles or on dual numbers (to tune components, see simulateFlightGradient). The flight goes on past space height; once the rocket coasts above the air, the rest of its climb is taken from its orbit, as it would be on rails
+template <class T>
+BasicFlightResult<T> simulateFlight (BasicFlightState<T> state, const BasicFlightParams<T> &params, double maxTime) {
+
+    // The ground contact and coasting tests only need the values
+    const FlightParams &values = getValue(params);
+
+    BasicFlightResult<T> result;
+    result.maxAltitude = state.pos;
+    result.apogeeTime = 0;
+    result.spaceTime = -1;
+    result.time = 0;
+    result.steps = 0;
+
+    double adaptiveStep = flightStep;
+
+    while (result.time < maxTime && getGroundContact(getValue(state), values) == FLIGHT_ACTIVE) {
+
+        // Nothing but gravity acts from here on: the orbit gives the apogee (if the rocket is still climbing), and nothing after it changes the outcome
+        if (canCoast(getValue(state))) {
+
+            if (getValue(state.vel) > 0) {
+
+                T apogee;
+                double rise;
+                getCoastApogee(state, apogee, rise);
+
+                if (getValue(apogee) > getValue(result.maxAltitude)) {
+                    result.maxAltitude = apogee;
+                    result.apogeeTime = result.time + rise;
+                }
+
+            }
+
+            break;
+
+        }
+
+        BasicFlightState<T> previous = state;
+
+        double taken = stepFlight(state, params, maxTime - result.time, adaptiveStep);
+        result.time += taken;
+        result.steps++;
+
+        double pos = getValue(state.pos);
+        double lastPos = getValue(previous.pos);
+        double vel = getValue(state.vel);
+        double lastVel = getValue(previous.vel);
+
+        if (pos > getValue(result.maxAltitude)) {
+            result.maxAltitude = state.pos;
+            result.apogeeTime = result.time;
+        }
+
+        // Large (adaptive) steps can jump over the apogee. When the velocity changes sign, find the top assuming constant acceleration over the step (exact once the lift is gone; the derivatives follow the same formula)
+        if (lastVel > 0 && vel <= 0) {
+
+            T top = previous.pos + previous.vel * previous.vel * taken / (2 * (previous.vel - state.vel));
+
+            if (getValue(top) > getValue(result.maxAltitude)) {
+                result.maxAltitude = top;
+                result.apogeeTime = result.time - taken + lastVel * taken / (lastVel - vel);
+            }
+
+        }
+
+        // The first time the rocket passes space height (linearly over the step)
+        if (result.spaceTime < 0 && lastPos < spaceHeight && pos >= spaceHeight) {
+            result.spaceTime = result.time - taken * (pos - spaceHeight) / (pos - lastPos);
+        }
+
+    }
+
+    result.outcome = result.spaceTime >= 0 ? FLIGHT_SPACE : getGroundContact(getValue(state), values);
+
+    return result;
+
+}
+
+// This method returns the constant flight values of the current rocket (assembly)
+FlightParams getFlightParams () {
+
+    FlightParams params;
+    params.drag = assemblyTotals.drag;
+    params.mass = assemblyTotals.mass;
+    params.dragArea = assemblyTotals.dragArea;
+    params.pitch = launchPitch * pi / 180;
+    params.hull = launchHull;
+    return params;
+
+}
+
+// This void method sets up the launch of a rocket from the pad at the current launch pitch, given the totals of its mass, thrust, lift and drag (of any scalar type T), its drag area and its hull as it stands on the pad
+template <class T>
+void getLaunchStart (const T &mass, const T &thrust, const T &lift, const T &drag, double dragArea, const HullHandle &hull, BasicFlightState<T> &state, BasicFlightParams<T> &params) {
+
+    double pitch = launchPitch * pi / 180;
+
+    params.drag = drag;
+    params.mass = mass;
+    params.dragArea = T(dragArea);
+    params.pitch = T(pitch);
+    params.hull = hull;
+
+    // Thrust is the initial velocity along the rocket, and lift the initial acceleration
+    state.pos = T(0);
+    state.vel = thrust * cos(pitch);
+    state.lift = lift;
+    state.angle = T(0);
+    state.hvel = thrust * sin(pitch);
+
+}
+
+// This method predicts the launch of an assembly with the given totals, convex hull and mass properties: the whole flight is simulated ahead, from the pad at the current launch pitch, the same way the launch will be. The result is kept with the assembly, so this only runs when the assembly changes
+FlightPrediction predictFlight (const AssemblyTotals &totals, const HullHandle &hull, const MassProperties &mass) {
+
+    FlightPrediction prediction = FlightPrediction();
+
+    if (totals.parts == 0) {
+        return prediction;
+    }
+
+    double level;
+
+    FlightState state;
+    FlightParams params;
+    getLaunchStart(totals.mass, totals.thrust, totals.lift, totals.drag, totals.dragArea, getLaunchHull(hull, mass, launchPitch, level), state, params);
+
+    FlightResult result = simulateFlight(state, params, predictionTime);
+
+    prediction.valid = true;
+    prediction.outcome = result.outcome;
+    prediction.maxAltitude = result.maxAltitude;
+    prediction.apogeeTime = result.apogeeTime;
+    prediction.spaceTime = result.spaceTime;
+
+    return prediction;
+
+}
+
+// Tuning - the launch simulation run on dual numbers gives the highest altitude of a flight together with its derivatives with respect to the rocket's values, so a part can be tuned to reach a target altitude with Newton's method in a handful of simulations instead of searching over its values
+
+// The values of the rocket the derivatives of a flight are taken with respect to: the totals of its mass, thrust, lift and drag. Every part adds its own values to the totals, so the derivative with respect to a value of any one part is the derivative with respect to that total
+const int TUNE_MASS = 0;
+const int TUNE_THRUST = 1;
+const int TUNE_LIFT = 2;
+const int TUNE_DRAG = 3;
+
+// A dual number carrying the derivatives with respect to the four totals
+typedef Dual<4> FlightDual;
+
+// The result of simulating a flight on dual numbers: the highest altitude comes with its derivatives
+typedef BasicFlightResult<FlightDual> FlightGradient;
+
+// This method simulates the launch of a rocket with the given totals and hull on the pad on dual numbers, with the adaptive integrator
+FlightGradient simulateFlightGradient (const AssemblyTotals &totals, const HullHandle &hull, double maxTime) {
+
+    BasicFlightState<FlightDual> state;
+    BasicFlightParams<FlightDual> params;
+    getLaunchStart(makeDualInput<4>(totals.mass, TUNE_MASS), makeDualInput<4>(totals.thrust, TUNE_THRUST), makeDualInput<4>(totals.lift, TUNE_LIFT), makeDualInput<4>(totals.drag, TUNE_DRAG), totals.dragArea, hull, state, params);
+
+    return simulateFlight(state, params, maxTime);
+
+}
+
+// The most simulations the tuner runs, and how close to the target altitude is close enough
+const int maxTuneSimulations = 30;
+const double tuneTolerance = 0.5;
+
+// This method returns one of the values (TUNE_MASS etc.) of anything with a mass, thrust, lift and drag (a catalog entry, the physics engine values of a part or the totals of an assembly)
+template <class T>
+auto getTuneValue (T &values, int value) -> decltype((values.mass)) {
+
+    switch (value) {
+        case TUNE_MASS:
+            return values.mass;
+        case TUNE_THRUST:
+            return values.thrust;
+        case TUNE_LIFT:
+            return values.lift;
+        default:
+            return values.drag;
+    }
+
+}
+
+// This method finds the value (TUNE_MASS etc.) of catalog entry index that makes the rocket built from parts reach the target altitude. Each simulation gives the highest altitude and its derivative with respect to the value, and Newton's method steps to where the altitude would meet the target if it changed linearly. simulations is set to the number of simulations run, and altitude to the highest altitude reached with the tuned value. Returns the tuned value, or the closest one found if the target cannot be reached
+double tuneComponent (const PartWorld &parts, int index, int value, double target, int &simulations, double &altitude) {
+
+    AssemblyTotals totals = AssemblyTotals();
+    MassProperties mass = MassProperties();
+    HullHandle hull;
+
+    addPartPhysics(parts, 0, parts.size, mass, hull, totals);
+
+    // The tuned value of the entry, and how many parts of the rocket use the entry
+    double tuned = 0;
+    int copies = 0;
+
+    for (int run=0; run<parts.size; run=getRunEnd(run, parts.size)) {
+
+        const int *catalogIndices = parts.catalogIndices.getRun(run);
+        const PartPhysics *physics = parts.physics.getRun(run);
+
+        for (int k=0; k<getRunEnd(run, parts.size)-run; k++) {
+            if (catalogIndices[k] == index) {
+                tuned = getTuneValue(physics[k], value);
+                copies++;
+            }
+        }
+
+    }
+
+    double level;
+    HullHandle launchHull = getLaunchHull(hull, mass, launchPitch, level);
+
+    // The total without the tuned entry's share
+    double rest = getTuneValue(totals, value) - copies * tuned;
+
+    double best = tuned;
+    double bestError = numeric_limits<double>::max();
+
+    simulations = 0;
+    altitude = 0;
+
+    double lastAltitude = 0;
+    double lastChange = 0;
+
+    while (copies > 0 && simulations < maxTuneSimulations) {
+
+        getTuneValue(totals, value) = rest + copies * tuned;
+
+        FlightGradient flight = simulateFlightGradient(totals, launchHull, predictionTime);
+        simulations++;
+
+        double error = flight.maxAltitude.value - target;
+
+        if (fabs(error) < bestError) {
+            best = tuned;
+            bestError = fabs(error);
+            altitude = flight.maxAltitude.value;
+        }
+
+        // Close enough, or the steps have stopped changing the altitude, by less each time (it is levelling off short of the target)
+        double change = simulations > 1 ? fabs(flight.maxAltitude.value - lastAltitude) : 0;
+
+        if (fabs(error) < tuneTolerance || (change < tuneTolerance && change < lastChange)) {
+            break;
+        }
+
+        lastAltitude = flight.maxAltitude.value;
+        lastChange = change;
+
+        double slope = copies * flight.maxAltitude.gradient[value];
+
+        // The value no longer makes any difference (the rocket never lifts off, or escapes the planet, say)
+        if (slope == 0) {
+            break;
+        }
+
+        double next = tuned - error / slope;
+
+        // Values cannot go below 0, and the linear guess is not trusted for more than four times the current value
+        if (next <= 0) {
+            next = tuned / 2;
+        } else if (tuned > 0 && next > tuned * 4) {
+            next = tuned * 4;
+        }
+
+        tuned = next;
+
+    }
+
+    return best;
+
+}
+
+// This method returns the catalog a command line tool works on: the components text file given with --components, or else the shared catalog given with --shared-catalog (which is attached), or else the built-in catalog, or else Components.txt. Returns an empty catalog if the shared catalog cannot be attached
+vector<ComponentEntry> getToolCatalog (int argc, char **argv) {
+
+    string fileName = componentsFileName;
+    bool external = false;
+
+    for (int i=1; i+1<argc; i++) {
+
+        string arg = argv[i];
+
+        if (arg == "--components") {
+
+            fileName = argv[++i];
+            external = true;
+
+        } else if (arg == "--shared-catalog" && !sharedCatalog.base) {
+
+            if (!attachSharedCatalog(getSharedSegmentName(argv[++i]), sharedCatalog)) {
+                cout << "Could not attach the shared catalog " << argv[i] << endl;
+                return vector<ComponentEntry>();
+            }
+
+        }
+
+    }
+
+    if (external || getBuiltInCount() == 0) {
+        return parseComponents(fileName);
+    }
+
+    vector<ComponentEntry> entries;
+
+    for (int i=0; i<getBuiltInCount(); i++) {
+        entries.push_back(getBuiltInInfo(i).entry);
+    }
+
+    return entries;
+
+}
+
+// This method tunes a component from the command line and prints the result (KSP --tune <entry> <mass|thrust|lift|drag> <target altitude> <part> [<part> ...]). The rocket is built from the listed parts and the given value of the entry is tuned; entries and parts are numbered from 1 as in the menu. Uses the catalog picked by getToolCatalog. Returns false if the arguments or the catalog cannot be used
+bool runTuner (int argc, char **argv) {
+
+    int entry = -1;
+    int value = -1;
+    double target = 0;
+    vector<int> rocket;
+
+    for (int i=1; i<argc; i++) {
+
+        string arg = argv[i];
+
+        if (arg == "--tune" && i + 3 < argc) {
+
+            string names[] = {"mass", "thrust", "lift", "drag"};
+
+            entry = atoi(argv[++i]) - 1;
+            string name = argv[++i];
+            target = atof(argv[++i]);
+
+            for (int k=0; k<4; k++) {
+                if (name == names[k]) {
+                    value = k;
+                }
+            }
+
+            // The parts of the rocket follow, up to the next option
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                rocket.push_back(atoi(argv[++i]) - 1);
+            }
+
+        }
+
+    }
+
+    vector<ComponentEntry> entries = getToolCatalog(argc, argv);
+
+    if (value < 0 || rocket.empty()) {
+        cout << "Usage: KSP --tune <entry> <mass|thrust|lift|drag> <target altitude> <part> [<part> ...]" << endl;
+        return false;
+    }
+
+    // Build the rocket, loading each component's mesh once
+    vector<MeshHandle> meshes(entries.size());
+    PartWorld parts;
+
+    for (int index : rocket) {
+
+        if (index < 0 || index >= (int) entries.size()) {
+            cout << "There is no component " << index + 1 << " in the catalog" << endl;
+            return false;
+        }
+
+        const ComponentEntry &component = entries[index];
+
+        PartShape shape;
+
+        if (sharedCatalog.base && component.embedded >= 0) {
+
+            // The publisher has worked out everything the flight needs, and nothing is drawn, so the meshes are left in the segment
+            if (!meshes[index]) {
+                meshes[index] = make_shared<const vector<Object> >();
+            }
+
+            shape.silhouette = getSharedSilhouette(component.embedded);
+            shape.mass = getSharedMassProperties(component.embedded);
+            shape.hull = getSharedHull(component.embedded);
+
+        } else {
+
+            if (!meshes[index]) {
+                meshes[index] = make_shared<const vector<Object> >(component.embedded >= 0 ? loadBuiltInObject(component.embedded) : loadObject(component.fileName));
+            }
+
+            shape.silhouette = buildSilhouette(*meshes[index]);
+            shape.mass = buildMassProperties(*meshes[index]);
+            shape.hull = buildMeshHull(*meshes[index]);
+
+        }
+
+        addPart(parts, index, meshes[index], shape, getPartPhysics(component));
+
+    }
+
+    if (entry < 0 || entry >= (int) entries.size()) {
+        cout << "There is no component " << entry + 1 << " in the catalog" << endl;
+        return false;
+    }
+
+    if (find(rocket.begin(), rocket.end(), entry) == rocket.end()) {
+        cout << "Component " << entry + 1 << " is not part of the rocket" << endl;
+        return false;
+    }
+
+    int simulations;
+    double altitude;
+    double tuned = tuneComponent(parts, entry, value, target, simulations, altitude);
+
+    string names[] = {"mass", "thrust", "lift", "drag"};
+
+    cout << "Tuned the " << names[value] << " of " << getBaseName(entries[entry].fileName) << " from " << getTuneValue(entries[entry], value) << " to " << tuned;
+    cout << ": highest altitude " << altitude << " (target " << target << ") after " << simulations << " simulations" << endl;
+
+    if (fabs(altitude - target) >= tuneTolerance) {
+        cout << "The target could not be reached by changing the " << names[value] << " alone" << endl;
+    }
+
+    return true;
+
+}
+
+// Orbital flight - once the engines are out and the rocket is above the air, nothing but gravity acts on it, so its path is a Kepler orbit (an ellipse, or a hyperbola if it escapes) that is known in closed form. The rocket then coasts "on rails": its state at any time comes straight from the orbit at the same cost however far ahead, which is what makes time warp possible. It goes back to the step by step simulation the moment the orbit dips into the air again
+
+// The time warp factors the player can pick from (one step up or down with . and ,)
+const double maxTimeWarp = 100000;
+
+// This struct is a Kepler orbit around the planet: the position and velocity of the rocket at one moment (in planet centred coordinates, y up through the launch site and x downrange), and the shape of the orbit derived from them
+struct Orbit
+{
+    // The moment the position and velocity were taken, and how far around the planet the rocket was then
+    double epoch;
+    double angle;
+
+    double x, y;
+    double vx, vy;
+
+    // The reciprocal of the semi-major axis (negative for an escape orbit) and the eccentricity
+    double alpha;
+    double eccentricity;
+
+    // The orbital period (0 for an escape orbit)
+    double period;
+
+    // The next time after the epoch the rocket falls back through vacuumHeight (infinity if it never does)
+    double reentry;
+};
+
+// These methods return the Stumpff functions C(z) and S(z) used by the universal form of Kepler's equation (series near 0, where the closed forms lose precision)
+double getStumpffC (double z) {
+
+    if (z > 1e-6) {
+        return (1 - cos(sqrt(z))) / z;
+    } else if (z < -1e-6) {
+        return (cosh(sqrt(-z)) - 1) / -z;
+    }
+
+    return 1.0 / 2 - z / 24 + z * z / 720;
+
+}
+
+double getStumpffS (double z) {
+
+    if (z > 1e-6) {
+        return (sqrt(z) - sin(sqrt(z))) / (z * sqrt(z));
+    } else if (z < -1e-6) {
+        return (sinh(sqrt(-z)) - sqrt(-z)) / (-z * sqrt(-z));
+    }
+
+    return 1.0 / 6 - z / 120 + z * z / 5040;
+
+}
+
+// This method returns the orbit of a coasting rocket in the given state at the given time
+Orbit getOrbit (const FlightState &state, double time) {
+
+    Orbit orbit;
+    orbit.epoch = time;
+    orbit.angle = state.angle;
+
+    // The velocity is vertical (away from the centre) plus horizontal (towards increasing angle)
+    double radius = planetRadius + state.pos;
+    double s = sin(state.angle);
+    double c = cos(state.angle);
+
+    orbit.x = radius * s;
+    orbit.y = radius * c;
+    orbit.vx = state.vel * s + state.hvel * c;
+    orbit.vy = state.vel * c - state.hvel * s;
+
+    double speed2 = state.vel * state.vel + state.hvel * state.hvel;
+
+    orbit.alpha = 2 / radius - speed2 / gravityParameter;
+
+    // The eccentricity from e cos E and e sin E (both also defined for a rocket going straight up or down)
+    double ecos = 1 - radius * orbit.alpha;
+    double esin = radius * state.vel * sqrt(fabs(orbit.alpha) / gravityParameter);
+
+    orbit.eccentricity = orbit.alpha > 0 ? sqrt(ecos * ecos + esin * esin) : sqrt(max(0.0, ecos * ecos - esin * esin));
+    orbit.period = orbit.alpha > 0 ? 2 * pi / sqrt(gravityParameter * orbit.alpha * orbit.alpha * orbit.alpha) : 0;
+    orbit.reentry = numeric_limits<double>::infinity();
+
+    // Where the entry radius is on the orbit: the cosine of the eccentric anomaly there (or the hyperbolic cosine for an escape orbit). The orbit only reaches down that far if it is in range
+    double entryRadius = planetRadius + vacuumHeight;
+    double entryCos = (1 - entryRadius * orbit.alpha) / orbit.eccentricity;
+
+    if (orbit.alpha > 0 && entryCos < 1) {
+
+        // Elliptic: the eccentric anomaly where the rocket comes down through the entry radius (on the way down, so sin E < 0), and the time to get there from the mean anomaly now
+        double anomaly = atan2(esin, ecos);
+        double entry = 2 * pi - acos(max(-1.0, entryCos));
+
+        double meanNow = anomaly - esin;
+        double meanEntry = entry - orbit.eccentricity * sin(entry);
+
+        double ahead = fmod(meanEntry - meanNow, 2 * pi);
+
+        if (ahead < 0) {
+            ahead += 2 * pi;
+        }
+
+        orbit.reentry = time + ahead / (2 * pi) * orbit.period;
+
+    } else if (orbit.alpha < 0 && entryCos >= 1 && state.vel < 0) {
+
+        // Hyperbolic and still coming in: the same with the hyperbolic anomaly (an escaping rocket that is going up never comes back)
+        double anomaly = asinh(esin / orbit.eccentricity);
+        double entry = -acosh(entryCos);
+
+        double meanNow = esin - anomaly;
+        double meanEntry = orbit.eccentricity * sinh(entry) - entry;
+
+        orbit.reentry = time + (meanEntry - meanNow) / sqrt(gravityParameter * -orbit.alpha * orbit.alpha * orbit.alpha);
+
+    }
+
+    return orbit;
+
+}
+
+// This method returns the state of a rocket coasting along the orbit at the given time. It solves the universal form of Kepler's equation with Newton's method (a bounded number of iterations), so it costs the same however far from the epoch the time is
+FlightState getOrbitState (const Orbit &orbit, double time) {
+
+    double elapsed = time - orbit.epoch;
+
+    // Whole orbits change nothing but the angle
+    double turns = 0;
+
+    if (orbit.period > 0) {
+        turns = floor(elapsed / orbit.period);
+        elapsed -= turns * orbit.period;
+    }
+
+    double rootMu = sqrt(gravityParameter);
+    double r0 = sqrt(orbit.x * orbit.x + orbit.y * orbit.y);
+    double vr0 = (orbit.x * orbit.vx + orbit.y * orbit.vy) / r0;
+    double alpha = orbit.alpha;
+
+    // The universal anomaly, starting from the usual guesses for ellipses and hyperbolas
+    double chi = rootMu * fabs(alpha) * elapsed;
+
+    if (alpha < -1e-12) {
+
+        double a = 1 / alpha;
+        double guess = -2 * gravityParameter * alpha * elapsed / (r0 * vr0 + sqrt(-gravityParameter * a) * (1 - r0 * alpha));
+
+        if (guess > 0) {
+            chi = sqrt(-a) * log(guess);
+        }
+
+    }
+
+    for (int i=0; i<50; i++) {
+
+        double z = alpha * chi * chi;
+        double c = getStumpffC(z);
+        double s = getStumpffS(z);
+
+        double f = r0 * vr0 / rootMu * chi * chi * c + (1 - alpha * r0) * chi * chi * chi * s + r0 * chi - rootMu * elapsed;
+        double df = r0 * vr0 / rootMu * chi * (1 - z * s) + (1 - alpha * r0) * chi * chi * c + r0;
+
+        double delta = f / df;
+        chi -= delta;
+
+        if (fabs(delta) <= 1e-12 * (1 + fabs(chi))) {
+            break;
+        }
+
+    }
+
+    // The Lagrange coefficients carry the epoch position and velocity over to the new ones
+    double z = alpha * chi * chi;
+    double c = getStumpffC(z);
+    double s = getStumpffS(z);
+
+    double f = 1 - chi * chi / r0 * c;
+    double g = elapsed - chi * chi * chi / rootMu * s;
+
+    double x = f * orbit.x + g * orbit.vx;
+    double y = f * orbit.y + g * orbit.vy;
+    double radius = sqrt(x * x + y * y);
+
+    double df = rootMu / (radius * r0) * (alpha * chi * chi * chi * s - chi);
+    double dg = 1 - chi * chi / radius * c;
+
+    double vx = df * orbit.x + dg * orbit.vx;
+    double vy = df * orbit.y + dg * orbit.vy;
+
+    // The angle swept since the epoch, in the direction the rocket goes round (within one turn, since whole turns were taken off above)
+    double direction = orbit.y * orbit.vx - orbit.x * orbit.vy;
+    double swept = 0;
+
+    if (direction != 0) {
+
+        swept = fmod(atan2(x, y) - atan2(orbit.x, orbit.y) + 4 * pi, 2 * pi);
+
+        if (direction < 0 && swept > 0) {
+            swept -= 2 * pi;
+        }
+
+    }
+
+    FlightState state;
+    state.pos = radius - planetRadius;
+    state.angle = orbit.angle + swept + turns * 2 * pi * (direction < 0 ? -1 : 1);
+    state.vel = (x * vx + y * vy) / radius;
+    state.hvel = (y * vx - x * vy) / radius;
+    state.lift = 0;
+
+    return state;
+
+}
+
+// This method returns the lowest and highest altitudes of an orbit (the highest is infinity for an escape orbit)
+void getApsides (const Orbit &orbit, double &periapsis, double &apoapsis) {
+
+    double a = 1 / orbit.alpha;
+
+    if (orbit.alpha > 0) {
+        periapsis = a * (1 - orbit.eccentricity) - planetRadius;
+        apoapsis = a * (1 + orbit.eccentricity) - planetRadius;
+    } else {
+        periapsis = a * (1 - orbit.eccentricity) - planetRadius;
+        apoapsis = numeric_limits<double>::infinity();
+    }
+
+}
+
+// This method returns true if a rocket in the given state can coast on rails: the engines are out and it is above the air (rockets only start coasting on the way up, or well above vacuumHeight, so that a rocket that just fell off the rails does not climb straight back on)
+bool canCoast (const FlightState &state) {
+
+    return state.lift <= 0 && (state.pos > vacuumHeight + atmosphereScaleHeight || (state.pos > vacuumHeight && state.vel > 0));
+
+}
+
+// Flight simulation thread - the launch is simulated on its own thread at a fixed rate. The render thread sends it commands through a lock-free queue and reads its state from a lock-free triple buffer, so neither one ever waits for the other
+
+// This struct is a single producer, single consumer lock-free queue holding up to N-1 items (one thread pushes, one other thread pops)
+template <class T, int N>
+struct SpscQueue
+{
+    T items[N];
+
+    // The next slot to pop from (written by the consumer) and the next slot to push into (written by the producer)
+    atomic<unsigned> head;
+    atomic<unsigned> tail;
+
+    SpscQueue () : head(0), tail(0) {
+    }
+
+    // Adds an item. Returns false if the queue is full
+    bool push (const T &item) {
+
+        unsigned t = tail.load(memory_order_relaxed);
+        unsigned next = (t + 1) % N;
+
+        if (next == head.load(memory_order_acquire)) {
+            return false;
+        }
+
+        items[t] = item;
+        tail.store(next, memory_order_release);
+
+        return true;
+
+    }
+
+    // Takes the oldest item. Returns false if the queue is empty
+    bool pop (T &item) {
+
+        unsigned h = head.load(memory_order_relaxed);
+
+        if (h == tail.load(memory_order_acquire)) {
+            return false;
+        }
+
+        item = items[h];
+        head.store((h + 1) % N, memory_order_release);
+
+        return true;
+
+    }
+};
+
+// This struct is a lock-free triple buffer: one writer publishes complete values and one reader always gets the latest complete value, without either blocking. The writer and the reader each own one slot and swap it with the shared middle slot
+template <class T>
+struct TripleBuffer
+{
+    T slots[3];
+
+    // The index of the middle slot, with bit 4 set while it holds a value the reader has not taken yet
+    atomic<int> middle;
+
+    // The writer's and the reader's slots
+    int back;
+    int front;
+
+    TripleBuffer () : middle(1), back(0), front(2) {
+        slots[0] = slots[1] = slots[2] = T();
+    }
+
+    // The slot the writer fills before publishing
+    T &writeBuffer () {
+        return slots[back];
+    }
+
+    // Makes the filled slot the latest value
+    void publish () {
+        back = middle.exchange(back | 4, memory_order_acq_rel) & 3;
+    }
+
+    // Returns the latest published value
+    const T &read () {
+
+        if (middle.load(memory_order_relaxed) & 4) {
+            front = middle.exchange(front, memory_order_acq_rel) & 3;
+        }
+
+        return slots[front];
+
+    }
+};
+
+// This struct is an immutable picture of the flight, published by the simulation thread after every tick
+struct FlightSnapshot
+{
+    // The launch the snapshot belongs to (0 before the first launch)
+    int launch;
+
+    FlightState state;
+    int outcome;
+
+    // The simulation time since blastoff and the number of ticks simulated
+    double time;
+    int ticks;
+
+    // Whether the rocket is coasting along its orbit (and that orbit), whether it has been up to space yet, and the time warp in effect
+    bool coasting;
+    Orbit orbit;
+    bool reachedSpace;
+    double warp;
+};
+
+// The commands the render thread sends to the simulation thread
+const int SIM_LAUNCH = 0;
+const int SIM_ABORT = 1;
+const int SIM_WARP = 2;
+
+// This struct is one command for the simulation thread
+struct SimulationCommand
+{
+    int type;
+    int launch;
+
+    // The game clock when the command was given (in simulation time units)
+    double time;
+
+    // The rocket to launch
+    FlightState state;
+    FlightParams params;
+
+    // The time warp asked for
+    double warp;
+};
+
+// Commands from the render thread to the simulation thread
+SpscQueue<SimulationCommand, 64> simulationCommands;
+// The latest flight state from the simulation thread
+TripleBuffer<FlightSnapshot> flightSnapshots;
+
+// The fixed rate of the simulation, in ticks per second. Set with --sim-rate
+double simulationRate = 240;
+
+// The number of the current launch (the render thread ignores snapshots of older launches)
+int launchCount = 0;
+
+// Flight telemetry - with --telemetry <file>, the simulation thread records a sample of the flight every tick. Recording only copies the sample into a lock-free queue; a writer thread drains the queue into the file through a memory mapping, so the tick loop never waits for the disk. The file format and a reader are in telemetry.h
+
+// The samples waiting for the writer (the simulation thread pushes, the writer pops). About four minutes of ticks at the default rate
+SpscQueue<TelemetrySample, 1 << 16> telemetryQueue;
+
+// Whether telemetry is being recorded, and the number of samples dropped because the queue was full
+atomic<bool> telemetryEnabled(false);
+atomic<long long> telemetryDropped(0);
+
+// The number of samples the file grows by when it is full
+const size_t telemetryGrowth = 1 << 16;
+
+// This struct is the memory mapped telemetry file
+struct TelemetryFile
+{
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#else
+    int file;
+#endif
+
+    // The mapped view of the whole file (the header followed by room for capacity samples)
+    char *view;
+    size_t capacity;
+    uint64_t count;
+};
+
+TelemetryFile telemetryFile = TelemetryFile();
+
+// Guards the telemetry file (the writer thread and the exit handler both flush it)
+mutex telemetryLock;
+
+// This method maps the telemetry file with room for capacity samples, growing the file to fit. Returns false if the mapping fails
+bool mapTelemetryFile (size_t capacity) {
+
+    size_t bytes = sizeof(TelemetryHeader) + capacity * sizeof(TelemetrySample);
+
+#ifdef _WIN32
+    telemetryFile.mapping = CreateFileMappingA(telemetryFile.file, nullptr, PAGE_READWRITE, (DWORD) ((uint64_t) bytes >> 32), (DWORD) bytes, nullptr);
+
+    if (telemetryFile.mapping == nullptr) {
+        return false;
+    }
+
+    telemetryFile.view = (char*) MapViewOfFile(telemetryFile.mapping, FILE_MAP_WRITE, 0, 0, bytes);
+#else
+    if (ftruncate(telemetryFile.file, bytes) != 0) {
+        return false;
+    }
+
+    void *view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, telemetryFile.file, 0);
+    telemetryFile.view = view == MAP_FAILED ? nullptr : (char*) view;
+#endif
+
+    telemetryFile.capacity = capacity;
+
+    return telemetryFile.view != nullptr;
+
+}
+
+// This void method unmaps the telemetry file
+void unmapTelemetryFile () {
+
+    if (telemetryFile.view == nullptr) {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(telemetryFile.view);
+    CloseHandle(telemetryFile.mapping);
+#else
+    munmap(telemetryFile.view, sizeof(TelemetryHeader) + telemetryFile.capacity * sizeof(TelemetrySample));
+#endif
+
+    telemetryFile.view = nullptr;
+
+}
+
+// This method creates the telemetry file and starts recording. Returns false if the file cannot be created
+bool openTelemetry (const string &filename) {
+
+#ifdef _WIN32
+    telemetryFile.file = CreateFileA(filename.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (telemetryFile.file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+#else
+    telemetryFile.file = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    if (telemetryFile.file < 0) {
+        return false;
+    }
+#endif
+
+    if (!mapTelemetryFile(telemetryGrowth)) {
+        return false;
+    }
+
+    TelemetryHeader header = TelemetryHeader();
+    copy(telemetryMagic, telemetryMagic + 4, header.magic);
+    header.version = telemetryVersion;
+    header.sampleSize = sizeof(TelemetrySample);
+    header.sampleCount = 0;
+
+    memcpy(telemetryFile.view, &header, sizeof(header));
+
+    telemetryFile.count = 0;
+    telemetryEnabled.store(true);
+
+    return true;
+
+}
+
+// This void method records the state of a flight (called by the simulation thread). Costs one derivative evaluation and a copy into the queue; the sample is dropped if the writer has fallen a whole queue behind
+void recordTelemetry (int launch, int tick, double time, const FlightState &state, const FlightParams &params) {
+
+    if (!telemetryEnabled.load(memory_order_relaxed)) {
+        return;
+    }
+
+    TelemetrySample sample;
+    sample.launch = launch;
+    sample.tick = tick;
+    sample.time = time;
+    FlightState rates = getFlightDerivative(state, params);
+
+    sample.pos = state.pos;
+    sample.vel = state.vel;
+    sample.accel = rates.vel;
+    sample.lift = state.lift;
+    sample.angle = state.angle;
+    sample.hvel = state.hvel;
+    sample.haccel = rates.hvel;
+
+    if (!telemetryQueue.push(sample)) {
+        telemetryDropped.fetch_add(1, memory_order_relaxed);
+    }
+
+}
+
+// This void method moves every queued sample into the telemetry file, growing the file when it is full. The sample count in the header is only raised once the samples are in place, so a reader never sees a partial sample
+void flushTelemetry () {
+
+    lock_guard<mutex> guard(telemetryLock);
+
+    if (telemetryFile.view == nullptr) {
+        return;
+    }
+
+    TelemetrySample sample;
+
+    while (telemetryQueue.pop(sample)) {
+
+        if (telemetryFile.count == telemetryFile.capacity) {
+
+            size_t capacity = telemetryFile.capacity + telemetryGrowth;
+
+            unmapTelemetryFile();
+
+            if (!mapTelemetryFile(capacity)) {
+                cout << "Could not grow the telemetry file, recording stopped" << endl;
+                telemetryEnabled.store(false);
+                return;
+            }
+
+        }
+
+        memcpy(telemetryFile.view + sizeof(TelemetryHeader) + telemetryFile.count * sizeof(TelemetrySample), &sample, sizeof(sample));
+        telemetryFile.count++;
+
+    }
+
+    memcpy(telemetryFile.view + offsetof(TelemetryHeader, sampleCount), &telemetryFile.count, sizeof(telemetryFile.count));
+
+}
+
+// This void method flushes the telemetry file every 50 milliseconds, forever (runs on its own thread)
+void runTelemetryWriter () {
+
+    while (true) {
+        this_thread::sleep_for(chrono::milliseconds(50));
+        flushTelemetry();
+    }
+
+}
+
+// This void method stops recording, writes out the last samples and cuts the file down to the samples it holds. Registered with atexit
+void closeTelemetry () {
+
+    telemetryEnabled.store(false);
+    flushTelemetry();
+
+    lock_guard<mutex> guard(telemetryLock);
+
+    if (telemetryFile.view == nullptr) {
+        return;
+    }
+
+    unmapTelemetryFile();
+
+    uint64_t bytes = sizeof(TelemetryHeader) + telemetryFile.count * sizeof(TelemetrySample);
+
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    size.QuadPart = bytes;
+
+    SetFilePointerEx(telemetryFile.file, size, nullptr, FILE_BEGIN);
+    SetEndOfFile(telemetryFile.file);
+    CloseHandle(telemetryFile.file);
+#else
+    if (ftruncate(telemetryFile.file, bytes) != 0) {
+        cout << "Could not trim the telemetry file" << endl;
+    }
+
+    close(telemetryFile.file);
+#endif
+
+    if (telemetryDropped.load() > 0) {
+        cout << "Telemetry: " << telemetryDropped.load() << " samples dropped" << endl;
+    }
+
+}
+
+// This method advances the launched rocket by duration from the snapshot's time: step by step while it is under power or in the air, and along its orbit while it coasts. Stops early if it touches the ground, or at the moment it falls off the rails back into the air (so that the caller can end time warp there). Returns the time advanced
+double advanceLaunch (FlightSnapshot &snapshot, const FlightParams &params, double duration, double &adaptiveStep) {
+
+    double elapsed = 0;
+
+    while (elapsed < duration && getGroundContact(snapshot.state, params) == FLIGHT_ACTIVE) {
+
+        if (snapshot.coasting) {
+
+            double end = snapshot.time + duration;
+
+            if (snapshot.orbit.reentry > end) {
+                snapshot.state = getOrbitState(snapshot.orbit, end);
+                return duration;
+            }
+
+            // Back into the air: carry on step by step from the moment the orbit gets there
+            snapshot.state = getOrbitState(snapshot.orbit, snapshot.orbit.reentry);
+            snapshot.coasting = false;
+            adaptiveStep = flightStep;
+
+            return snapshot.orbit.reentry - snapshot.time;
+
+        }
+
+        if (canCoast(snapshot.state)) {
+            snapshot.orbit = getOrbit(snapshot.state, snapshot.time + elapsed);
+            snapshot.coasting = true;
+            continue;
+        }
+
+        elapsed += flightIntegrator(snapshot.state, params, min(adaptiveStep, duration - elapsed), adaptiveStep);
+
+    }
+
+    return elapsed;
+
+}
+
+// This void method runs the flight simulation forever. Every tick it takes new commands, advances the flight by a fixed amount of simulation time (catching up if the game clock ran ahead) and publishes a snapshot. Ticks are scheduled on the wall clock, so the rate does not depend on how long frames take to draw
+void runSimulation () {
+
+    bool flying = false;
+
+    // The simulation time follows the game clock, sped up by the time warp: it was warpTime when the game clock (in simulation time units) was warpClock
+    double warpClock = 0;
+    double warpTime = 0;
+
+    FlightSnapshot snapshot = FlightSnapshot();
+    FlightParams params = FlightParams();
+
+    double adaptiveStep = flightStep;
+
+    chrono::steady_clock::time_point nextTick = chrono::steady_clock::now();
+
+    while (true) {
+
+        // The tick period in wall time and in simulation time (10 seconds per unit)
+        double tickSeconds = 1.0 / simulationRate;
+        double tickTime = tickSeconds / 10.0;
+
+        bool changed = false;
+
+        // This lambda simulates whole ticks up to the game clock (measured from blastoff, and sped up by the warp), at most maxSteps of them. A warped tick covers warp times as much simulation time, at the same cost since the rocket is coasting
+        auto advanceTo = [&](double clock, int maxSteps) {
+
+            int steps = 0;
+
+            while (snapshot.time + tickTime * snapshot.warp <= warpTime + (clock - warpClock) * snapshot.warp && snapshot.outcome == FLIGHT_ACTIVE && steps < maxSteps) {
+
+                snapshot.time += advanceLaunch(snapshot, params, tickTime * snapshot.warp, adaptiveStep);
+                snapshot.ticks++;
+
+                // Reaching space wins the game, but the flight goes on until the player ends it or the rocket comes down
+                snapshot.reachedSpace = snapshot.reachedSpace || snapshot.state.pos >= spaceHeight;
+                snapshot.outcome = getGroundContact(snapshot.state, params);
+
+                // Falling off the rails ends the time warp, from that moment on
+                if (!snapshot.coasting && snapshot.warp != 1) {
+                    warpClock += (snapshot.time - warpTime) / snapshot.warp;
+                    warpTime = snapshot.time;
+                    snapshot.warp = 1;
+                }
+
+                recordTelemetry(snapshot.launch, snapshot.ticks, snapshot.time, snapshot.state, params);
+
+                steps++;
+                changed = true;
+
+            }
+
+            if (snapshot.outcome != FLIGHT_ACTIVE) {
+                flying = false;
+            }
+
+        };
+
+        SimulationCommand command;
+
+        while (simulationCommands.pop(command)) {
+
+            // Every tick before the moment of the command is simulated first, so that the ticks do not depend on when this thread happened to wake up (a replay simulates exactly the ticks of the recording)
+            if (flying) {
+                advanceTo(command.time, numeric_limits<int>::max());
+            }
+
+            if (command.type == SIM_LAUNCH) {
+
+                snapshot.launch = command.launch;
+                snapshot.state = command.state;
+                snapshot.outcome = FLIGHT_ACTIVE;
+                snapshot.time = 0;
+                snapshot.ticks = 0;
+                snapshot.coasting = false;
+                snapshot.reachedSpace = false;
+                snapshot.warp = 1;
+
+                params = command.params;
+                adaptiveStep = flightStep;
+
+                // The flight starts at the moment the launch was given (so that replays simulate the same ticks)
+                warpClock = command.time;
+                warpTime = 0;
+                flying = true;
+
+                recordTelemetry(snapshot.launch, 0, 0, snapshot.state, params);
+
+            } else if (command.type == SIM_ABORT) {
+                flying = false;
+            } else if (command.type == SIM_WARP && flying) {
+
+                // Carry on from where the old warp got to. Only a coasting rocket can be warped (step by step, warp would multiply the number of steps)
+                warpTime = max(snapshot.time, warpTime + (command.time - warpClock) * snapshot.warp);
+                warpClock = command.time;
+                snapshot.warp = snapshot.coasting ? max(1.0, min(command.warp, maxTimeWarp)) : 1;
+
+            }
+
+            changed = true;
+
+        }
+
+        // Catch up with the game clock, a bounded number of ticks per wake-up so that a stall cannot snowball
+        if (flying) {
+            advanceTo(getElapsedMillis() / 10000.0, 1000);
+        }
+
+        if (changed) {
+            flightSnapshots.writeBuffer() = snapshot;
+            flightSnapshots.publish();
+        }
+
+        // Sleep until the next tick (skip ahead if the thread fell far behind)
+        nextTick += chrono::microseconds((long long) (tickSeconds * 1000000));
+
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+        if (nextTick < now - chrono::milliseconds(100)) {
+            nextTick = now;
+        }
+
+        this_thread::sleep_until(nextTick);
+
+    }
+
+}
+
+// Fleet mode - with --fleet N, every launch also flies N variations of the rocket side by side (thrust and lift scaled from half to one and a half times the real rocket's). The fleet keeps its state in contiguous arrays that are advanced in bulk on the job system, and it is drawn with hardware instancing: one draw per part mesh for the whole fleet, with the offset and colour of every rocket as per-instance attributes
+
+// The number of rockets in the fleet (0 turns fleet mode off). Set with --fleet
+int fleetSize = 0;
+
+// This struct holds the state of every rocket in the fleet, one entry per rocket in each array
+struct Fleet
+{
+    int size;
+
+    // The game clock at launch and the simulation time reached so far
+    double launchTime;
+    double time;
+
+    vector<FlightState> states;
+    vector<FlightParams> params;
+    vector<double> adaptiveSteps;
+    vector<int> outcomes;
+
+    // The per-instance attributes of the fleet draws, three floats per rocket (x, y, z and red, green, blue)
+    vector<float> offsets;
+    vector<float> colors;
+};
+
+Fleet fleet;
+
+// The per-instance attribute locations of the fleet shader (clear of the locations some drivers alias to gl_Vertex and friends)
+const int INSTANCE_OFFSET = 6;
+const int INSTANCE_COLOR = 7;
+
+// The GL 3.3 entry points used for instancing. They are not part of the OpenGL 1.x headers and libraries, so they are looked up at runtime
+typedef GLuint (APIENTRY *CreateShaderProc)(GLenum type);
+typedef void (APIENTRY *ShaderSourceProc)(GLuint shader, GLsizei count, const char *const *source, const GLint *length);
+typedef void (APIENTRY *CompileShaderProc)(GLuint shader);
+typedef void (APIENTRY *GetShaderivProc)(GLuint shader, GLenum name, GLint *value);
+typedef GLuint (APIENTRY *CreateProgramProc)(void);
+typedef void (APIENTRY *AttachShaderProc)(GLuint program, GLuint shader);
+typedef void (APIENTRY *BindAttribLocationProc)(GLuint program, GLuint index, const char *name);
+typedef void (APIENTRY *LinkProgramProc)(GLuint program);
+typedef void (APIENTRY *GetProgramivProc)(GLuint program, GLenum name, GLint *value);
+typedef void (APIENTRY *UseProgramProc)(GLuint program);
+typedef void (APIENTRY *VertexAttribArrayProc)(GLuint index);
+typedef void (APIENTRY *VertexAttribPointerProc)(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer);
+typedef void (APIENTRY *VertexAttribDivisorProc)(GLuint index, GLuint divisor);
+typedef void (APIENTRY *DrawElementsInstancedProc)(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei instances);
+typedef GLint (APIENTRY *GetUniformLocationProc)(GLuint program, const char *name);
+typedef void (APIENTRY *Uniform3fProc)(GLint location, GLfloat x, GLfloat y, GLfloat z);
+
+// This struct holds the instancing entry points and the fleet shader (program is 0 if instancing is not available, and the fleet is then drawn one rocket at a time)
+struct InstancingApi
+{
+    CreateShaderProc createShader;
+    ShaderSourceProc shaderSource;
+    CompileShaderProc compileShader;
+    GetShaderivProc getShaderiv;
+    CreateProgramProc createProgram;
+    AttachShaderProc attachShader;
+    BindAttribLocationProc bindAttribLocation;
+    LinkProgramProc linkProgram;
+    GetProgramivProc getProgramiv;
+    UseProgramProc useProgram;
+    VertexAttribArrayProc enableVertexAttribArray;
+    VertexAttribArrayProc disableVertexAttribArray;
+    VertexAttribPointerProc vertexAttribPointer;
+    VertexAttribDivisorProc vertexAttribDivisor;
+    DrawElementsInstancedProc drawElementsInstanced;
+    GetUniformLocationProc getUniformLocation;
+    Uniform3fProc uniform3f;
+
+    GLuint program;
+
+    // The uniforms that turn the stored vertex values of the mesh being drawn into coordinates
+    GLint meshScale;
+    GLint meshOrigin;
+};
+
+InstancingApi instancing = InstancingApi();
+
+// The fleet shader: every vertex is turned into coordinates (for quantized meshes), moved by its rocket's offset and coloured with its rocket's colour
+const char *fleetVertexShader =
+    "#version 120\n"
+    "uniform vec3 meshScale;\n"
+    "uniform vec3 meshOrigin;\n"
+    "attribute vec3 instanceOffset;\n"
+    "attribute vec3 instanceColor;\n"
+    "varying vec3 color;\n"
+    "void main () {\n"
+    "    color = instanceColor;\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * vec4(gl_Vertex.xyz * meshScale + meshOrigin + instanceOffset, 1.0);\n"
+    "}\n";
+
+const char *fleetFragmentShader =
+    "#version 120\n"
+    "varying vec3 color;\n"
+    "void main () {\n"
+    "    gl_FragColor = vec4(color, 1.0);\n"
+    "}\n";
+
+// This method returns the address of an OpenGL entry point (nullptr if it cannot be looked up on this platform)
+void *getGLProc (const char *name) {
+
+#if defined(_WIN32)
+    return (void*) wglGetProcAddress(name);
+#elif defined(__linux__)
+    return (void*) glXGetProcAddressARB((const GLubyte*) name);
+#else
+    return nullptr;
+#endif
+
+}
+
+// This method compiles one stage of the fleet shader. Returns 0 if it does not compile
+GLuint compileFleetShader (GLenum type, const char *source) {
+
+    GLuint shader = instancing.createShader(type);
+    GLint compiled = 0;
+
+    instancing.shaderSource(shader, 1, &source, nullptr);
+    instancing.compileShader(shader);
+    instancing.getShaderiv(shader, 0x8B81 /* GL_COMPILE_STATUS */, &compiled);
+
+    return compiled ? shader : 0;
+
+}
+
+// This void method looks up the instancing entry points and builds the fleet shader. Needs a current GL context (call it once the window is created). Leaves instancing.program at 0 on drivers older than OpenGL 3.3
+void initInstancing () {
+
+    const char *version = (const char*) glGetString(GL_VERSION);
+    int major = 0, minor = 0;
+
+    if (version == nullptr || sscanf(version, "%d.%d", &major, &minor) != 2 || major * 10 + minor < 33) {
+        return;
+    }
+
+    instancing.createShader = (CreateShaderProc) getGLProc("glCreateShader");
+    instancing.shaderSource = (ShaderSourceProc) getGLProc("glShaderSource");
+    instancing.compileShader = (CompileShaderProc) getGLProc("glCompileShader");
+    instancing.getShaderiv = (GetShaderivProc) getGLProc("glGetShaderiv");
+    instancing.createProgram = (CreateProgramProc) getGLProc("glCreateProgram");
+    instancing.attachShader = (AttachShaderProc) getGLProc("glAttachShader");
+    instancing.bindAttribLocation = (BindAttribLocationProc) getGLProc("glBindAttribLocation");
+    instancing.linkProgram = (LinkProgramProc) getGLProc("glLinkProgram");
+    instancing.getProgramiv = (GetProgramivProc) getGLProc("glGetProgramiv");
+    instancing.useProgram = (UseProgramProc) getGLProc("glUseProgram");
+    instancing.enableVertexAttribArray = (VertexAttribArrayProc) getGLProc("glEnableVertexAttribArray");
+    instancing.disableVertexAttribArray = (VertexAttribArrayProc) getGLProc("glDisableVertexAttribArray");
+    instancing.vertexAttribPointer = (VertexAttribPointerProc) getGLProc("glVertexAttribPointer");
+    instancing.vertexAttribDivisor = (VertexAttribDivisorProc) getGLProc("glVertexAttribDivisor");
+    instancing.drawElementsInstanced = (DrawElementsInstancedProc) getGLProc("glDrawElementsInstanced");
+    instancing.getUniformLocation = (GetUniformLocationProc) getGLProc("glGetUniformLocation");
+    instancing.uniform3f = (Uniform3fProc) getGLProc("glUniform3f");
+
+    if (!instancing.createShader || !instancing.shaderSource || !instancing.compileShader || !instancing.getShaderiv || !instancing.createProgram || !instancing.attachShader || !instancing.bindAttribLocation || !instancing.linkProgram || !instancing.getProgramiv || !instancing.useProgram || !instancing.enableVertexAttribArray || !instancing.disableVertexAttribArray || !instancing.vertexAttribPointer || !instancing.vertexAttribDivisor || !instancing.drawElementsInstanced || !instancing.getUniformLocation || !instancing.uniform3f) {
+        return;
+    }
+
+    GLuint vertexShader = compileFleetShader(0x8B31 /* GL_VERTEX_SHADER */, fleetVertexShader);
+    GLuint fragmentShader = compileFleetShader(0x8B30 /* GL_FRAGMENT_SHADER */, fleetFragmentShader);
+
+    if (vertexShader == 0 || fragmentShader == 0) {
+        cout << "Could not compile the fleet shader, drawing the fleet without instancing" << endl;
+        return;
+    }
+
+    GLuint program = instancing.createProgram();
+    GLint linked = 0;
+
+    instancing.attachShader(program, vertexShader);
+    instancing.attachShader(program, fragmentShader);
+    instancing.bindAttribLocation(program, INSTANCE_OFFSET, "instanceOffset");
+    instancing.bindAttribLocation(program, INSTANCE_COLOR, "instanceColor");
+    instancing.linkProgram(program);
+    instancing.getProgramiv(program, 0x8B82 /* GL_LINK_STATUS */, &linked);
+
+    if (linked) {
+        instancing.program = program;
+        instancing.meshScale = instancing.getUniformLocation(program, "meshScale");
+        instancing.meshOrigin = instancing.getUniformLocation(program, "meshOrigin");
+    } else {
+        cout << "Could not link the fleet shader, drawing the fleet without instancing" << endl;
+    }
+
+}
+
+// This void method launches the fleet from the given launch state of the real rocket. The rockets are laid out on a square grid around the real one, spaced by the footprint of the assembly
+void launchFleet (const FlightState &state, const FlightParams &params, double launchTime) {
+
+    int size = fleetSize;
+
+    fleet.size = size;
+    fleet.launchTime = launchTime;
+    fleet.time = 0;
+
+    fleet.states.assign(size, state);
+    fleet.params.assign(size, params);
+    fleet.adaptiveSteps.assign(size, flightStep);
+    fleet.outcomes.assign(size, FLIGHT_ACTIVE);
+    fleet.offsets.assign(size * 3, 0);
+    fleet.colors.assign(size * 3, 0);
+
+    // The footprint of the assembly (from the bounds of its parts)
+    const PartWorld &world = partWorld;
+
+    double width = 0;
+
+    for (int run=0; run<world.assembled; run=getRunEnd(run, world.assembled)) {
+
+        const PartBounds *bounds = world.bounds.getRun(run);
+
+        for (int k=0; k<getRunEnd(run, world.assembled)-run; k++) {
+            if (bounds[k].maxX >= bounds[k].minX) {
+                width = max(width, bounds[k].maxX - bounds[k].minX);
+                width = max(width, bounds[k].maxZ - bounds[k].minZ);
+            }
+        }
+
+    }
+
+    double spacing = max(width * 1.5, 10.0);
+    int columns = (int) ceil(sqrt((double) size));
+
+    for (int i=0; i<size; i++) {
+
+        // Spread the variations from half to one and a half times the real rocket's thrust and lift
+        double scale = size > 1 ? 0.5 + (double) i / (size - 1) : 1.0;
+
+        fleet.states[i].vel *= scale;
+        fleet.states[i].hvel *= scale;
+        fleet.states[i].lift *= scale;
+
+        fleet.offsets[i*3] = (i % columns - columns / 2) * spacing;
+        fleet.offsets[i*3+2] = -(i / columns + 1) * spacing;
+
+    }
+
+}
+
+// This void method advances every rocket of the fleet to the game clock (in bulk, on the job system) and refreshes the per-instance offsets and colours. height is the altitude of the real rocket, which the view follows
+void updateFleet (double height) {
+
+    double target = getElapsedMillis() / 10000.0 - fleet.launchTime;
+    double duration = target - fleet.time;
+
+    if (duration > 0) {
+
+        parallelFor(0, fleet.size, 64, [duration](int first, int last) {
+
+            for (int i=first; i<last; i++) {
+
+                if (fleet.outcomes[i] == FLIGHT_ACTIVE) {
+                    advanceFlight(fleet.states[i], fleet.params[i], duration, fleet.adaptiveSteps[i]);
+                    fleet.outcomes[i] = getFlightOutcome(fleet.states[i], fleet.params[i]);
+                }
+
+            }
+
+        });
+
+        fleet.time = target;
+
+    }
+
+    for (int i=0; i<fleet.size; i++) {
+
+        // Draw every rocket relative to the real one (the ground moves, not the view)
+        fleet.offsets[i*3+1] = fleet.states[i].pos - height;
+
+        // Blue while flying, red once crashed and green once in space
+        fleet.colors[i*3] = fleet.outcomes[i] == FLIGHT_CRASHED;
+        fleet.colors[i*3+1] = fleet.outcomes[i] == FLIGHT_SPACE;
+        fleet.colors[i*3+2] = fleet.outcomes[i] == FLIGHT_ACTIVE;
+
+    }
+
+}
+
+// The most lines the fleet may draw per frame at full detail. Larger fleets are drawn as the bounding box of every rocket instead (the cost of a software renderer grows with the number of lines, however short they are). Set with --fleet-lines
+int fleetLineBudget = 20000;
+
+// The 12 edges of a box whose corners are numbered by their x, y and z bits
+const int boxEdges[24] = {0,1, 2,3, 4,5, 6,7, 0,2, 1,3, 4,6, 5,7, 0,4, 1,5, 2,6, 3,7};
+
+// This void method draws one line mesh (vertices plus pairs of edge indices) for every rocket of the fleet, at (x, y, z) plus the rocket's offset. With instancing this is a single draw for the entire fleet
+void drawFleetLines (const EdgeArrays &arrays, double x, double y, double z) {
+
+    glVertexPointer(3, arrays.vertexType, arrays.vertexStride, arrays.vertices);
+
+    if (instancing.program != 0) {
+
+        glPushMatrix();
+        glTranslated(x, y, z);
+
+        // The shader turns the stored vertex values into coordinates before adding the rocket's offset
+        instancing.uniform3f(instancing.meshScale, arrays.scale[0], arrays.scale[1], arrays.scale[2]);
+        instancing.uniform3f(instancing.meshOrigin, arrays.origin[0], arrays.origin[1], arrays.origin[2]);
+
+        instancing.drawElementsInstanced(GL_LINES, arrays.indexCount, arrays.indexType, arrays.indices, fleet.size);
+
+        glPopMatrix();
+
+        return;
+
+    }
+
+    for (int i=0; i<fleet.size; i++) {
+
+        glPushMatrix();
+        glTranslated(x + fleet.offsets[i*3], y + fleet.offsets[i*3+1], z + fleet.offsets[i*3+2]);
+        glColor3fv(&fleet.colors[i*3]);
+
+        if (arrays.quantized) {
+            glTranslated(arrays.origin[0], arrays.origin[1], arrays.origin[2]);
+            glScaled(arrays.scale[0], arrays.scale[1], arrays.scale[2]);
+        }
+
+        glDrawElements(GL_LINES, arrays.indexCount, arrays.indexType, arrays.indices);
+
+        glPopMatrix();
+
+    }
+
+}
+
+// This void method draws every rocket of the fleet at (x, y, z) plus its own offset. With instancing each part mesh takes one draw for the entire fleet, and without it each rocket is drawn separately
+void drawFleet (double x, double y, double z) {
+
+    const PartWorld &world = partWorld;
+
+    // Count the lines of one rocket to pick the level of detail
+    long long edgesPerRocket = 0;
+
+    for (int run=0; run<world.assembled; run=getRunEnd(run, world.assembled)) {
+
+        const MeshHandle *meshes = world.meshes.getRun(run);
+
+        for (int k=0; k<getRunEnd(run, world.assembled)-run; k++) {
+            for (const Object &obj : *meshes[k]) {
+                edgesPerRocket += getEdgeArrays(obj).indexCount / 2;
+            }
+        }
+
+    }
+
+    bool boxes = edgesPerRocket * fleet.size > fleetLineBudget;
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+
+    if (instancing.program != 0) {
+
+        instancing.useProgram(instancing.program);
+
+        // The per-instance attributes advance once per rocket instead of once per vertex
+        instancing.enableVertexAttribArray(INSTANCE_OFFSET);
+        instancing.enableVertexAttribArray(INSTANCE_COLOR);
+        instancing.vertexAttribPointer(INSTANCE_OFFSET, 3, GL_FLOAT, GL_FALSE, 0, &fleet.offsets[0]);
+        instancing.vertexAttribPointer(INSTANCE_COLOR, 3, GL_FLOAT, GL_FALSE, 0, &fleet.colors[0]);
+        instancing.vertexAttribDivisor(INSTANCE_OFFSET, 1);
+        instancing.vertexAttribDivisor(INSTANCE_COLOR, 1);
+
+    }
+
+    if (!boxes) {
+
+        for (int run=0; run<world.assembled; run=getRunEnd(run, world.assembled)) {
+
+            const Point3D *transforms = world.transforms.getRun(run);
+            const MeshHandle *meshes = world.meshes.getRun(run);
+
+            for (int k=0; k<getRunEnd(run, world.assembled)-run; k++) {
+                for (const Object &obj : *meshes[k]) {
+
+                    EdgeArrays arrays = getEdgeArrays(obj);
+
+                    if (arrays.indexCount > 0) {
+                        drawFleetLines(arrays, x + transforms[k].x, y + transforms[k].y, z + transforms[k].z);
+                    }
+
+                }
+            }
+
+        }
+
+    } else {
+
+        // The bounds of the whole rocket
+        PartBounds bounds = getPartsBounds(world, 0, world.assembled);
+
+        Point3D low = {bounds.minX, bounds.minY, bounds.minZ};
+        Point3D high = {bounds.maxX, bounds.maxY, bounds.maxZ};
+
+        Point3D corners[8];
+
+        for (int c=0; c<8; c++) {
+            corners[c].x = c & 1 ? high.x : low.x;
+            corners[c].y = c & 2 ? high.y : low.y;
+            corners[c].z = c & 4 ? high.z : low.z;
+        }
+
+        if (low.x <= high.x) {
+
+            EdgeArrays box = {GL_DOUBLE, sizeof(Point3D), &corners[0].x, GL_UNSIGNED_INT, boxEdges, 24, false, {1, 1, 1}, {0, 0, 0}};
+
+            drawFleetLines(box, x, y, z);
+
+        }
+
+    }
+
+    if (instancing.program != 0) {
+
+        instancing.vertexAttribDivisor(INSTANCE_OFFSET, 0);
+        instancing.vertexAttribDivisor(INSTANCE_COLOR, 0);
+        instancing.disableVertexAttribArray(INSTANCE_OFFSET);
+        instancing.disableVertexAttribArray(INSTANCE_COLOR);
+
+        instancing.useProgram(0);
+
+    }
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+}
+
+// This void method sends the current rocket (assembly) to the simulation thread for a new launch (and launches the fleet alongside it in fleet mode)
+void sendLaunchCommand () {
+
+    launchCount++;
+
+    SimulationCommand command;
+    command.type = SIM_LAUNCH;
+    command.launch = launchCount;
+    command.time = getElapsedMillis() / 10000.0;
+
+    // Thrust is the initial velocity, Lift is the initial accelleration (both along the rocket, tilted by the launch pitch), and Drag is the rate at which the lift wears off
+    command.params = getFlightParams();
+    command.state.pos = v_pos;
+    command.state.vel = v_vel * cos(command.params.pitch);
+    command.state.lift = assemblyTotals.lift;
+    command.state.angle = 0;
+    command.state.hvel = v_vel * sin(command.params.pitch);
+
+    simulationCommands.push(command);
+
+    if (fleetSize > 0) {
+        launchFleet(command.state, command.params, command.time);
+    }
+
+}
+
+// The latest snapshot of the current launch (the render thread's copy, used for the flight readouts)
+FlightSnapshot currentFlight = FlightSnapshot();
+
+// This void method sends the simulation thread a new time warp for the current launch
+void sendWarpCommand (double warp) {
+
+    SimulationCommand command = SimulationCommand();
+    command.type = SIM_WARP;
+    command.launch = launchCount;
+    command.time = getElapsedMillis() / 10000.0;
+    command.warp = warp;
+
+    simulationCommands.push(command);
+
+}
+
+// This void method ends the current flight once the rocket has been to space, and moves on to the winning screen
+void finishFlight () {
+
+    SimulationCommand command = SimulationCommand();
+    command.type = SIM_ABORT;
+    simulationCommands.push(command);
+
+    stage = 3;
+
+}
+
+// This void method takes the latest state of the launched rocket from the simulation thread (never waiting for it) and moves the game on if the rocket came back down
+void launchRocket () {
+
+    const FlightSnapshot &snapshot = flightSnapshots.read();
+
+    // The simulation has not picked up this launch yet
+    if (snapshot.launch != launchCount) {
+        return;
+    }
+
+    currentFlight = snapshot;
+
+    v_pos = snapshot.state.pos;
+    v_vel = snapshot.state.vel;
+
+    // Check winning and losing conditions
+    if (snapshot.outcome == FLIGHT_CRASHED || snapshot.outcome == FLIGHT_LANDED) {
+
+        // If the rocket came down (crashed or landed) after making it to space, the player still won (stage 3). If it came down without getting there, stop further calls. Print Losing Screen (stage 4)
+        stage = snapshot.reachedSpace ? 3 : 4;
+
+        // Reset BLASTOFF (so that a relaunch would not be instantly activated)
+        BLASTOFF = false;
+
+        return;
+
+    }
+
+}
+
+// Terrain - the ground of the launch view is procedural terrain, split into a quadtree of square tiles around the launch site. Every frame the tiles in view are refined, those whose error covers the most pixels on screen first, until a fixed triangle budget is used up; tiles outside the view volume are not drawn at all. Tiles are generated by the job system and kept in a cache with a memory budget; while a tile is still being generated, the nearest generated tile above it in the quadtree is drawn in its place
+
+// The launch site (where the rocket is drawn) and the size of the square of terrain around it
+const double launchSiteX = 550;
+const double launchSiteZ = -300;
+const double terrainExtent = 20000;
+
+// The deepest quadtree level (tiles of terrainExtent / 2^terrainMaxLevel)
+const int terrainMaxLevel = 8;
+
+// The number of quads along each side of a tile
+const int terrainTileQuads = 16;
+
+// How many pixels the error of a tile may cover on screen before it is refined (lower is more detailed)
+double terrainDetail = 1.0;
+
+// The most triangles the terrain may draw per frame. Set with --terrain-triangles
+int terrainTriangleBudget = 48000;
+
+// The memory budget of the tile cache, in bytes
+size_t terrainCacheBudget = 8 * 1024 * 1024;
+
+// The flattened area around the pad, and the height of the highest mountains
+const double padRadius = 400;
+const double terrainHeight = 600;
+
+// This method returns a pseudo-random value between 0 and 1 for an integer lattice point
+double getLatticeNoise (int x, int z) {
+
+    uint32_t h = (uint32_t) x * 374761393u + (uint32_t) z * 668265263u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    h ^= h >> 16;
+
+    return (h & 0xFFFFFF) / (double) 0xFFFFFF;
+
+}
+
+// This method returns smoothly interpolated lattice noise at any point (value noise)
+double getValueNoise (double x, double z) {
+
+    int x0 = (int) floor(x);
+    int z0 = (int) floor(z);
+
+    double fx = x - x0;
+    double fz = z - z0;
+
+    // Smoothstep weights, so the surface has no creases along the lattice
+    fx = fx * fx * (3 - 2 * fx);
+    fz = fz * fz * (3 - 2 * fz);
+
+    double a = getLatticeNoise(x0, z0) + (getLatticeNoise(x0 + 1, z0) - getLatticeNoise(x0, z0)) * fx;
+    double b = getLatticeNoise(x0, z0 + 1) + (getLatticeNoise(x0 + 1, z0 + 1) - getLatticeNoise(x0, z0 + 1)) * fx;
+
+    return a + (b - a) * fz;
+
+}
+
+// This method returns the height of the terrain at a point: a few octaves of noise, flattened around the pad and rising towards the edges
+double getTerrainHeight (double x, double z) {
+
+    double dx = x - launchSiteX;
+    double dz = z - launchSiteZ;
+
+    double height = 0;
+    double amplitude = 0.5;
+    double frequency = 1.0 / 1500;
+
+    for (int octave=0; octave<6; octave++) {
+        height += getValueNoise(x * frequency, z * frequency) * amplitude;
+        amplitude *= 0.5;
+        frequency *= 2.1;
+    }
+
+    // Fade the terrain in from the edge of the pad
+    double t = min(max((sqrt(dx * dx + dz * dz) - padRadius) / (padRadius * 4), 0.0), 1.0);
+
+    return height * terrainHeight * t * t * (3 - 2 * t);
+
+}
+
+// The size of the terrain cells the ground contact tests are made against
+const double contactCellSize = 50;
+
+// How deep below the surface the ground is solid for the contact tests (deeper than the rocket can sink in one step)
+const double contactDepth = 1000;
+
+// This method tests a hull against the terrain under it. Only the cells of terrain under the hull are tested, and only once it is low enough to reach them, each with GJK against a prism of solid ground under one terrain triangle
+bool isTouchingGround (const ConvexHull &hull, double downrange, double altitude) {
+
+    // Above the highest mountains, nothing to test
+    if (altitude + hull.minY > terrainHeight) {
+        return false;
+    }
+
+    // The hull on the ground track (downrange along x, with the curve of the planet ignored over the size of a rocket)
+    Point3D position = {launchSiteX + downrange, altitude, launchSiteZ};
+
+    int firstColumn = (int) floor((position.x + hull.minX) / contactCellSize);
+    int lastColumn = (int) floor((position.x + hull.maxX) / contactCellSize);
+    int firstRow = (int) floor((position.z + hull.minZ) / contactCellSize);
+    int lastRow = (int) floor((position.z + hull.maxZ) / contactCellSize);
+
+    // The ground under the hull, as two triangles per cell, each standing on a column of solid ground below it
+    vector<Point3D> prism(6);
+
+    for (int row=firstRow; row<=lastRow; row++) {
+        for (int column=firstColumn; column<=lastColumn; column++) {
+
+            double x0 = column * contactCellSize;
+            double z0 = row * contactCellSize;
+            double x1 = x0 + contactCellSize;
+            double z1 = z0 + contactCellSize;
+
+            Point3D corners[4] = {
+                {x0, getTerrainHeight(x0, z0), z0},
+                {x1, getTerrainHeight(x1, z0), z0},
+                {x1, getTerrainHeight(x1, z1), z1},
+                {x0, getTerrainHeight(x0, z1), z1}
+            };
+
+            double top = max(max(corners[0].y, corners[1].y), max(corners[2].y, corners[3].y));
+
+            if (altitude + hull.minY > top) {
+                continue;
+            }
+
+            for (int half=0; half<2; half++) {
+
+                const Point3D &a = corners[0];
+                const Point3D &b = corners[1 + half];
+                const Point3D &c = corners[2 + half];
+
+                prism[0] = a;
+                prism[1] = b;
+                prism[2] = c;
+                prism[3] = Point3D{a.x, a.y - contactDepth, a.z};
+                prism[4] = Point3D{b.x, b.y - contactDepth, b.z};
+                prism[5] = Point3D{c.x, c.y - contactDepth, c.z};
+
+                if (isIntersecting(hull.vertices, position, prism)) {
+                    return true;
+                }
+
+            }
+
+        }
+    }
+
+    return false;
+
+}
+
+// This method tests the rocket's hull against the terrain under it
+int getGroundContact (const FlightState &state, const FlightParams &params) {
+
+    double speed = sqrt(state.vel * state.vel + state.hvel * state.hvel);
+    int touchdown = speed > safeLandingSpeed ? FLIGHT_CRASHED : FLIGHT_LANDED;
+
+    if (!params.hull || params.hull->vertices.empty()) {
+        return state.pos < 0 ? touchdown : FLIGHT_ACTIVE;
+    }
+
+    return isTouchingGround(*params.hull, state.angle * planetRadius, state.pos) ? touchdown : FLIGHT_ACTIVE;
+
+}
+
+// This struct is one generated terrain tile: a grid of vertices with a skirt hanging down from its border (which hides the cracks between tiles of different levels)
+struct TerrainTile
+{
+    // x, y, z per vertex, and red, green, blue per vertex
+    vector<GLfloat> vertices;
+    vector<GLubyte> colors;
+};
+
+// This struct is one entry of the tile cache
+struct TerrainCacheEntry
+{
+    shared_ptr<TerrainTile> tile;
+    bool loading;
+
+    // The frame the tile was last drawn in, and its position in the least recently drawn order
+    int lastUsed;
+    list<uint64_t>::iterator lru;
+};
+
+// The tile cache, by tile key (render thread only)
+map<uint64_t, TerrainCacheEntry> terrainTiles;
+list<uint64_t> terrainLRU;
+size_t terrainCacheBytes = 0;
+
+// The index list shared by every tile (grid triangles, then skirt triangles)
+vector<GLushort> terrainIndices;
+
+// The number of the frame being drawn (for the tile cache)
+int terrainFrame = 0;
+
+// This method returns the key of a tile: its level and its column and row at that level
+uint64_t getTerrainKey (int level, int x, int z) {
+
+    return ((uint64_t) level << 48) | ((uint64_t) x << 24) | (uint64_t) z;
+
+}
+
+// This void method returns the level, column and row of a tile key
+void getTerrainTile (uint64_t key, int &level, int &x, int &z) {
+
+    level = key >> 48;
+    x = (key >> 24) & 0xFFFFFF;
+    z = key & 0xFFFFFF;
+
+}
+
+// This method returns the memory held by a tile
+size_t getTerrainTileBytes (const TerrainTile &tile) {
+
+    return sizeof(TerrainTile) + tile.vertices.capacity() * sizeof(GLfloat) + tile.colors.capacity();
+
+}
+
+// This void method returns the grid column and row of the k-th vertex around the border of a tile (anticlockwise from the first vertex)
+void getTerrainBorder (int k, int &i, int &j) {
+
+    int n = terrainTileQuads;
+
+    if (k < n) {
+        i = k; j = 0;
+    } else if (k < n * 2) {
+        i = n; j = k - n;
+    } else if (k < n * 3) {
+        i = n * 3 - k; j = n;
+    } else {
+        i = 0; j = n * 4 - k;
+    }
+
+}
+
+// This method generates a tile (runs on the job system). Its grid samples the terrain function at the tile's resolution, and its skirt drops 5% of the tile size below the border
+shared_ptr<TerrainTile> generateTerrainTile (int level, int x, int z) {
+
+    int side = terrainTileQuads + 1;
+    double size = terrainExtent / (1 << level);
+    double left = launchSiteX - terrainExtent / 2 + x * size;
+    double back = launchSiteZ - terrainExtent / 2 + z * size;
+
+    shared_ptr<TerrainTile> tile = make_shared<TerrainTile>();
+
+    int vertexCount = side * side + terrainTileQuads * 4;
+    tile->vertices.reserve(vertexCount * 3);
+    tile->colors.reserve(vertexCount * 3);
+
+    auto addVertex = [&tile](double vx, double vy, double vz) {
+
+        tile->vertices.push_back(vx);
+        tile->vertices.push_back(vy);
+        tile->vertices.push_back(vz);
+
+        // Grass low down, rock higher up and snow on the peaks
+        double t = vy / terrainHeight;
+        GLubyte r = t < 0.3 ? 40 + t * 200 : (t < 0.45 ? 110 : 240);
+        GLubyte g = t < 0.3 ? 160 - t * 150 : (t < 0.45 ? 100 : 240);
+        GLubyte b = t < 0.3 ? 40 : (t < 0.45 ? 80 : 250);
+
+        tile->colors.push_back(r);
+        tile->colors.push_back(g);
+        tile->colors.push_back(b);
+
+    };
+
+    for (int j=0; j<side; j++) {
+        for (int i=0; i<side; i++) {
+
+            double vx = left + i * size / terrainTileQuads;
+            double vz = back + j * size / terrainTileQuads;
+
+            addVertex(vx, getTerrainHeight(vx, vz), vz);
+
+        }
+    }
+
+    // The skirt follows the border of the grid all the way round
+    int border = terrainTileQuads * 4;
+
+    for (int k=0; k<border; k++) {
+
+        int i, j;
+        getTerrainBorder(k, i, j);
+
+        const GLfloat *top = &tile->vertices[(j * side + i) * 3];
+        addVertex(top[0], top[1] - size * 0.05, top[2]);
+
+    }
+
+    return tile;
+
+}
+
+// This void method builds the index list shared by every tile
+void buildTerrainIndices () {
+
+    int side = terrainTileQuads + 1;
+
+    for (int j=0; j<terrainTileQuads; j++) {
+        for (int i=0; i<terrainTileQuads; i++) {
+
+            GLushort a = j * side + i;
+            GLushort b = a + 1;
+            GLushort c = a + side;
+            GLushort d = c + 1;
+
+            GLushort quad[6] = {a, b, d, a, d, c};
+            terrainIndices.insert(terrainIndices.end(), quad, quad + 6);
+
+        }
+    }
+
+    // One quad of skirt below every border edge
+    int border = terrainTileQuads * 4;
+    int skirt = side * side;
+
+    for (int k=0; k<border; k++) {
+
+        int i0, j0, i1, j1;
+        getTerrainBorder(k, i0, j0);
+        getTerrainBorder((k + 1) % border, i1, j1);
+
+        GLushort a = j0 * side + i0;
+        GLushort b = j1 * side + i1;
+        GLushort c = skirt + (k + 1) % border;
+        GLushort d = skirt + k;
+
+        GLushort quad[6] = {a, b, c, a, c, d};
+        terrainIndices.insert(terrainIndices.end(), quad, quad + 6);
+
+    }
+
+}
+
+// This void method drops the least recently drawn tiles until the cache fits its budget again. Tiles drawn this frame and the root tile (the fallback for everything) are kept
+void trimTerrainCache () {
+
+    list<uint64_t>::iterator it = terrainLRU.end();
+
+    while (terrainCacheBytes > terrainCacheBudget && it != terrainLRU.begin()) {
+
+        --it;
+
+        TerrainCacheEntry &entry = terrainTiles[*it];
+
+        if (entry.lastUsed == terrainFrame || *it == getTerrainKey(0, 0, 0)) {
+            continue;
+        }
+
+        terrainCacheBytes -= getTerrainTileBytes(*entry.tile);
+        terrainTiles.erase(*it);
+        it = terrainLRU.erase(it);
+
+    }
+
+}
+
+// This method returns a tile if it is generated, and otherwise starts generating it on the job system and returns nullptr
+const TerrainTile *requestTerrainTile (uint64_t key) {
+
+    map<uint64_t, TerrainCacheEntry>::iterator found = terrainTiles.find(key);
+
+    if (found != terrainTiles.end()) {
+
+        TerrainCacheEntry &entry = found->second;
+
+        if (entry.loading) {
+            return nullptr;
+        }
+
+        // Mark the tile as the most recently drawn
+        entry.lastUsed = terrainFrame;
+        terrainLRU.splice(terrainLRU.begin(), terrainLRU, entry.lru);
+
+        return entry.tile.get();
+
+    }
+
+    TerrainCacheEntry &entry = terrainTiles[key];
+    entry.loading = true;
+    entry.lastUsed = terrainFrame;
+
+    int level, x, z;
+    getTerrainTile(key, level, x, z);
+
+    runJob([key, level, x, z]() {
+
+        shared_ptr<TerrainTile> tile = generateTerrainTile(level, x, z);
+
+        // Hand the finished tile to the render thread
+        runOnMainThread([key, tile]() {
+
+            map<uint64_t, TerrainCacheEntry>::iterator found = terrainTiles.find(key);
+
+            if (found == terrainTiles.end()) {
+                return;
+            }
+
+            TerrainCacheEntry &entry = found->second;
+            entry.tile = tile;
+            entry.loading = false;
+
+            terrainLRU.push_front(key);
+            entry.lru = terrainLRU.begin();
+            terrainCacheBytes += getTerrainTileBytes(*tile);
+
+            trimTerrainCache();
+
+        });
+
+    });
+
+    return nullptr;
+
+}
+
+// This struct is a quadtree node waiting to be refined, ordered by how many pixels its error covers on screen, and then by how close to the launch site it is on screen (so when the budget runs out part way through a level, the tiles around the rocket are refined first)
+struct TerrainCandidate
+{
+    double error;
+    double distance;
+    uint64_t key;
+
+    bool operator< (const TerrainCandidate &other) const {
+        return error < other.error || (error == other.error && distance > other.distance);
+    }
+};
+
+// This method transforms a point by a column-major 4x4 matrix (as OpenGL keeps them) into clip coordinates x, y, z and w
+void transformClipPoint (const double matrix[16], double x, double y, double z, double clip[4]) {
+
+    for (int r=0; r<4; r++) {
+        clip[r] = matrix[r] * x + matrix[4 + r] * y + matrix[8 + r] * z + matrix[12 + r];
+    }
+
+}
+
+// This method returns the tiles to draw for a view given by the matrix taking terrain coordinates to clip coordinates (the projection times the modelview), in a window width by height pixels. Tiles whose bounds are entirely outside the view volume are dropped. Starting from the root, the tile whose error covers the most pixels on screen is split into its four children, until every tile is detailed enough or the triangle budget would be exceeded
+vector<uint64_t> selectTerrainTiles (const double view[16], int width, int height) {
+
+    int tileTriangles = terrainIndices.size() / 3;
+    int maxTiles = max(1, terrainTriangleBudget / tileTriangles);
+
+    // A tile's error is in the heights between its samples: taking the slopes of the terrain as at most 1, a height can be off by up to the sample spacing. The error is vertical, so its size on screen is that of a vertical line (the same for every tile in an orthographic view)
+    double pixelsPerHeight = sqrt(pow(view[4] * width / 2, 2) + pow(view[5] * height / 2, 2));
+
+    // Where the launch site is on screen
+    double site[4];
+    transformClipPoint(view, launchSiteX, 0, launchSiteZ, site);
+
+    priority_queue<TerrainCandidate> candidates;
+    vector<uint64_t> selected;
+
+    auto addCandidate = [&](int level, int x, int z) {
+
+        double size = terrainExtent / (1 << level);
+        double left = launchSiteX - terrainExtent / 2 + x * size;
+        double back = launchSiteZ - terrainExtent / 2 + z * size;
+
+        // The bounds of the tile: the terrain lies between the ground and the highest mountains, and the skirt hangs 5% of the tile below it
+        double bottom = -0.05 * size;
+        double top = terrainHeight;
+
+        // Drop the tile if all eight corners of its bounds are outside the same plane of the view volume
+        int outside[6] = {0, 0, 0, 0, 0, 0};
+        double nearest = numeric_limits<double>::max();
+
+        for (int c=0; c<8; c++) {
+
+            double clip[4];
+            transformClipPoint(view, left + (c & 1) * size, (c & 2) ? top : bottom, back + ((c >> 2) & 1) * size, clip);
+
+            for (int axis=0; axis<3; axis++) {
+                outside[axis * 2] += clip[axis] < -clip[3];
+                outside[axis * 2 + 1] += clip[axis] > clip[3];
+            }
+
+            nearest = min(nearest, hypot((clip[0] / clip[3] - site[0] / site[3]) * width, (clip[1] / clip[3] - site[1] / site[3]) * height));
+
+        }
+
+        for (int plane=0; plane<6; plane++) {
+            if (outside[plane] == 8) {
+                return false;
+            }
+        }
+
+        TerrainCandidate candidate;
+        candidate.error = size / terrainTileQuads * pixelsPerHeight;
+        candidate.distance = nearest;
+        candidate.key = getTerrainKey(level, x, z);
+
+        candidates.push(candidate);
+
+        return true;
+
+    };
+
+    int tiles = addCandidate(0, 0, 0) ? 1 : 0;
+
+    while (!candidates.empty()) {
+
+        TerrainCandidate candidate = candidates.top();
+        candidates.pop();
+
+        int level, x, z;
+        getTerrainTile(candidate.key, level, x, z);
+
+        // Splitting replaces one tile with up to four (those of its children in view)
+        if (candidate.error > terrainDetail && level < terrainMaxLevel && tiles + 3 <= maxTiles) {
+
+            tiles--;
+
+            for (int c=0; c<4; c++) {
+                tiles += addCandidate(level + 1, x * 2 + (c & 1), z * 2 + (c >> 1));
+            }
+
+        } else {
+            selected.push_back(candidate.key);
+        }
+
+    }
+
+    return selected;
+
+}
+
+// This method returns the key of a tile's parent
+uint64_t getTerrainParent (uint64_t key) {
+
+    int level, x, z;
+    getTerrainTile(key, level, x, z);
+
+    return getTerrainKey(level - 1, x / 2, z / 2);
+
+}
+
+// This method draws the terrain in the current view, with the ground moved down by groundY. Returns the number of triangles drawn
+int drawTerrain (double groundY) {
+
+    if (terrainIndices.empty()) {
+        buildTerrainIndices();
+    }
+
+    terrainFrame++;
+
+    glPushMatrix();
+    glTranslated(0, groundY, 0);
+
+    // The matrix taking terrain coordinates to clip coordinates, and the size of the window, to select the tiles by
+    GLdouble modelview[16], projection[16], view[16];
+    GLint viewport[4];
+
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
+    glGetDoublev(GL_PROJECTION_MATRIX, projection);
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    for (int c=0; c<4; c++) {
+        for (int r=0; r<4; r++) {
+            view[c * 4 + r] = 0;
+            for (int k=0; k<4; k++) {
+                view[c * 4 + r] += projection[k * 4 + r] * modelview[c * 4 + k];
+            }
+        }
+    }
+
+    vector<uint64_t> selected = selectTerrainTiles(view, viewport[2], viewport[3]);
+
+    // Draw every selected tile that is generated, and the nearest generated ancestor of every one that is not (an ancestor covers its descendants, so they are not drawn as well)
+    set<uint64_t> drawn;
+
+    requestTerrainTile(getTerrainKey(0, 0, 0));
+
+    for (uint64_t key : selected) {
+
+        uint64_t tile = key;
+
+        while (requestTerrainTile(tile) == nullptr && tile != getTerrainKey(0, 0, 0)) {
+            tile = getTerrainParent(tile);
+        }
+
+        drawn.insert(tile);
+
+    }
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+
+    int triangles = 0;
+
+    for (uint64_t key : drawn) {
+
+        map<uint64_t, TerrainCacheEntry>::iterator found = terrainTiles.find(key);
+
+        if (found == terrainTiles.end() || found->second.loading) {
+            continue;
+        }
+
+        // Skip tiles covered by a drawn ancestor
+        bool covered = false;
+
+        for (uint64_t up = key; !covered && up != getTerrainKey(0, 0, 0); ) {
+            up = getTerrainParent(up);
+            covered = drawn.count(up) > 0;
+        }
+
+        if (covered) {
+            continue;
+        }
+
+        const TerrainTile &tile = *found->second.tile;
+
+        glVertexPointer(3, GL_FLOAT, 0, &tile.vertices[0]);
+        glColorPointer(3, GL_UNSIGNED_BYTE, 0, &tile.colors[0]);
+        glDrawElements(GL_TRIANGLES, terrainIndices.size(), GL_UNSIGNED_SHORT, &terrainIndices[0]);
+
+        triangles += terrainIndices.size() / 3;
+
+    }
+
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    glPopMatrix();
+
+    // Tiles no longer drawn can go now if the cache is over budget
+    trimTerrainCache();
+
+    return triangles;
+
+}
+
+// Exhaust particles - while the engines burn, the rocket leaves a plume of hot exhaust that cools into smoke. The particles live in one fixed-size pool laid out as a structure of arrays (one array per value, so four particles fit in one SIMD register), are updated in batches on the job system, and are drawn with a single call. Positions are kept relative to the ground, so the plume stays behind as the rocket climbs
+
+// The most particles alive at once
+const int particleCapacity = 1 << 18;
+
+// The particles emitted per second for every unit of lift still burning, and the share of them that are smoke
+double particleRate = 20000;
+const double smokeShare = 0.3;
+
+// The upward acceleration of cold smoke, and how much of their speed particles lose per second
+const float smokeBuoyancy = 40;
+const float particleDrag = 1.5;
+
+// This struct is the particle pool. The first count entries of every array are the live particles
+struct ParticlePool
+{
+    int count;
+
+    // Position and velocity (relative to the ground), age and lifetime in seconds, and heat (1 for exhaust, 0 for smoke)
+    vector<float> x, y, z;
+    vector<float> vx, vy, vz;
+    vector<float> age, life, heat;
+
+    // What is drawn, rewritten by every update: x, y, z and an unused 1 per particle, and red, green, blue, alpha per particle
+    vector<float> vertices;
+    vector<float> colors;
+
+    // The game clock and the rocket altitude at the last update, the fraction of a particle still owed to the emitter, and the random number state
+    double lastTime;
+    double lastAltitude;
+    double spawnDebt;
+    uint32_t seed;
+};
+
+ParticlePool particles = ParticlePool();
+
+// This method returns a pseudo-random number between -1 and 1 (xorshift, cheap enough to call per particle)
+float getParticleRandom () {
+
+    uint32_t &s = particles.seed;
+
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+
+    return (s & 0xFFFFFF) / (float) 0x7FFFFF - 1.0f;
+
+}
+
+// This void method allocates the particle pool (once, at full capacity, so particles are never allocated one by one)
+void initParticles () {
+
+    for (vector<float> *values : {&particles.x, &particles.y, &particles.z, &particles.vx, &particles.vy, &particles.vz, &particles.age, &particles.life, &particles.heat}) {
+        values->assign(particleCapacity, 0);
+    }
+
+    particles.vertices.assign(particleCapacity * 4, 1);
+    particles.colors.assign(particleCapacity * 4, 0);
+
+    particles.count = 0;
+    particles.seed = 2463534242u;
+
+}
+
+// This void method adds particles below the rocket for dt seconds of burning. The emission rate follows the lift still burning, the exhaust speed follows the thrust, and new particles are spread along the path the rocket flew since the last update
+void emitParticles (double dt, double altitude) {
+
+    const PartWorld &world = partWorld;
+
+    // The lift still burning (all of it until the simulation has picked up the launch)
+    double lift = currentFlight.launch == launchCount ? currentFlight.state.lift : assemblyTotals.lift;
+
+    if (!BLASTOFF || lift <= 0 || world.assembled == 0) {
+        particles.spawnDebt = 0;
+        return;
+    }
+
+    // The nozzle: under the lowest part, in the middle of the rocket
+    double bottom = 1000000;
+    double centreX = 0;
+    double centreZ = 0;
+
+    for (int run=0; run<world.assembled; run=getRunEnd(run, world.assembled)) {
+
+        const PartBounds *bounds = world.bounds.getRun(run);
+        const Point3D *transforms = world.transforms.getRun(run);
+
+        for (int k=0; k<getRunEnd(run, world.assembled)-run; k++) {
+
+            bottom = min(bottom, bounds[k].minY + transforms[k].y);
+            centreX += (bounds[k].minX + bounds[k].maxX) / 2 + transforms[k].x;
+            centreZ += (bounds[k].minZ + bounds[k].maxZ) / 2 + transforms[k].z;
+
+        }
+
+    }
+
+    centreX = launchSiteX + centreX / world.assembled;
+    centreZ = launchSiteZ + centreZ / world.assembled;
+
+    particles.spawnDebt += particleRate * lift * dt;
+
+    int spawn = min((int) particles.spawnDebt, particleCapacity - particles.count);
+    particles.spawnDebt -= (int) particles.spawnDebt;
+
+    float exhaustSpeed = 200 + 2 * assemblyTotals.thrust;
+
+    for (int n=0; n<spawn; n++) {
+
+        int i = particles.count++;
+        bool smoke = (getParticleRandom() + 1) / 2 < smokeShare;
+
+        // Spread the new particles along the path since the last update
+        double along = (double) n / spawn;
+
+        particles.x[i] = centreX + getParticleRandom() * 4;
+        particles.y[i] = bottom + particles.lastAltitude + (altitude - particles.lastAltitude) * along;
+        particles.z[i] = centreZ + getParticleRandom() * 4;
+
+        particles.vx[i] = getParticleRandom() * (smoke ? 60 : 30);
+        particles.vy[i] = -exhaustSpeed * (smoke ? 0.3f : 1.0f) * (1 + getParticleRandom() * 0.2f);
+        particles.vz[i] = getParticleRandom() * (smoke ? 60 : 30);
+
+        // Particles that are already older were emitted earlier in the step
+        particles.age[i] = along * dt;
+        particles.life[i] = smoke ? 2.5f + getParticleRandom() : 0.5f + getParticleRandom() * 0.2f;
+        particles.heat[i] = smoke ? 0 : 1;
+
+    }
+
+}
+
+// This void method removes every particle that has lived out its lifetime, moving the last live particle into its place (which keeps the live particles together at the front of the arrays)
+void killParticles () {
+
+    int i = 0;
+
+    while (i < particles.count) {
+
+        if (particles.age[i] < particles.life[i]) {
+            i++;
+            continue;
+        }
+
+        int last = --particles.count;
+
+        for (vector<float> *values : {&particles.x, &particles.y, &particles.z, &particles.vx, &particles.vy, &particles.vz, &particles.age, &particles.life, &particles.heat}) {
+            (*values)[i] = (*values)[last];
+        }
+
+    }
+
+}
+
+// This void method moves the particles first to last along by dt seconds and writes their vertices and colours. With SSE, four particles are done at a time
+void updateParticleRange (int first, int last, float dt) {
+
+    float damping = max(0.0f, 1 - particleDrag * dt);
+
+    // The ground in particle coordinates is the pad (where the rocket stood at blastoff)
+    float ground = padLevel;
+
+    int i = first;
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    __m128 vdt = _mm_set1_ps(dt);
+    __m128 vdamping = _mm_set1_ps(damping);
+    __m128 vbuoyancy = _mm_set1_ps(smokeBuoyancy * dt);
+    __m128 vground = _mm_set1_ps(ground);
+    __m128 vbounce = _mm_set1_ps(-0.3f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 one = _mm_set1_ps(1);
+
+    for (; i + 4 <= last; i += 4) {
+
+        __m128 age = _mm_add_ps(_mm_loadu_ps(&particles.age[i]), vdt);
+        __m128 heat = _mm_loadu_ps(&particles.heat[i]);
+
+        // Smoke rises, everything slows down
+        __m128 vx = _mm_mul_ps(_mm_loadu_ps(&particles.vx[i]), vdamping);
+        __m128 vy = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(&particles.vy[i]), _mm_mul_ps(vbuoyancy, _mm_sub_ps(one, heat))), vdamping);
+        __m128 vz = _mm_mul_ps(_mm_loadu_ps(&particles.vz[i]), vdamping);
+
+        __m128 x = _mm_add_ps(_mm_loadu_ps(&particles.x[i]), _mm_mul_ps(vx, vdt));
+        __m128 y = _mm_add_ps(_mm_loadu_ps(&particles.y[i]), _mm_mul_ps(vy, vdt));
+        __m128 z = _mm_add_ps(_mm_loadu_ps(&particles.z[i]), _mm_mul_ps(vz, vdt));
+
+        // Particles that hit the ground bounce off it weakly and spread out
+        __m128 below = _mm_cmplt_ps(y, vground);
+        y = _mm_max_ps(y, vground);
+        vy = _mm_or_ps(_mm_and_ps(below, _mm_mul_ps(vy, vbounce)), _mm_andnot_ps(below, vy));
+
+        _mm_storeu_ps(&particles.age[i], age);
+        _mm_storeu_ps(&particles.vx[i], vx);
+        _mm_storeu_ps(&particles.vy[i], vy);
+        _mm_storeu_ps(&particles.vz[i], vz);
+        _mm_storeu_ps(&particles.x[i], x);
+        _mm_storeu_ps(&particles.y[i], y);
+        _mm_storeu_ps(&particles.z[i], z);
+
+        // Exhaust goes from yellow to red and fades, smoke stays grey and fades more slowly
+        __m128 t = _mm_min_ps(_mm_div_ps(age, _mm_loadu_ps(&particles.life[i])), one);
+        __m128 cold = _mm_sub_ps(one, heat);
+
+        __m128 r = _mm_add_ps(_mm_mul_ps(heat, _mm_sub_ps(one, _mm_mul_ps(t, _mm_set1_ps(0.2f)))), _mm_mul_ps(cold, _mm_set1_ps(0.6f)));
+        __m128 g = _mm_add_ps(_mm_mul_ps(heat, _mm_sub_ps(_mm_set1_ps(0.9f), _mm_mul_ps(t, _mm_set1_ps(0.7f)))), _mm_mul_ps(cold, _mm_set1_ps(0.6f)));
+        __m128 b = _mm_add_ps(_mm_mul_ps(heat, _mm_sub_ps(_mm_set1_ps(0.3f), _mm_mul_ps(t, _mm_set1_ps(0.25f)))), _mm_mul_ps(cold, _mm_set1_ps(0.62f)));
+        __m128 a = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(one, t), _mm_add_ps(_mm_set1_ps(0.4f), _mm_mul_ps(heat, _mm_set1_ps(0.6f)))), zero);
+
+        // Turn the four particles' values into four vertices and four colours
+        __m128 w = one;
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        _mm_storeu_ps(&particles.vertices[i*4], x);
+        _mm_storeu_ps(&particles.vertices[i*4+4], y);
+        _mm_storeu_ps(&particles.vertices[i*4+8], z);
+        _mm_storeu_ps(&particles.vertices[i*4+12], w);
+
+        _MM_TRANSPOSE4_PS(r, g, b, a);
+        _mm_storeu_ps(&particles.colors[i*4], r);
+        _mm_storeu_ps(&particles.colors[i*4+4], g);
+        _mm_storeu_ps(&particles.colors[i*4+8], b);
+        _mm_storeu_ps(&particles.colors[i*4+12], a);
+
+    }
+#endif
+
+    // The same, one particle at a time (the particles left over, or everything without SSE)
+    for (; i < last; i++) {
+
+        float heat = particles.heat[i];
+
+        particles.age[i] += dt;
+
+        particles.vx[i] *= damping;
+        particles.vy[i] = (particles.vy[i] + smokeBuoyancy * dt * (1 - heat)) * damping;
+        particles.vz[i] *= damping;
+
+        particles.x[i] += particles.vx[i] * dt;
+        particles.y[i] += particles.vy[i] * dt;
+        particles.z[i] += particles.vz[i] * dt;
+
+        if (particles.y[i] < ground) {
+            particles.y[i] = ground;
+            particles.vy[i] *= -0.3f;
+        }
+
+        float t = min(particles.age[i] / particles.life[i], 1.0f);
+
+        float *vertex = &particles.vertices[i*4];
+        vertex[0] = particles.x[i];
+        vertex[1] = particles.y[i];
+        vertex[2] = particles.z[i];
+
+        float *color = &particles.colors[i*4];
+        color[0] = heat * (1 - t * 0.2f) + (1 - heat) * 0.6f;
+        color[1] = heat * (0.9f - t * 0.7f) + (1 - heat) * 0.6f;
+        color[2] = heat * (0.3f - t * 0.25f) + (1 - heat) * 0.62f;
+        color[3] = max((1 - t) * (0.4f + heat * 0.6f), 0.0f);
+
+    }
+
+}
+
+// This void method advances the particle system to the game clock: emit, drop the dead, then update the live particles in parallel batches. altitude is the rocket's
+void updateParticles (double altitude) {
+
+    if (particles.vertices.empty()) {
+        initParticles();
+        particles.lastTime = getElapsedMillis() / 1000.0;
+        particles.lastAltitude = altitude;
+    }
+
+    double now = getElapsedMillis() / 1000.0;
+    double dt = min(now - particles.lastTime, 0.1);
+
+    particles.lastTime = now;
+
+    if (dt <= 0) {
+        return;
+    }
+
+    emitParticles(dt, altitude);
+    particles.lastAltitude = altitude;
+
+    killParticles();
+
+    // Batches of a multiple of four particles, so that the SIMD groups never straddle two batches
+    parallelFor(0, particles.count, 16384, [dt](int first, int last) {
+        updateParticleRange(first, last, dt);
+    });
+
+}
+
+// This void method draws every live particle as a blended point in one call, with the ground moved down by groundY (like the terrain)
+void drawParticles (double groundY) {
+
+    if (particles.count == 0) {
+        return;
+    }
+
+    glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_POINT_BIT);
+    glPushMatrix();
+
+    // The particles are drawn at their altitude relative to the ground
+    glTranslated(0, groundY - padLevel, 0);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDepthMask(GL_FALSE);
+    glPointSize(3);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 4 * sizeof(float), &particles.vertices[0]);
+    glColorPointer(4, GL_FLOAT, 0, &particles.colors[0]);
+
+    glDrawArrays(GL_POINTS, 0, particles.count);
+
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
+    glPopMatrix();
+    glPopAttrib();
+
+}
+
+// This void method draws the rocket launch simulation
+void drawRocketLaunch ()
+{
+
+    // Draw a shifting color background (the higher you are, the blacker the background becomes to emulate space)
+    glClearColor(1.0 - v_pos * 0.0005, 1.0- v_pos * 0.0005, 1.0- v_pos * 0.0005, 0.0);
+
+    // Translate/Center the global perspective view (observer)
+    glTranslated(-100, 0, 0);
+
+    // Rotate the entire global perspective view (observer)
+    glRotated(30, 1, 0, 1);
+
+    glPushMatrix();
+
+    // To simulate the rockjet moving forwards without moving the entire perspective, move the ground backwards
+    double height = padLevel - v_pos;
+
+    // Draw the terrain at the new vertical position, or a flat green ground until its first tile is generated
+    if (drawTerrain(height) == 0) {
+
+        glBegin(GL_POLYGON);
+
+        // Set the color to green
+        glColor3f(0.0, 1.0, 0.0);
+
+        // Draw the ground plane at the new vertical position
+        glVertex3d(10000, height, 10000);
+        glVertex3d(-10000, height, 10000);
+        glVertex3d(-10000, height, -10000);
+        glVertex3d(10000, height, -10000);
+
+        glEnd();
+
+    }
+
+    glPopMatrix();
+
+    // Draw the rocket in blue
+    glPushMatrix();
+
+        // Initialize the matrix modelview mode for glDraw display
+        glMatrixMode(GL_MODELVIEW);
+
+        // Tilt the rocket by its launch pitch, about its centre of mass
+        glTranslated(550 + assemblyMass.centre.x, assemblyMass.centre.y, -300 + assemblyMass.centre.z);
+        glRotated(-launchPitch, 0, 0, 1);
+        glTranslated(-550 - assemblyMass.centre.x, -assemblyMass.centre.y, 300 - assemblyMass.centre.z);
+
+        drawParts(partWorld, 0, partWorld.assembled, 550, 0, -300, 0, 0, 1);
+
+    glPopMatrix();
+
+    // Draw the fleet around the rocket
+    if (fleet.size > 0) {
+        drawFleet(550, 0, -300);
+    }
+
+    // Draw the exhaust last, over everything it is in front of
+    drawParticles(height);
+}
+
+// The centre and radius of the orbit map on the launch screen
+const double orbitMapX = 830;
+const double orbitMapY = 170;
+const double orbitMapRadius = 140;
+
+// This void method draws a map of the planet in the corner of the launch screen, with the rocket and the orbit it would coast along from where it is now
+void drawOrbitMap (const FlightState &state) {
+
+    Orbit orbit = getOrbit(state, 0);
+
+    double periapsis, apoapsis;
+    getApsides(orbit, periapsis, apoapsis);
+
+    // Fit the planet and the orbit in the map (up to four planet radii out, for orbits that go further or escape)
+    double reach = planetRadius + max(min(apoapsis, 3 * planetRadius), state.pos) * 1.1;
+    double scale = orbitMapRadius / reach;
+
+    glPushAttrib(GL_ENABLE_BIT | GL_POINT_BIT | GL_LINE_BIT);
+    glDisable(GL_DEPTH_TEST);
+
+    // The orbit (one full turn, or the way out for an escape orbit). It is drawn first so the planet hides the part under the ground
+    glColor3d(1, 1, 0);
+    glBegin(GL_LINE_STRIP);
+
+    double span = orbit.period > 0 ? orbit.period : 4 * reach / sqrt(state.vel * state.vel + state.hvel * state.hvel + 1);
+
+    for (int i=0; i<=128; i++) {
+
+        FlightState point = getOrbitState(orbit, span * i / 128);
+        double radius = (planetRadius + point.pos) * scale;
+
+        glVertex2d(orbitMapX + radius * sin(point.angle), orbitMapY + radius * cos(point.angle));
+
+    }
+
+    glEnd();
+
+    // The planet
+    glColor3d(0, 0.6, 0);
+    glBegin(GL_TRIANGLE_FAN);
+
+    glVertex2d(orbitMapX, orbitMapY);
+
+    for (int i=0; i<=64; i++) {
+        glVertex2d(orbitMapX + planetRadius * scale * sin(i * pi / 32), orbitMapY + planetRadius * scale * cos(i * pi / 32));
+    }
+
+    glEnd();
+
+    // The rocket
+    double radius = (planetRadius + state.pos) * scale;
+
+    glColor3d(1, 0, 0);
+    glPointSize(5);
+    glBegin(GL_POINTS);
+    glVertex2d(orbitMapX + radius * sin(state.angle), orbitMapY + radius * cos(state.angle));
+    glEnd();
+
+    glPopAttrib();
+
+}
+
+// This void method draws the flight readouts over the launch view: the launch pitch before blastoff, and then the altitude, speed, time warp and orbit, with the orbit map
+void drawFlightInfo () {
+
+    glLoadIdentity();
+    glOrtho(0, 1000, 0, 1000, -1200, 1200);
+
+    // Dark text on the bright sky, light text once it gets dark
+    double shade = v_pos > 1000 ? 1 : 0;
+    glColor3d(shade, shade, shade);
+
+    if (!BLASTOFF) {
+        renderString(20, 960, GLUT_BITMAP_HELVETICA_18, "Pitch: " + to_string((int) launchPitch) + " degrees (A and D to tilt)");
+        renderString(20, 925, GLUT_BITMAP_HELVETICA_18, "Press B to launch");
+        return;
+    }
+
+    // Nothing to show until the simulation picks the launch up
+    if (currentFlight.launch != launchCount) {
+        return;
+    }
+
+    const FlightState &state = currentFlight.state;
+
+    renderString(20, 960, GLUT_BITMAP_HELVETICA_18, "Altitude: " + formatWhole(state.pos) + "   Speed: " + formatWhole(sqrt(state.vel * state.vel + state.hvel * state.hvel)));
+    renderString(20, 925, GLUT_BITMAP_HELVETICA_18, "Time warp: " + to_string((int) currentFlight.warp) + "x" + (currentFlight.coasting ? " (, and . to change)" : " (only while coasting above the air)"));
+
+    if (currentFlight.coasting) {
+
+        double periapsis, apoapsis;
+        getApsides(currentFlight.orbit, periapsis, apoapsis);
+
+        renderString(20, 890, GLUT_BITMAP_HELVETICA_18, "Periapsis: " + formatWhole(periapsis) + "   Apoapsis: " + (isinf(apoapsis) ? string("escaping") : formatWhole(apoapsis)));
+
+    }
+
+    if (currentFlight.reachedSpace) {
+        renderString(20, 855, GLUT_BITMAP_HELVETICA_18, "You made it to space! Press SPACE to finish the flight");
+    }
+
+    drawOrbitMap(state);
+
+}
+
+// This void method clears the entire workspace and assembly
+void launchNewWorkspace () {
+
+    // Delete every part, in the workspace and in the assembly
+    partWorld = PartWorld();
+
+    assemblyMass = MassProperties();
+    assemblyHull.reset();
+    assemblyTotals = AssemblyTotals();
+    assemblyPrediction = FlightPrediction();
+
+    // The old rocket can no longer be brought back with undo
+    clearEditHistory();
+
+    // Ground the fleet
+    fleet.size = 0;
+
+    // The next rocket starts upright
+    launchPitch = 0;
+
+    // Clear the exhaust
+    particles.count = 0;
+
+    // Stop any flight still being simulated
+    SimulationCommand command = SimulationCommand();
+    command.type = SIM_ABORT;
+    simulationCommands.push(command);
+
+}
+
+// This is the default display method called by redraws. It contains code to distinguish the current stage of the game and draw the appropriate screen
+void display(void) {
+
+    // Rasterize the fonts into their atlases on the first frame (this draws into the frame before it is cleared)
+    if (!glyphAtlasesBuilt) {
+        buildGlyphAtlases();
+    }
+
+    // Clear the current color and depth buffer
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Draw the appropriate "stage" of the game depending on the user response
+    switch (stage) {
+
+        // Stage 0: intro screen
+        case 0:
+
+            // Scale the creen for the specific screen
+            glLoadIdentity();
+            glOrtho(0, 1000, 0, 1000, -1200, 1200);
+
+            // Draw the intro screen
+            drawIntroScreen();
+            break;
+
+        // Stage 1: rocket assembly screen
+        case 1:
+
+            // Scale the creen for the specific screen
+            glLoadIdentity();
+            glOrtho(0, 1000, 0, 1000, -1200, 1200);
+
+            // Draw the rocket assembly screen
+            drawRocketAssembly();
+            break;
+
+        // Stage 2: rocket launch screen
+        case 2:
+
+            // Scale the creen for the specific screen
+            glLoadIdentity();
+            //glOrtho(0, 20000, 0, 20000, -1200, 1200);
+            glOrtho(0, 1000, 0, 1000, -1200, 1200);
+
+            // Check to see if the user has launched their rocket yet
+            if (BLASTOFF) {
+
+                // If so, run rocket physics/launching simulation
+                launchRocket();
+
+                // Fly the fleet along with it
+                if (fleet.size > 0) {
+                    updateFleet(v_pos);
+                }
+
+            }
+
+            // Move the exhaust on (the engines only feed it while the rocket is launched)
+            updateParticles(v_pos);
+
+            // Draw the rocket once simulation phase completes for current cycle
+            drawRocketLaunch();
+
+            // Draw the readouts and the orbit map over it
+            drawFlightInfo();
+
+            break;
+
+        case 3:
+
+            // Player has reached space and won the game
+            drawWinScreen();
+
+            break;
+
+        case 4:
+
+            // Player just lost the game; launch try again screen with steps for relaunch
+            drawLosingScreen();
+
+            break;
+
+    }
+
+    // Flushing the matrix to the cache for double buffering
+    glutSwapBuffers();
+
+}
+
+
+// This void method applies change to the parts of every version of the rocket in the edit history (a catalog update is not an edit, so it cannot be undone). change is given the world of each version in turn and replaces the pools it changes; changing a pool with the same Changes for every version changes each node the versions share once, and it stays shared. The mass properties, hull and totals of each version whose physics values or shapes changed are worked out again, and the current version is shown again
+void changeEditHistory (const function<void (PartWorld &)> &change) {
+
+    for (EditState &state : editHistory) {
+
+        PartWorld before = state.world;
+        change(state.world);
+
+        const PartWorld &world = state.world;
+
+        if (world.assembled > 0 && (world.physics.root != before.physics.root || world.shapes.root != before.shapes.root)) {
+
+            state.mass = MassProperties();
+            state.hull.reset();
+            state.totals = AssemblyTotals();
+
+            addPartPhysics(world, 0, world.assembled, state.mass, state.hull, state.totals);
+            state.prediction = predictFlight(state.totals, state.hull, state.mass);
+
+        }
+
+    }
+
+    // Keep the selection (and any move not applied yet) while the parts change under it
+    int selected = getSelectedPart(partWorld);
+
+    const EditState &state = editHistory[editIndex];
+
+    partWorld = state.world;
+    selectPart(partWorld, selected);
+
+    assemblyMass = state.mass;
+    assemblyHull = state.hull;
+    assemblyTotals = state.totals;
+    assemblyPrediction = state.prediction;
+
+}
+
+// This void method points every placed part taken from catalog entry index at a newly loaded mesh (and its bounds), its silhouette, its mass properties and its convex hull
+void updatePlacedMeshes (int index, const MeshHandle &mesh, const SilhouetteHandle &silhouette, const MassPropertiesHandle &shape, const HullHandle &hull) {
+
+    PartBounds bounds = getMeshBounds(*mesh);
+
+    PartPool<MeshHandle>::Changes meshChanges;
+    PartPool<PartBounds>::Changes boundsChanges;
+    PartPool<PartShape>::Changes shapeChanges;
+
+    changeEditHistory([&](PartWorld &world) {
+
+        world.meshes = world.meshes.change([&](int part, MeshHandle &partMesh) {
+
+            if (world.catalogIndices[part] != index || partMesh == mesh) {
+                return false;
+            }
+
+            partMesh = mesh;
+
+            return true;
+
+        }, meshChanges);
+
+        world.bounds = world.bounds.change([&](int part, PartBounds &partBounds) {
+
+            if (world.catalogIndices[part] != index) {
+                return false;
+            }
+
+            partBounds = bounds;
+
+            return true;
+
+        }, boundsChanges);
+
+        world.shapes = world.shapes.change([&](int part, PartShape &partShape) {
+
+            if (world.catalogIndices[part] != index || (partShape.silhouette == silhouette && partShape.mass == shape && partShape.hull == hull)) {
+                return false;
+            }
+
+            partShape.silhouette = silhouette;
+            partShape.mass = shape;
+            partShape.hull = hull;
+
+            return true;
+
+        }, shapeChanges);
+
+    });
+
+}
+
+// This void method updates the physics engine values of every placed part taken from catalog entry index
+void updatePlacedPhysics (int index, const ComponentEntry &entry) {
+
+    PartPool<PartPhysics>::Changes changed;
+
+    changeEditHistory([&](PartWorld &world) {
+
+        world.physics = world.physics.change([&](int part, PartPhysics &physics) {
+
+            if (world.catalogIndices[part] != index) {
+                return false;
+            }
+
+            physics = getPartPhysics(entry);
+
+            return true;
+
+        }, changed);
+
+    });
+
+}
+
+// This method returns true if any placed part (in the workspace or the assembly of any version of the rocket that can be undone or redone) was taken from catalog entry index, reading only the catalog indices of the parts
+bool isPlaced (int index) {
+
+    for (const EditState &state : editHistory) {
+
+        const PartWorld &world = state.world;
+
+        for (int run=0; run<world.size; run=getRunEnd(run, world.size)) {
+
+            const int *catalogIndices = world.catalogIndices.getRun(run);
+
+            for (int k=0; k<getRunEnd(run, world.size)-run; k++) {
+                if (catalogIndices[k] == index) {
+                    return true;
+                }
+            }
+
+        }
+
+    }
+
+    return false;
+
+}
+
+// This void method applies a catalog update to the catalog, the mesh cache and all placed parts. Runs on the render thread between frames, so each swap is atomic from the point of view of drawing and input
+void applyComponentUpdate (ComponentUpdate *update) {
+
+    syncMeshCache();
+
+    int index = update->index;
+
+    if (update->newCatalogSize >= 0) {
+
+        // Entries were added, removed or reordered. The loader threads are done by now, so the render thread is the only one touching the catalog
+        int oldSize = catalogSize.load(memory_order_relaxed);
+        int newSize = update->newCatalogSize;
+        const vector<int> &remap = update->remap;
+
+        MeshCacheEntry blank;
+        blank.bytes = 0;
+        blank.loading = false;
+        blank.generation = 0;
+
+        vector<CatalogInfo> newCatalog(newSize);
+        vector<MeshCacheEntry> newCache(newSize, blank);
+        unique_ptr<atomic<bool>[]> ready(new atomic<bool>[newSize]);
+        vector<char> kept(newSize, false);
+
+        for (int i=0; i<newSize; i++) {
+            ready[i].store(false, memory_order_relaxed);
+        }
+
+        // Move every entry that is still there to its new slot, with its mesh and its place in the LRU list
+        for (int i=0; i<oldSize; i++) {
+
+            int j = remap[i];
+
+            if (j < 0) {
+                evictMesh(i);
+                continue;
+            }
+
+            newCatalog[j] = catalog[i];
+            newCache[j] = meshCache[i];
+            ready[j].store(componentReady[i].load(memory_order_relaxed), memory_order_relaxed);
+            kept[j] = j == i;
+
+        }
+
+        for (int &i : meshLRU) {
+            i = remap[i];
+        }
+
+        // A load still in flight for a slot that now holds another entry must not land there (a moved entry's own load is dropped too, and requested again)
+        vector<int> reload;
+
+        for (int j=0; j<newSize; j++) {
+            if (!kept[j]) {
+
+                if (newCache[j].loading) {
+                    reload.push_back(j);
+                }
+
+                newCache[j].generation = ++meshGenerations;
+                newCache[j].loading = false;
+
+            }
+        }
+
+        catalog.swap(newCatalog);
+        meshCache.swap(newCache);
+        componentReady.swap(ready);
+        catalogSize.store(newSize, memory_order_release);
+        componentsLoaded.store(newSize, memory_order_release);
+
+        // Placed parts follow their entry to its new index. Those whose entry was removed are kept as they are, but are no longer linked to the catalog
+        PartPool<int>::Changes changed;
+
+        changeEditHistory([&](PartWorld &world) {
+
+            world.catalogIndices = world.catalogIndices.change([&](int, int &catalogIndex) {
+
+                if (catalogIndex < 0 || catalogIndex >= oldSize || remap[catalogIndex] == catalogIndex) {
+                    return false;
+                }
+
+                catalogIndex = remap[catalogIndex];
+
+                return true;
+
+            }, changed);
+
+        });
+
+        for (int j : reload) {
+            if (isPlaced(j)) {
+                requestMesh(j);
+            }
+        }
+
+        if (menuScroll >= newSize) {
+            menuScroll = max(0, newSize - menuSlots);
+        }
+
+    } else if (update->entryChanged) {
+
+        catalog[index] = update->info;
+        componentReady[index].store(true, memory_order_release);
+
+        if (update->meshChanged) {
+
+            // Drop the old mesh, and ignore any load of it still in flight
+            MeshCacheEntry &slot = meshCache[index];
+
+            evictMesh(index);
+            slot.silhouette.reset();
+            slot.shape.reset();
+            slot.hull.reset();
+            slot.loading = false;
+            slot.generation = ++meshGenerations;
+
+            // Placed parts keep the old mesh until the new one arrives
+            if (isPlaced(index)) {
+                requestMesh(index);
+            }
+
+        }
+
+        updatePlacedPhysics(index, update->info.entry);
+
+    } else if (index < (int) meshCache.size() && meshCache[index].generation == update->generation) {
+
+        // A requested mesh arrived: make it resident and hand it to any placed part still showing an older version
+        MeshCacheEntry &slot = meshCache[index];
+
+        evictMesh(index);
+
+        slot.mesh = update->mesh;
+        slot.silhouette = update->silhouette;
+        slot.shape = update->shape;
+        slot.hull = update->hull;
+        slot.bytes = getMeshBytes(*update->mesh);
+        slot.loading = false;
+
+        meshLRU.push_front(index);
+        slot.lru = meshLRU.begin();
+        meshCacheBytes += slot.bytes;
+
+        updatePlacedMeshes(index, update->mesh, update->silhouette, update->shape, update->hull);
+
+        trimMeshCache();
+
+    }
+
+    delete update;
+
+}
+
+// Set the idle animation
+void idle(void) {
+
+    // Run the work the background jobs handed back (reloaded components, loaded meshes)
+    runMainThreadTasks();
+
+    glutPostRedisplay();
+}
+
+// This struct identifies one version of a file on disk (used to detect modified files when polling)
+struct FileStamp
+{
+    long long mtime;
+    long long size;
+};
+
+// This method returns the current modification time and size of the given file (or -1s if it cannot be read)
+FileStamp getFileStamp (const string &fileName) {
+
+    FileStamp stamp;
+    stamp.mtime = -1;
+    stamp.size = -1;
+
+    struct stat info;
+
+    if (stat(fileName.c_str(), &info) == 0) {
+        stamp.mtime = info.st_mtime;
+        stamp.size = info.st_size;
+    }
+
+    return stamp;
+
+}
+
+// This method returns the new index of every entry of the old catalog in the new list of entries, or -1 for entries that were removed. Entries are matched by model file: the n-th entry with a given model before is the n-th entry with that model now
+vector<int> matchCatalogEntries (const vector<CatalogInfo> &old, const vector<ComponentEntry> &entries) {
+
+    map<string, vector<int> > newIndices;
+
+    for (int i=0; i<entries.size(); i++) {
+        newIndices[entries[i].fileName].push_back(i);
+    }
+
+    map<string, int> matchedCount;
+    vector<int> remap(old.size(), -1);
+
+    for (int i=0; i<old.size(); i++) {
+
+        const vector<int> &indices = newIndices[old[i].entry.fileName];
+        int &count = matchedCount[old[i].entry.fileName];
+
+        if (count < indices.size()) {
+            remap[i] = indices[count++];
+        }
+
+    }
+
+    return remap;
+
+}
+
+// This void method reloads the parts of the catalog that changed on disk and posts them to the render thread. Only entries whose model file changed (or now points to a different file) are re-scanned, and the render thread then reloads their mesh if it is in use; entries whose physics lines changed only get a physics update
+void reloadChangedComponents (const string &manifestName, vector<CatalogInfo> &watched, const set<string> &changedFiles) {
+
+    vector<ComponentEntry> entries;
+
+    for (const CatalogInfo &info : watched) {
+        entries.push_back(info.entry);
+    }
+
+    if (changedFiles.count(manifestName)) {
+
+        // The components text file may be caught halfway through being saved; try again on the next change
+        try {
+            entries = parseComponents(manifestName);
+        } catch (const exception &e) {
+            cout << "Could not reload " << manifestName << ": " << e.what() << endl;
+            return;
+        }
+
+    }
+
+    // Entries are matched to the ones before by model file (the n-th entry of a model to the n-th one before), so adding, removing or reordering entries moves the others instead of giving them their neighbour's model and values
+    vector<int> remap = matchCatalogEntries(watched, entries);
+    bool moved = entries.size() != watched.size();
+
+    for (int i=0; i<remap.size(); i++) {
+        moved = moved || remap[i] != i;
+    }
+
+    if (moved) {
+
+        ComponentUpdate *resize = new ComponentUpdate();
+        resize->newCatalogSize = entries.size();
+        resize->remap = remap;
+        resize->index = -1;
+        resize->entryChanged = false;
+        resize->meshChanged = false;
+        postComponentUpdate(resize);
+
+    }
+
+    // New entries are left blank, so they are found changed below
+    vector<CatalogInfo> matched(entries.size());
+
+    for (int i=0; i<remap.size(); i++) {
+        if (remap[i] >= 0) {
+            matched[remap[i]] = watched[i];
+        }
+    }
+
+    watched.swap(matched);
+
+    // Find the entries that changed, and whether their model has to be scanned again
+    vector<int> changed;
+    vector<char> rescan;
+
+    for (int i=0; i<entries.size(); i++) {
+
+        const ComponentEntry &entry = entries[i];
+        const ComponentEntry &old = watched[i].entry;
+
+        bool isNew = old.fileName.empty();
+        bool meshChanged = isNew || entry.fileName != old.fileName || changedFiles.count(entry.fileName);
+        bool physicsChanged = isNew || entry.mass != old.mass || entry.thrust != old.thrust || entry.lift != old.lift || entry.drag != old.drag;
+
+        if (meshChanged || physicsChanged) {
+            changed.push_back(i);
+            rescan.push_back(meshChanged);
+        }
+
+    }
+
+    vector<CatalogInfo> infos(changed.size());
+
+    for (int c=0; c<changed.size(); c++) {
+        infos[c] = watched[changed[c]];
+        infos[c].entry = entries[changed[c]];
+    }
+
+    // Only a changed model is re-scanned (on the job system, off the render thread)
+    parallelFor(0, changed.size(), 1, [&](int first, int last) {
+
+        for (int c=first; c<last; c++) {
+            if (rescan[c]) {
+                scanObject(infos[c].entry.fileName, infos[c]);
+            }
+        }
+
+    });
+
+    for (int c=0; c<changed.size(); c++) {
+
+        ComponentUpdate *update = new ComponentUpdate();
+        update->newCatalogSize = -1;
+        update->index = changed[c];
+        update->entryChanged = true;
+        update->info = infos[c];
+        update->meshChanged = rescan[c];
+
+        postComponentUpdate(update);
+
+        watched[changed[c]] = infos[c];
+
+    }
+
+}
+
+// This void method watches the components text file and every model it references, reloading whatever changes. It never returns. Uses inotify where available (watching the containing directories, since editors often save by replacing the file), and otherwise polls the file modification times
+void watchComponents (string manifestName, vector<CatalogInfo> watched) {
+
+#ifdef __linux__
+
+    int notifier = inotify_init();
+
+    // The directories being watched (inotify watch descriptor -> directory path)
+    map<int, string> watchedDirs;
+
+#endif
+
+    // The last known version of every watched file (used when polling)
+    map<string, FileStamp> stamps;
+
+    while (true) {
+
+        // Build the set of files to watch from the current catalog
+        set<string> files;
+        files.insert(manifestName);
+
+        for (const CatalogInfo &info : watched) {
+            files.insert(info.entry.fileName);
+        }
+
+        for (const string &file : files) {
+            if (!stamps.count(file)) {
+                stamps[file] = getFileStamp(file);
+            }
+        }
+
+        set<string> changedFiles;
+
+#ifdef __linux__
+
+        if (notifier >= 0) {
+
+            // Watch the directory of every file (adding a directory twice is harmless, inotify returns the same descriptor)
+            for (const string &file : files) {
+                int wd = inotify_add_watch(notifier, getDirectory(file).c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+                if (wd >= 0) {
+                    watchedDirs[wd] = getDirectory(file);
+                }
+            }
+
+            // Block until something in the watched directories changes, then keep collecting events for a short while so that a multi-file save is handled as one reload
+            int timeout = -1;
+
+            while (true) {
+
+                pollfd pfd;
+                pfd.fd = notifier;
+                pfd.events = POLLIN;
+
+                if (poll(&pfd, 1, timeout) <= 0) {
+                    break;
+                }
+
+                char buffer[4096];
+                ssize_t length = read(notifier, buffer, sizeof(buffer));
+
+                for (char *p = buffer; p < buffer + length; ) {
+
+                    inotify_event *event = (inotify_event*) p;
 
-            // Draw the rocket assembly screen
-            drawRocketAssembly();
-            break;
+                    if (event->len > 0 && watchedDirs.count(event->wd)) {
 
-        // Stage 2: rocket launch screen
-        case 2:
+                        // Match the event against the watched files by directory and name
+                        for (const string &file : files) {
+                            if (getDirectory(file) == watchedDirs[event->wd] && getBaseName(file) == event->name) {
+                                changedFiles.insert(file);
+                            }
+                        }
 
-            // Scale the creen for the specific screen
-            glLoadIdentity();
-            //glOrtho(0, 20000, 0, 20000, -1200, 1200);
-            glOrtho(0, 1000, 0, 1000, -1200, 1200);
+                    }
 
-            // Check to see if the user has launched their rocket yet
-            if (BLASTOFF) {
+                    p += sizeof(inotify_event) + event->len;
 
-                // If so, run rocket physics/launching simulation
-                launchRocket();
+                }
+
+                timeout = 50;
 
             }
 
-            // Draw the rocket once simulation phase completes for current cycle
-            drawRocketLaunch();
+        } else
 
-            break;
+#endif
 
-        case 3:
+        {
 
-            // Player has reached space and won the game
-            drawWinScreen();
+            // Poll the files twice a second
+            this_thread::sleep_for(chrono::milliseconds(500));
 
-            break;
+            for (const string &file : files) {
 
-        case 4:
+                FileStamp stamp = getFileStamp(file);
 
-            // Player just lost the game; launch try again screen with steps for relaunch
-            drawLosingScreen();
+                if (stamp.mtime != stamps[file].mtime || stamp.size != stamps[file].size) {
+                    changedFiles.insert(file);
+                }
 
-            break;
+            }
 
-    }
+        }
 
-    // Flushing the matrix to the cache for double buffering
-    glutSwapBuffers();
+        if (changedFiles.empty()) {
+            continue;
+        }
+
+        for (const string &file : changedFiles) {
+            stamps[file] = getFileStamp(file);
+        }
+
+        reloadChangedComponents(manifestName, watched, changedFiles);
+
+    }
 
 }
 
-// Set the idle animation
-void idle(void) {
-    glutPostRedisplay();
+// This void method scans the catalog entry at index for its metadata, then publishes it to the render thread. Called from the loader threads only
+void loadComponent (int index) {
+
+    scanObject(catalog[index].entry.fileName, catalog[index]);
+
+    // Publish the finished entry. Nothing writes to catalog[index] from this thread after this point
+    componentReady[index].store(true, memory_order_release);
+    componentsLoaded.fetch_add(1, memory_order_release);
+
 }
 
-// This void method takes in a filepath/filename for the components text file and then buffers and prepares the entire components vector
+// This void method takes in a filepath/filename for the components text file and then builds the catalog index. Runs on a background thread: the models are scanned in parallel on the job system and each entry is published as soon as it completes (the meshes themselves are only loaded once the menu or a placed part needs them)
 void loadComponents (string filename) {
 
-    // Initialize a new file parser to read from the components filename
-    ifstream fParser(filename.c_str());
+    vector<ComponentEntry> entries = parseComponents(filename);
 
-    if (!fParser)
-    {
-        cout << "Invalid File!" << endl;
-        return;
+    int total = entries.size();
+
+    // Size the catalog up front so that it is never reallocated while the render thread reads it
+    catalog.resize(total);
+
+    for (int i=0; i<total; i++) {
+        catalog[i].entry = entries[i];
+    }
+
+    componentReady.reset(new atomic<bool>[total]);
+
+    for (int i=0; i<total; i++) {
+        componentReady[i].store(false, memory_order_relaxed);
     }
 
-    // Temporary string variable used to read every component filename at every line
-    string componentFileName;
+    // Publish the catalog size (and the sizing above) to the render thread
+    catalogSize.store(total, memory_order_release);
 
-    // Read through every line in the file and load every file into the components vector
-    while (getline(fParser, componentFileName)) {
+    // Scan the components on the job system, one entry per chunk (a model is big enough to be worth its own chunk)
+    parallelFor(0, total, 1, [](int first, int last) {
 
-        // Load the current line/filename into the components vector as a new object
-        vector<Object> temp_components = loadObject(componentFileName);
+        for (int index=first; index<last; index++) {
+            loadComponent(index);
+        }
 
-        // Temporary string variable used to read the following lines for physics engine data
-        string temp;
+    });
 
-        // Read the physics data from the following lines and add them to the component. The order goes: mass, thrust, lift and drag
-        getline(fParser, temp);
-        double mass = stod(temp);
-        getline(fParser, temp);
-        double thrust = stod(temp);
-        getline(fParser, temp);
-        double lift = stod(temp);
-        getline(fParser, temp);
-        double drag = stod(temp);
+    // Keep watching the components text file and models for changes (this thread now belongs to the watcher)
+    watchComponents(filename, catalog);
 
-        // Add the data to each sub-component of the component
-        for (int i=0; i<temp_components.size(); i++) {
+}
 
-            // Get the current component update its physics engine parameters
-            temp_components[i].mass = mass;
-            temp_components[i].thrust = thrust;
-            temp_components[i].lift = lift;
-            temp_components[i].drag = drag;
+// This void method fills the catalog from the built-in catalog (or the shared catalog, while one is attached). Nothing is read from disk, so every entry is ready at once (the meshes are still only built when they are needed)
+void loadEmbeddedComponents () {
 
-        }
+    int total = getBuiltInCount();
 
-        // Add the component into the components vector
-        components.push_back(temp_components);
+    catalog.resize(total);
+    componentReady.reset(new atomic<bool>[total]);
 
+    for (int i=0; i<total; i++) {
+        catalog[i] = getBuiltInInfo(i);
+        componentReady[i].store(true, memory_order_relaxed);
     }
 
+    componentsLoaded.store(total, memory_order_relaxed);
+
+    // Publish the catalog to the render thread
+    catalogSize.store(total, memory_order_release);
+
 }
 
-// This method opens the .obj files and parses them to load the object models
+// This method loads the components. The built-in catalog (or the shared catalog given with --shared-catalog) is used unless a components text file was given or the built-in catalog is empty (it only has components if the models were in place when embedCatalog ran before the build); a components text file is loaded in the background, and the call returns immediately so that the window can be shown while the .obj files are parsed
 void init() {
 
-    // The number of components
-    int fLength = 3;
-
-    // Load all the components into the components vector
-    loadComponents("C://Users/ricoz/Desktop/C++ Workspace/Kerugami-Space-Program/KSP/Components.txt");
+    if (getBuiltInCount() > 0 && !externalCatalog) {
+        loadEmbeddedComponents();
+        return;
+    }
 
-    // Initialize the menu once the components have been loaded
-    initMenu(components);
+    // Load all the components into the components vector (the menu is filled in as each component completes)
+    thread(loadComponents, componentsFileName).detach();
 
 }
 
@@ -1067,6 +8363,15 @@ void manipulateObjects (int x, int y) {
 
 }
 
+// This void method scrolls the menu by the given number of entries (clamped so that the last page stays full)
+void scrollMenu (int delta) {
+
+    int total = catalogSize.load(memory_order_acquire);
+
+    menuScroll = max(0, min(menuScroll + delta, total - menuSlots));
+
+}
+
 // This method will listen for all mouse button controls. This includes adjusting the global assembly perspective and
 void mouseListner (int button, int state, int x, int y) {
 
@@ -1091,6 +8396,11 @@ void mouseListner (int button, int state, int x, int y) {
         mhold = false;
     }
 
+    // The mouse wheel (reported as buttons 3 and 4) scrolls the components menu one entry at a time
+    if (stage == 1 && state == GLUT_DOWN && (button == 3 || button == 4)) {
+        scrollMenu(button == 3 ? -1 : 1);
+    }
+
     // Menu component selection (left mouse button click) in the rocket assembly stage (stage = 1)
 
     // Listner activated for a menu selection. Update the click position
@@ -1111,6 +8421,9 @@ void mouseListner (int button, int state, int x, int y) {
 // This method listens for keyboard events during the individual stages of the game
 void keyboardListener (unsigned char key, int x, int y) {
 
+    // The number of the selected part (to be moved), or -1 if no part is selected
+    int selected = getSelectedPart(partWorld);
+
     // Check for the current stage of the game; key actions will change depending on the state
     switch (stage) {
 
@@ -1134,7 +8447,7 @@ void keyboardListener (unsigned char key, int x, int y) {
 
             // Stage 1: Rocket assembly stage
 
-            if (key == 32 && assembly.components.size() > 0) {
+            if (key == 32 && partWorld.assembled > 0) {
 
                 // Player pressed space bar, move onto next stage (rocket launch, stage 2)
                 stage = 2;
@@ -1151,15 +8464,16 @@ void keyboardListener (unsigned char key, int x, int y) {
             }
 
             // Check to see if the key pressed was to select a certain component in the workspace (ascii values 48 - 57). Only actiavted while in the rocket assembly stage (stage = 1)
-            if (key >= 48 && key <= 57 && (key - 48) < workspace.size()) {
+            if (key >= 48 && key <= 57 && partWorld.assembled + (key - 48) < partWorld.size) {
 
                 if (selected != -1) {
                     // Update all the point values of the previous object
-                    setPreTranslate(workspace, selected, sxpos, sypos, szpos);
+                    setPreTranslate(selected, sxpos, sypos, szpos);
                 }
 
-                // The key is a number key and the value is valid (there are that many componenets)
-                selected = key - 48;
+                // The key is a number key and the value is valid (there are that many componenets in the workspace, which comes after the assembled parts)
+                selected = partWorld.assembled + key - 48;
+                selectPart(partWorld, selected);
 
                 // Reset the translation position of the object
                 sxpos = 0;
@@ -1194,16 +8508,27 @@ void keyboardListener (unsigned char key, int x, int y) {
                 // If there has been a translation/modification
                 if (selected != -1) {
                     // Update all the point values of the current workspace
-                    setPreTranslate(workspace, selected, sxpos, sypos, szpos);
+                    setPreTranslate(selected, sxpos, sypos, szpos);
                 }
 
-                // Assemble all existing components in the workspace together
-                assembleComponents(workspace);
-                // Reset the selected variable as no item is selected
+                // Assemble all existing components in the workspace together (which leaves no part selected)
+                assembleComponents();
                 selected = -1;
 
             }
 
+            if (key == 'z' || key == 26) {
+
+                // Undo the last edit (z or Ctrl+Z)
+                undoEdit();
+
+            } else if (key == 'y' || key == 25) {
+
+                // Redo the last undone edit (y or Ctrl+Y)
+                redoEdit();
+
+            }
+
             break;
 
         case 2:
@@ -1214,6 +8539,11 @@ void keyboardListener (unsigned char key, int x, int y) {
 
                 // The player pressed 'b' (for Blastoff!); launch the rocket
 
+                // Hand the rocket to the simulation thread (only once per launch)
+                if (!BLASTOFF) {
+                    sendLaunchCommand();
+                }
+
                 // Update the blastoff boolean variable
                 BLASTOFF = true;
                 // Refresh the screen
@@ -1223,6 +8553,26 @@ void keyboardListener (unsigned char key, int x, int y) {
 
             }
 
+            if (!BLASTOFF && (key == 'a' || key == 'd')) {
+
+                // Tilt the rocket towards downrange (d) or back up (a) before launching it
+                launchPitch += key == 'd' ? launchPitchStep : -launchPitchStep;
+                launchPitch = max(0.0, min(maxLaunchPitch, launchPitch));
+
+                updateLaunchHull();
+
+            } else if (BLASTOFF && (key == '.' || key == ',') && currentFlight.launch == launchCount) {
+
+                // Speed time up (.) or slow it down (,) ten times while the rocket coasts
+                sendWarpCommand(key == '.' ? currentFlight.warp * 10 : currentFlight.warp / 10);
+
+            } else if (BLASTOFF && key == 32 && currentFlight.launch == launchCount && currentFlight.reachedSpace) {
+
+                // The player has been to space and ends the flight
+                finishFlight();
+
+            }
+
             break;
 
         case 4:
@@ -1253,25 +8603,463 @@ void keyboardListener (unsigned char key, int x, int y) {
 
 }
 
+// This method listens for special (non-ASCII) keys. Page Up/Down and the arrow keys scroll the components menu during the rocket assembly stage
+void specialKeyListener (int key, int x, int y) {
+
+    if (stage != 1) {
+        return;
+    }
+
+    if (key == GLUT_KEY_PAGE_UP) {
+        scrollMenu(-menuSlots);
+    } else if (key == GLUT_KEY_PAGE_DOWN) {
+        scrollMenu(menuSlots);
+    } else if (key == GLUT_KEY_UP) {
+        scrollMenu(-1);
+    } else if (key == GLUT_KEY_DOWN) {
+        scrollMenu(1);
+    }
+
+}
+
+// Input recording and replay - every GLUT input callback and the start of every frame can be written to a compact binary log, which can later be fed back in frame by frame (at the original pace or as fast as possible) while the frame times are collected
+
+// This struct is one record of the input log (24 bytes, written as is)
+struct InputEvent
+{
+    // Microseconds since the program started (for frame records this is also the game clock of that frame)
+    uint64_t time;
+    // The frame the event is delivered before
+    uint32_t frame;
+
+    uint8_t type;
+    // The mouse button, key or special key
+    uint8_t button;
+    uint8_t state;
+    uint8_t reserved;
+
+    int16_t x;
+    int16_t y;
+    uint32_t padding;
+};
+
+static_assert(sizeof(InputEvent) == 24, "input log records must stay 24 bytes");
+
+// The input log record types
+const uint8_t EVENT_FRAME = 0;
+const uint8_t EVENT_MOUSE = 1;
+const uint8_t EVENT_MOTION = 2;
+const uint8_t EVENT_KEY = 3;
+const uint8_t EVENT_SPECIAL = 4;
+
+// The header at the start of every input log (magic and format version)
+const char inputLogMagic[4] = {'K', 'S', 'P', 'I'};
+const uint32_t inputLogVersion = 2;
+
+// The log being recorded to (set with --record <file>)
+ofstream recordLog;
+// The log being replayed (set with --replay <file>), and the position of the next record in it
+vector<InputEvent> replayLog;
+size_t replayPosition = 0;
+// Whether to replay as fast as possible instead of at the recorded pace (--replay-fast)
+bool replayFast = false;
+// Where to write the collected frame times (set with --frame-times <file>)
+string frameTimesFileName;
+
+// The number of frames drawn so far
+uint32_t frameCount = 0;
+// The duration of every frame drawn so far, in milliseconds (start of one frame to the start of the next)
+vector<float> frameTimes;
+chrono::steady_clock::time_point lastFrameStart;
+
+// This method returns the microseconds since the program started
+uint64_t getElapsedMicros () {
+
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - startTime).count();
+
+}
+
+// This void method appends one record to the input log being recorded, at the given time
+void recordEvent (uint8_t type, int button, int state, int x, int y, uint64_t time) {
+
+    InputEvent event = InputEvent();
+    event.time = time;
+    event.frame = frameCount;
+    event.type = type;
+    event.button = (uint8_t) button;
+    event.state = (uint8_t) state;
+    event.reserved = 0;
+    event.x = (int16_t) x;
+    event.y = (int16_t) y;
+
+    recordLog.write((const char*) &event, sizeof(event));
+
+}
+
+// These methods are the GLUT input callbacks while recording: log the event, then handle it as usual
+void recordMouse (int button, int state, int x, int y) {
+    recordEvent(EVENT_MOUSE, button, state, x, y, getElapsedMicros());
+    mouseListner(button, state, x, y);
+}
+
+void recordMotion (int x, int y) {
+    recordEvent(EVENT_MOTION, 0, 0, x, y, getElapsedMicros());
+    manipulateObjects(x, y);
+}
+
+void recordKeyboard (unsigned char key, int x, int y) {
+    recordEvent(EVENT_KEY, key, 0, x, y, getElapsedMicros());
+    keyboardListener(key, x, y);
+}
+
+void recordSpecial (int key, int x, int y) {
+    recordEvent(EVENT_SPECIAL, key, 0, x, y, getElapsedMicros());
+    specialKeyListener(key, x, y);
+}
+
+// These methods are the GLUT input callbacks while replaying: live input is ignored so that only the log drives the game
+void ignoreMouse (int button, int state, int x, int y) {
+}
+
+void ignoreMotion (int x, int y) {
+}
+
+void ignoreKeyboard (unsigned char key, int x, int y) {
+}
+
+void ignoreSpecial (int key, int x, int y) {
+}
+
+// This method reads an input log. Returns false if the file is missing or not an input log
+bool loadInputLog (string fileName, vector<InputEvent> &events) {
+
+    ifstream fParser(fileName.c_str(), ios::binary);
+
+    char magic[4];
+    uint32_t version = 0;
+
+    fParser.read(magic, 4);
+    fParser.read((char*) &version, sizeof(version));
+
+    if (!fParser || !equal(magic, magic + 4, inputLogMagic) || version != inputLogVersion) {
+        cout << "Invalid input log!" << endl;
+        return false;
+    }
+
+    InputEvent event;
+
+    while (fParser.read((char*) &event, sizeof(event))) {
+        events.push_back(event);
+    }
+
+    return true;
+
+}
+
+// This method returns true if a replayed mouse click can be delivered: the catalog and the visible menu meshes have to be loaded first, since loading takes a different amount of time on every run
+bool isReplayReady () {
+
+    int total = catalogSize.load(memory_order_acquire);
+
+    if (total < 0 || componentsLoaded.load(memory_order_acquire) < total) {
+        return false;
+    }
+
+    if (stage == 1) {
+        for (int i=menuScroll; i<total && i<menuScroll+menuSlots; i++) {
+            if (!requestMesh(i)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+
+}
+
+// This void method delivers the replayed input for the frame about to be drawn, up to and including its frame record (which sets the game clock). If a click has to wait for loading, the replay holds here and the game clock stands still
+void replayFrame () {
+
+    while (replayPosition < replayLog.size()) {
+
+        const InputEvent &event = replayLog[replayPosition];
+
+        if (event.type == EVENT_MOUSE && !isReplayReady()) {
+            return;
+        }
+
+        if (event.type == EVENT_FRAME) {
+
+            // Keep to the recorded pace unless replaying as fast as possible
+            if (!replayFast) {
+
+                uint64_t now = getElapsedMicros();
+
+                if (event.time > now) {
+                    this_thread::sleep_for(chrono::microseconds(event.time - now));
+                }
+
+            }
+
+            frameClock = event.time / 1000.0;
+            replayPosition++;
+            return;
+
+        }
+
+        if (event.type == EVENT_MOUSE) {
+            mouseListner(event.button, event.state, event.x, event.y);
+        } else if (event.type == EVENT_MOTION) {
+            manipulateObjects(event.x, event.y);
+        } else if (event.type == EVENT_KEY) {
+            keyboardListener(event.button, event.x, event.y);
+        } else if (event.type == EVENT_SPECIAL) {
+            specialKeyListener(event.button, event.x, event.y);
+        }
+
+        replayPosition++;
+
+    }
+
+}
+
+// This method returns the given percentile (0 to 100) of a sorted list of frame times
+float getPercentile (const vector<float> &sorted, double percentile) {
+
+    if (sorted.empty()) {
+        return 0;
+    }
+
+    size_t index = (size_t) (percentile / 100.0 * (sorted.size() - 1) + 0.5);
+
+    return sorted[index];
+
+}
+
+// This void method prints a summary of the collected frame times, and writes every frame time (one per line, in milliseconds) if --frame-times was given. Registered with atexit
+void writeFrameReport () {
+
+    if (recordLog.is_open()) {
+        recordLog.close();
+    }
+
+    if (frameTimes.empty()) {
+        return;
+    }
+
+    vector<float> sorted = frameTimes;
+    sort(sorted.begin(), sorted.end());
+
+    double sum = 0;
+
+    for (float t : sorted) {
+        sum += t;
+    }
+
+    cout << "Frames: " << sorted.size()
+         << "  mean " << sum / sorted.size() << " ms"
+         << "  p50 " << getPercentile(sorted, 50) << " ms"
+         << "  p90 " << getPercentile(sorted, 90) << " ms"
+         << "  p99 " << getPercentile(sorted, 99) << " ms"
+         << "  max " << sorted.back() << " ms" << endl;
+
+    if (!frameTimesFileName.empty()) {
+
+        ofstream out(frameTimesFileName.c_str());
+
+        for (float t : frameTimes) {
+            out << t << "\n";
+        }
+
+    }
+
+}
+
+// This is the display method used while recording or replaying. It handles the input log for the frame, draws it as usual and collects the frame time
+void timedDisplay () {
+
+    chrono::steady_clock::time_point frameStart = chrono::steady_clock::now();
+
+    if (frameCount > 0) {
+        frameTimes.push_back(chrono::duration<float, milli>(frameStart - lastFrameStart).count());
+    }
+
+    lastFrameStart = frameStart;
+
+    if (recordLog.is_open()) {
+
+        // The clock is read once for the frame: the game runs on exactly the time that goes into the frame record
+        uint64_t now = getElapsedMicros();
+
+        frameClock = now / 1000.0;
+        recordEvent(EVENT_FRAME, 0, 0, 0, 0, now);
+
+    } else if (!replayLog.empty()) {
+
+        replayFrame();
+
+        // The whole log has been played back
+        if (replayPosition >= replayLog.size()) {
+            exit(0);
+        }
+
+    }
+
+    display();
+
+    frameCount++;
+
+}
+
 int main( int argc, char **argv )
 {
+    // Tune a component and stop (no window needed)
+    for (int i=1; i<argc; i++) {
+        if (string(argv[i]) == "--tune") {
+            return runTuner(argc, argv) ? 0 : 1;
+        }
+    }
+
+    // Publish the catalog into shared memory for other processes, or take it down again, and stop
+    for (int i=1; i+1<argc; i++) {
+        if (string(argv[i]) == "--publish-catalog") {
+            return publishSharedCatalog(argv[i+1], getToolCatalog(argc, argv)) ? 0 : 1;
+        } else if (string(argv[i]) == "--unpublish-catalog") {
+            return unpublishSharedCatalog(argv[i+1]) ? 0 : 1;
+        }
+    }
+
     // Initialize the new frame and clear the depth buffer
     glutInit( &argc, argv );
-    init();
+
+    // Read the program's own options (glutInit has removed the GLUT ones)
+    for (int i=1; i<argc; i++) {
+
+        string arg = argv[i];
+
+        if (arg == "--components" && i + 1 < argc) {
+
+            // Load the catalog from the given components text file instead of the built-in one
+            componentsFileName = argv[++i];
+            externalCatalog = true;
+
+        } else if (arg == "--mesh-budget" && i + 1 < argc) {
+            // The mesh cache budget, in megabytes
+            meshBudget = (size_t) (atof(argv[++i]) * 1024 * 1024);
+        } else if (arg == "--compact-meshes") {
+            compactMeshes = true;
+        } else if (arg == "--shared-catalog" && i + 1 < argc) {
+            // Use a catalog another process has published instead of the built-in one
+            if (!attachSharedCatalog(getSharedSegmentName(argv[++i]), sharedCatalog)) {
+                cout << "Could not attach the shared catalog " << argv[i] << endl;
+            }
+        } else if (arg == "--record" && i + 1 < argc) {
+
+            // Record every input event to the given file
+            recordLog.open(argv[++i], ios::binary);
+            recordLog.write(inputLogMagic, 4);
+            recordLog.write((const char*) &inputLogVersion, sizeof(inputLogVersion));
+
+        } else if (arg == "--replay" && i + 1 < argc) {
+
+            // Replay the input events of the given file
+            if (!loadInputLog(argv[++i], replayLog)) {
+                return 1;
+            }
+
+        } else if (arg == "--replay-fast") {
+            replayFast = true;
+        } else if (arg == "--frame-times" && i + 1 < argc) {
+            frameTimesFileName = argv[++i];
+        } else if (arg == "--integrator" && i + 1 < argc) {
+
+            // The launch simulation integrator
+            string name = argv[++i];
+
+            if (name == "euler") {
+                flightIntegrator = stepExplicitEuler;
+            } else if (name == "semi") {
+                flightIntegrator = stepSemiImplicitEuler;
+            } else if (name == "rk4") {
+                flightIntegrator = stepRK4;
+            } else if (name == "rk45") {
+                flightIntegrator = stepRK45;
+            } else {
+                cout << "Unknown integrator " << name << endl;
+            }
+
+        } else if (arg == "--flight-step" && i + 1 < argc) {
+            flightStep = atof(argv[++i]);
+        } else if (arg == "--flight-tolerance" && i + 1 < argc) {
+            flightTolerance = atof(argv[++i]);
+        } else if (arg == "--sim-rate" && i + 1 < argc) {
+            simulationRate = atof(argv[++i]);
+        } else if (arg == "--telemetry" && i + 1 < argc) {
+
+            // Record the telemetry of every launch to the given file
+            if (openTelemetry(argv[++i])) {
+                atexit(closeTelemetry);
+                thread(runTelemetryWriter).detach();
+            } else {
+                cout << "Could not create the telemetry file " << argv[i] << endl;
+            }
+
+        } else if (arg == "--fleet" && i + 1 < argc) {
+            // The number of rockets flown alongside every launch
+            fleetSize = max(0, atoi(argv[++i]));
+        } else if (arg == "--terrain-triangles" && i + 1 < argc) {
+            // The most triangles the terrain may draw per frame
+            terrainTriangleBudget = atoi(argv[++i]);
+        } else if (arg == "--fleet-lines" && i + 1 < argc) {
+            // The most lines the fleet may draw per frame at full detail
+            fleetLineBudget = atoi(argv[++i]);
+        }
+
+    }
+
     glutInitDisplayMode(GLUT_RGB | GLUT_DOUBLE | GLUT_DEPTH);
     glutInitWindowSize( 600, 600 );
     glutCreateWindow( "GLUT .obj Demo" );
 
-    // Set the display function to draw the solid
-    glutDisplayFunc(display);
+    // Set up instanced drawing for fleet mode (needs the window's GL context)
+    if (fleetSize > 0) {
+        initInstancing();
+    }
+
+    // Start the worker threads before anything hands them work
+    startJobSystem();
+
+    // Start loading the components in the background once the window is up
+    init();
+
+    // Start the flight simulation thread
+    thread(runSimulation).detach();
+
+    bool recording = recordLog.is_open();
+    bool replaying = !replayLog.empty();
+
+    // Until the first frame, the game clock stands at 0 (in the recording and in its replay alike)
+    if (recording || replaying) {
+        frameClock = 0;
+    }
+
+    // Set the display function to draw the solid (going through the input log and frame timing when recording or replaying)
+    glutDisplayFunc(recording || replaying ? timedDisplay : display);
     // Set the idle animation funciton
     glutIdleFunc(idle);
     // Set the mouse event animation funciton
-    glutMouseFunc(mouseListner);
+    glutMouseFunc(recording ? recordMouse : replaying ? ignoreMouse : mouseListner);
     // Set the mouse motion/move function
-    glutMotionFunc(manipulateObjects);
+    glutMotionFunc(recording ? recordMotion : replaying ? ignoreMotion : manipulateObjects);
     // Set the keyboard function
-    glutKeyboardFunc(keyboardListener);
+    glutKeyboardFunc(recording ? recordKeyboard : replaying ? ignoreKeyboard : keyboardListener);
+    // Set the special key function (menu scrolling)
+    glutSpecialFunc(recording ? recordSpecial : replaying ? ignoreSpecial : specialKeyListener);
+
+    // Report the frame times (and finish the input log) when the program ends
+    if (recording || replaying) {
+        atexit(writeFrameReport);
+    }
     // Clear the background
     glClearColor(1,1,1,1);
 
@@ -0,0 +1,920 @@
+/*
+
+    The .obj model reader, shared by the game and by the embedCatalog build tool.
+
+    Every model is loaded by loadObject, which welds, triangulates and orders each object for the vertex cache before it is used, and the components text file is read by parseComponents. The game uses them at runtime, and embedCatalog uses the same code to build the catalog into the game, so the built-in meshes are exactly the ones the game would load itself.
+
+*/
+
+#ifndef KSP_MODEL_READER_H
+#define KSP_MODEL_READER_H
+
+#include <cstdint>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+
+// This struct represents one unit of a point in 3-dimensional space
+struct Point3D
+{
+    double x;
+    double y;
+    double z;
+};
+
+// This struct is used to represent one object (loaded from a .obj file). It contains a list of the points and all the vectors for drawing the faces. It contains the max and min coordinates of every axis for scaling.
+struct Object
+{
+
+    std::vector<Point3D> vertices;
+    std::vector<Point3D> normals;
+    std::vector<int> triangles;
+
+    // The faces with more than 3 vertices while loading: their vertex indices one after another in polygons, and the number of vertices of each face in elements (both are emptied once the faces are triangulated)
+    std::vector<int> polygons;
+    std::vector<int> elements;
+
+    // Every edge of the triangles once, two vertex indices each (the line frame that is drawn)
+    std::vector<int> edges;
+
+    // The compact form of the object, only filled in by compactObject: the vertices quantized to 16 bits per axis between the bounds below, and the edges as 16-bit indices if there are few enough vertices. The full precision vectors they replace are emptied
+    std::vector<int16_t> quantized;
+    std::vector<uint16_t> shortEdges;
+
+    double maxX;
+    double minX;
+
+    double maxY;
+    double minY;
+
+    double maxZ;
+    double minZ;
+
+};
+
+// This struct represents one entry of the components text file: the .obj model filename followed by the physics engine values of that component
+struct ComponentEntry
+{
+    std::string fileName;
+
+    // The index of the component in the built-in catalog (or the shared catalog, while one is attached), or -1 if its model is read from fileName
+    int embedded;
+
+    double mass;
+    double thrust;
+    double lift;
+    double drag;
+};
+
+// This struct is the lightweight index of one catalog entry: its physics values plus the bounds and element counts of its model. It is always kept in memory, while the mesh itself is only loaded when needed
+struct CatalogInfo
+{
+    ComponentEntry entry;
+
+    double maxX;
+    double minX;
+
+    double maxY;
+    double minY;
+
+    double maxZ;
+    double minZ;
+
+    // The counts of the model file: its objects and vertices, its triangles once every face is triangulated, and how many of its faces had more than three corners
+    int objectCount;
+    int vertexCount;
+    int triangleCount;
+    int polygonCount;
+};
+
+// This function returns the magnitude of a given Point3D vector
+inline double getMagnitude (Point3D p)
+{
+    return sqrt((p.x * p.x) + (p.y * p.y) + (p.z * p.z));
+}
+
+// This method returns a new Point3D with subtracted values
+inline Point3D subtractP3D (Point3D p1, Point3D p2)
+{
+    Point3D p3;
+    p3.x = p1.x - p2.x;
+    p3.y = p1.y - p2.y;
+    p3.z = p1.z - p2.z;
+    return p3;
+}
+
+// This method does cross multiplication on the 2 input points
+inline Point3D crossMultiplyP3D (Point3D p1, Point3D p2)
+{
+    Point3D p3;
+    p3.x = (p1.y * p2.z) - (p2.y * p1.z);
+    p3.y = (p1.z * p2.x) - (p2.z * p1.x);
+    p3.z = (p1.x * p2.y) - (p2.x * p1.y);
+    return p3;
+}
+
+// This method returns the dot product of the 2 input points
+inline double dotMultiplyP3D (Point3D p1, Point3D p2)
+{
+    return (p1.x * p2.x) + (p1.y * p2.y) + (p1.z * p2.z);
+}
+
+// This method returns a new Point3D with added values
+inline Point3D addP3D (Point3D p1, Point3D p2)
+{
+    Point3D p3;
+    p3.x = p1.x + p2.x;
+    p3.y = p1.y + p2.y;
+    p3.z = p1.z + p2.z;
+    return p3;
+}
+
+// This method returns a new Point3D scaled by s
+inline Point3D scaleP3D (Point3D p, double s)
+{
+    Point3D np;
+    np.x = p.x * s;
+    np.y = p.y * s;
+    np.z = p.z * s;
+    return np;
+}
+
+// This method returns a new normalized unit vector Point3D of given Point3D p
+inline Point3D normalize (Point3D p)
+{
+    double magnitude = getMagnitude(p);
+    Point3D np;
+    np.x = (p.x/magnitude);
+    np.y = (p.y/magnitude);
+    np.z = (p.z/magnitude);
+    return np;
+}
+
+// Mesh optimization - every loaded object goes through weldVertices, triangulateFaces, optimizeVertexCache and buildEdgeList before it is used, which leaves it as one compact triangle list plus the list of its edges. The raw face streams of the .obj file (triangles plus n-gons in polygons/elements) are not kept
+
+// The distance (relative to the size of the model) below which two vertices are considered the same point
+const double weldTolerance = 1e-6;
+
+// The size of the post-transform vertex cache the triangle order is optimized for (the scoring is tuned for 32, and it works well for smaller real caches too)
+const int vertexCacheSize = 32;
+
+// This void method merges vertices that are within epsilon of each other and points every face at the merged vertex. The vertices are swept in x order, so only the neighbours in a thin slab have to be compared. Unused vertices are left for optimizeVertexCache to remove
+inline void weldVertices (Object &obj, double epsilon) {
+
+    int count = obj.vertices.size();
+
+    std::vector<int> order(count);
+
+    for (int i=0; i<count; i++) {
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&obj](int a, int b) { return obj.vertices[a].x < obj.vertices[b].x; });
+
+    // The vertex each vertex is merged into (itself if it is kept)
+    std::vector<int> remap(count);
+
+    for (int i=0; i<count; i++) {
+
+        int index = order[i];
+        const Point3D &p = obj.vertices[index];
+
+        remap[index] = index;
+
+        // Look back through the slab of vertices within epsilon on x for a kept vertex within epsilon
+        for (int j=i-1; j>=0 && p.x - obj.vertices[order[j]].x <= epsilon; j--) {
+
+            int other = order[j];
+
+            if (remap[other] == other && getMagnitude(subtractP3D(p, obj.vertices[other])) <= epsilon) {
+                remap[index] = other;
+                break;
+            }
+
+        }
+
+    }
+
+    for (int &index : obj.triangles) {
+        index = remap[index];
+    }
+
+    for (int &index : obj.polygons) {
+        index = remap[index];
+    }
+
+}
+
+// This void method turns every polygon into triangles (as a fan around its first vertex) and appends them to the triangle list. Triangles that welding collapsed into a line or a point are dropped
+inline void triangulateFaces (Object &obj) {
+
+    std::vector<int> triangles;
+    triangles.reserve(obj.triangles.size() + obj.polygons.size() * 2);
+
+    auto addTriangle = [&triangles](int a, int b, int c) {
+
+        if (a != b && b != c && a != c) {
+            triangles.push_back(a);
+            triangles.push_back(b);
+            triangles.push_back(c);
+        }
+
+    };
+
+    for (int i=0; i<obj.triangles.size(); i+=3) {
+        addTriangle(obj.triangles[i], obj.triangles[i+1], obj.triangles[i+2]);
+    }
+
+    int first = 0;
+
+    for (int size : obj.elements) {
+
+        for (int i=1; i<size-1; i++) {
+            addTriangle(obj.polygons[first], obj.polygons[first+i], obj.polygons[first+i+1]);
+        }
+
+        first += size;
+
+    }
+
+    obj.triangles.swap(triangles);
+
+    // The polygons are all triangles now
+    std::vector<int>().swap(obj.polygons);
+    std::vector<int>().swap(obj.elements);
+
+}
+
+// This method returns how much a vertex is worth drawing next, given its position in the vertex cache (-1 if it is not cached) and the number of triangles still using it (Forsyth's scoring: recently used vertices and vertices with few triangles left come first)
+inline double getVertexScore (int cachePosition, int remainingTriangles) {
+
+    if (remainingTriangles == 0) {
+        return -1;
+    }
+
+    double score = 0;
+
+    if (cachePosition >= 0) {
+
+        // The three vertices of the last triangle get a fixed score, so that the next triangle does not simply reuse the same edge
+        if (cachePosition < 3) {
+            score = 0.75;
+        } else {
+            score = pow(1.0 - (double) (cachePosition - 3) / (vertexCacheSize - 3), 1.5);
+        }
+
+    }
+
+    // Finishing off vertices with few triangles left frees up the cache sooner
+    score += 2.0 / sqrt((double) remainingTriangles);
+
+    return score;
+
+}
+
+// This void method reorders the triangles so that consecutive triangles share vertices (greedily, always taking the triangle whose vertices score highest in a simulated vertex cache), then reorders the vertices into the order the triangles first use them. Vertices no triangle uses are dropped
+inline void optimizeVertexCache (Object &obj) {
+
+    int vertexCount = obj.vertices.size();
+    int triangleCount = obj.triangles.size() / 3;
+
+    if (triangleCount == 0) {
+        std::vector<Point3D>().swap(obj.vertices);
+        return;
+    }
+
+    // The triangles of every vertex, packed into one array (the first activeTriangles[v] of each vertex's range are the ones not drawn yet)
+    std::vector<int> firstTriangle(vertexCount + 1, 0);
+    std::vector<int> activeTriangles(vertexCount, 0);
+
+    for (int index : obj.triangles) {
+        activeTriangles[index]++;
+    }
+
+    for (int v=0; v<vertexCount; v++) {
+        firstTriangle[v+1] = firstTriangle[v] + activeTriangles[v];
+        activeTriangles[v] = 0;
+    }
+
+    std::vector<int> vertexTriangles(obj.triangles.size());
+
+    for (int t=0; t<triangleCount; t++) {
+        for (int k=0; k<3; k++) {
+            int v = obj.triangles[t*3+k];
+            vertexTriangles[firstTriangle[v] + activeTriangles[v]++] = t;
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<double> vertexScore(vertexCount);
+    std::vector<double> triangleScore(triangleCount, 0);
+    std::vector<bool> drawn(triangleCount, false);
+
+    for (int v=0; v<vertexCount; v++) {
+        vertexScore[v] = getVertexScore(-1, activeTriangles[v]);
+    }
+
+    for (int t=0; t<triangleCount; t++) {
+        for (int k=0; k<3; k++) {
+            triangleScore[t] += vertexScore[obj.triangles[t*3+k]];
+        }
+    }
+
+    std::vector<int> cache;
+    std::vector<int> newCache;
+    std::vector<int> triangles;
+    triangles.reserve(obj.triangles.size());
+
+    // Where to continue looking for an undrawn triangle when the cache offers none
+    int nextUndrawn = 0;
+    int best = -1;
+
+    for (int drawnCount=0; drawnCount<triangleCount; drawnCount++) {
+
+        if (best < 0) {
+
+            while (drawn[nextUndrawn]) {
+                nextUndrawn++;
+            }
+
+            best = nextUndrawn;
+
+        }
+
+        const int *corners = &obj.triangles[best*3];
+
+        drawn[best] = true;
+        triangles.insert(triangles.end(), corners, corners + 3);
+
+        // Take the triangle off the active list of each of its vertices
+        for (int k=0; k<3; k++) {
+
+            int v = corners[k];
+            int *list = &vertexTriangles[firstTriangle[v]];
+
+            for (int i=0; i<activeTriangles[v]; i++) {
+                if (list[i] == best) {
+                    std::swap(list[i], list[activeTriangles[v]-1]);
+                    activeTriangles[v]--;
+                    break;
+                }
+            }
+
+        }
+
+        // The triangle's vertices move to the front of the cache, pushing the oldest ones out
+        newCache.assign(corners, corners + 3);
+
+        for (int v : cache) {
+            if (v != corners[0] && v != corners[1] && v != corners[2]) {
+                newCache.push_back(v);
+            }
+        }
+
+        for (int i=vertexCacheSize; i<newCache.size(); i++) {
+            cachePosition[newCache[i]] = -1;
+            vertexScore[newCache[i]] = getVertexScore(-1, activeTriangles[newCache[i]]);
+        }
+
+        newCache.resize(std::min((int) newCache.size(), vertexCacheSize));
+        cache.swap(newCache);
+
+        // Rescore the cached vertices and their triangles, and pick the best of those triangles to draw next
+        for (int i=0; i<cache.size(); i++) {
+            cachePosition[cache[i]] = i;
+            vertexScore[cache[i]] = getVertexScore(i, activeTriangles[cache[i]]);
+        }
+
+        best = -1;
+        double bestScore = -1;
+
+        for (int v : cache) {
+
+            for (int i=0; i<activeTriangles[v]; i++) {
+
+                int t = vertexTriangles[firstTriangle[v] + i];
+                const int *other = &obj.triangles[t*3];
+
+                triangleScore[t] = vertexScore[other[0]] + vertexScore[other[1]] + vertexScore[other[2]];
+
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+
+            }
+
+        }
+
+    }
+
+    // Renumber the vertices in the order the triangles first use them
+    std::vector<int> remap(vertexCount, -1);
+    std::vector<Point3D> vertices;
+    vertices.reserve(vertexCount);
+
+    for (int &index : triangles) {
+
+        if (remap[index] < 0) {
+            remap[index] = vertices.size();
+            vertices.push_back(obj.vertices[index]);
+        }
+
+        index = remap[index];
+
+    }
+
+    vertices.shrink_to_fit();
+    triangles.shrink_to_fit();
+
+    obj.vertices.swap(vertices);
+    obj.triangles.swap(triangles);
+
+}
+
+// This void method fills the edge list of an object from its triangles. An edge shared by two triangles is only listed once, and the edges keep the order of the triangles (so drawing them still benefits from the vertex cache order)
+inline void buildEdgeList (Object &obj) {
+
+    int count = obj.triangles.size();
+
+    // Every edge of every triangle, lowest vertex first
+    std::vector<std::pair<int, int> > all(count);
+
+    for (int i=0; i<count; i+=3) {
+        for (int k=0; k<3; k++) {
+
+            int a = obj.triangles[i+k];
+            int b = obj.triangles[i+(k+1)%3];
+
+            all[i+k] = std::make_pair(std::min(a, b), std::max(a, b));
+
+        }
+    }
+
+    // Sort the edges (stably, so the first of every run of duplicates is the first use) and keep the first use of each
+    std::vector<int> order(count);
+
+    for (int i=0; i<count; i++) {
+        order[i] = i;
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&all](int a, int b) { return all[a] < all[b]; });
+
+    std::vector<bool> keep(count, false);
+
+    for (int i=0; i<count; i++) {
+        keep[order[i]] = i == 0 || all[order[i]] != all[order[i-1]];
+    }
+
+    obj.edges.clear();
+
+    for (int i=0; i<count; i++) {
+        if (keep[i]) {
+            obj.edges.push_back(all[i].first);
+            obj.edges.push_back(all[i].second);
+        }
+    }
+
+    obj.edges.shrink_to_fit();
+
+}
+
+// This method returns a new loaded .obj file into the program as a new vector of objects, each optimized into a single triangle list
+inline std::vector<Object> loadObject (std::string fName) {
+
+    // New vector to load the program files to
+    std::vector<Object> objects;
+
+    // Create a new input file stream reader that will parse the .obj object model file
+    std::ifstream fParser(fName.c_str());
+
+    if (!fParser)
+    {
+        std::cout << "Invalid File!" << std::endl;
+        return objects;
+    }
+
+    // String variable used to store each line
+    std::string line;
+
+    // Create a new blank object for the first case
+    Object newO;
+    objects.push_back(newO);
+
+    // Integer variable used to keep track of the current index of the object
+    int cObj = 0;
+
+    // The number of vertices in the objects before the current one (.obj face indices count the vertices of the whole file)
+    int vertexBase = 0;
+
+    // The number of vertices before each object. Faces are read with indices into the whole file, and each object is rebased onto its own vertices once the file is read
+    std::vector<int> firstVertex(1, 0);
+
+    // These double variables are used to record the maximum x, y and z values of the current object. Used later for scaling and normalization
+    double maxX = -1000000, maxY = -1000000, maxZ = -1000000;
+    // These double variables are used to record the minimum x, y and z values of the current object. Used later for scaling and normalization
+    double minX = 1000000, minY = 1000000, minZ = 1000000;
+
+    // Start the reading call for the entire file
+    while (std::getline(fParser, line))
+    {
+
+        // Check to see if the current line decalres a new object
+        if (line.substr(0,2) == "o ")
+        {
+
+            // Create a new object and add it to the objects vector. Increment the index of the current object
+            vertexBase += objects[cObj].vertices.size();
+
+            Object newO;
+            objects.push_back(newO);
+            firstVertex.push_back(vertexBase);
+            cObj++;
+
+        }
+        else if (line.substr(0,2) == "v ")
+        {
+
+            // The current line contains a point for a vertex. Create a point and push it to the back of the current object's vertex
+            Point3D tempP = Point3D();
+
+            // Read the current point/vertice
+            std::istringstream sParser(line.substr(2));
+
+            // Parse the x, y and z coordinates into the current object
+            sParser >> tempP.x;
+            //sParser >> tempP.y;
+            //sParser >> tempP.z;
+
+            sParser >> tempP.z;
+            sParser >> tempP.y;
+
+            // Check to see if each coordinate is the currently assumed greatest value (maximum); if so, update the current max values
+            if (tempP.x > maxX) {
+                maxX = tempP.x;
+            }
+
+            if (tempP.y > maxY) {
+                maxY = tempP.y;
+            }
+
+            if (tempP.z > maxZ) {
+                maxZ = tempP.z;
+            }
+
+            // Check to see if each coordinate is the currently assumed smallest value (minimum); if so, update the current min values
+            if (tempP.x < minX) {
+                minX = tempP.x;
+            }
+
+            if (tempP.y < minY) {
+                minY = tempP.y;
+            }
+
+            if (tempP.z < minZ) {
+                minZ = tempP.z;
+            }
+
+            // Add the new point into the current vertices vector in the current object being loaded
+            objects[cObj].vertices.push_back(tempP);
+
+        }
+        else if (line.substr(0,2) == "f ")
+        {
+
+            // Read the vertex index of every corner of the face (the part of each token before any texture/normal index)
+            std::vector<int> face;
+            std::string token;
+
+            std::istringstream sParser(line.substr(2));
+
+            // The number of vertices read so far
+            int vertexCount = vertexBase + objects[cObj].vertices.size();
+            bool valid = true;
+
+            while (sParser >> token) {
+
+                int index;
+
+                try {
+                    index = std::stoi(token.substr(0,token.find("/")));
+                } catch (const std::exception &) {
+                    std::cout << "Invalid face in " << fName << ": " << line << std::endl;
+                    return std::vector<Object>();
+                }
+
+                // Decrement indices (.obj indices frustratingly start at 1). Negative indices count back from the last vertex read
+                int vertex = index < 0 ? vertexCount + index : index - 1;
+
+                // A face may only use vertices that have been read (which rules out 0 as well)
+                if (vertex < 0 || vertex >= vertexCount) {
+                    valid = false;
+                }
+
+                face.push_back(vertex);
+
+            }
+
+            if (!valid) {
+
+                std::cout << "Skipping a face with a vertex out of range in " << fName << ": " << line << std::endl;
+
+            } else if (face.size() == 3) {
+
+                objects[cObj].triangles.insert(objects[cObj].triangles.end(), face.begin(), face.end());
+
+            } else if (face.size() > 3) {
+
+                // Quadrilaterals and larger faces are kept as polygons until they are triangulated
+                objects[cObj].polygons.insert(objects[cObj].polygons.end(), face.begin(), face.end());
+                objects[cObj].elements.push_back(face.size());
+
+            }
+
+        }
+
+    }
+
+    // Rebase the faces of every object onto its own vertices. A face may use vertices of an earlier object, and those are copied into the object after its own
+    for (int o=0; o<objects.size(); o++) {
+
+        Object &obj = objects[o];
+
+        int first = firstVertex[o];
+        int own = obj.vertices.size();
+
+        std::map<int, int> borrowed;
+
+        for (std::vector<int> *indices : {&obj.triangles, &obj.polygons}) {
+            for (int &index : *indices) {
+
+                if (index >= first && index < first + own) {
+                    index -= first;
+                    continue;
+                }
+
+                std::map<int, int>::iterator copy = borrowed.find(index);
+
+                if (copy == borrowed.end()) {
+
+                    // Find the object the vertex was read into
+                    int source = upper_bound(firstVertex.begin(), firstVertex.end(), index) - firstVertex.begin() - 1;
+
+                    copy = borrowed.insert(std::make_pair(index, (int) obj.vertices.size())).first;
+                    obj.vertices.push_back(objects[source].vertices[index - firstVertex[source]]);
+
+                }
+
+                index = copy->second;
+
+            }
+        }
+
+    }
+
+    // Update the max and min coordinate parameters in each object
+    for (Object &obj : objects) {
+
+        obj.maxX = maxX;
+        obj.minX = minX;
+
+        obj.maxY = maxY;
+        obj.minY = minY;
+
+        obj.maxZ = maxZ;
+        obj.minZ = minZ;
+
+    }
+
+    // Optimize every object for drawing. The weld distance scales with the size of the model
+    double size = getMagnitude(subtractP3D(Point3D{maxX, maxY, maxZ}, Point3D{minX, minY, minZ}));
+
+    for (Object &obj : objects) {
+
+        weldVertices(obj, size * weldTolerance);
+        triangulateFaces(obj);
+        optimizeVertexCache(obj);
+        buildEdgeList(obj);
+
+    }
+
+    return objects;
+
+}
+
+// This method returns the directory part of a file path (without the trailing slash), or "." if there is none
+inline std::string getDirectory (const std::string &fileName) {
+
+    size_t slash = fileName.find_last_of("/\\");
+
+    if (slash == std::string::npos) {
+        return ".";
+    }
+
+    return fileName.substr(0, slash);
+
+}
+
+// This method returns the file name part of a file path
+inline std::string getBaseName (const std::string &fileName) {
+
+    size_t slash = fileName.find_last_of("/\\");
+
+    if (slash == std::string::npos) {
+        return fileName;
+    }
+
+    return fileName.substr(slash + 1);
+
+}
+
+// This method returns true if a file path is absolute (from the root, a drive letter or a network share)
+inline bool isAbsolutePath (const std::string &fileName) {
+
+    return !fileName.empty() && (fileName[0] == '/' || fileName[0] == '\\' || (fileName.size() > 1 && fileName[1] == ':'));
+
+}
+
+// This method reads the components text file and returns its entries. Each entry is a .obj filename followed by mass, thrust, lift and drag lines. A relative .obj filename is relative to the directory of the components text file
+inline std::vector<ComponentEntry> parseComponents (std::string filename) {
+
+    std::vector<ComponentEntry> entries;
+
+    // Initialize a new file parser to read from the components filename
+    std::ifstream fParser(filename.c_str());
+
+    if (!fParser)
+    {
+        std::cout << "Invalid File!" << std::endl;
+        return entries;
+    }
+
+    // Temporary string variable used to read every component filename at every line
+    std::string componentFileName;
+
+    // Read through every line in the file and parse every component entry
+    while (std::getline(fParser, componentFileName)) {
+
+        // Skip blank lines (e.g. a trailing newline at the end of the file)
+        if (componentFileName.empty()) {
+            continue;
+        }
+
+        ComponentEntry entry;
+        entry.fileName = isAbsolutePath(componentFileName) ? componentFileName : getDirectory(filename) + "/" + componentFileName;
+        entry.embedded = -1;
+
+        // Temporary string variable used to read the following lines for physics engine data
+        std::string temp;
+
+        // Read the physics data from the following lines and add them to the component. The order goes: mass, thrust, lift and drag
+        std::getline(fParser, temp);
+        entry.mass = std::stod(temp);
+        std::getline(fParser, temp);
+        entry.thrust = std::stod(temp);
+        std::getline(fParser, temp);
+        entry.lift = std::stod(temp);
+        std::getline(fParser, temp);
+        entry.drag = std::stod(temp);
+
+        entries.push_back(entry);
+
+    }
+
+    return entries;
+
+}
+
+// This method scans a .obj file for its catalog metadata (bounds and element counts) without keeping any of the geometry. Faces are counted the way loadObject triangulates them (a fan of n - 2 triangles for a face of n corners), so triangleCount is the number of triangles the loaded mesh has, unless loadObject drops broken faces. Returns false if the file cannot be read
+inline bool scanObject (std::string fName, CatalogInfo &info) {
+
+    info.objectCount = 0;
+    info.vertexCount = 0;
+    info.triangleCount = 0;
+    info.polygonCount = 0;
+
+    info.maxX = -1000000; info.maxY = -1000000; info.maxZ = -1000000;
+    info.minX = 1000000; info.minY = 1000000; info.minZ = 1000000;
+
+    std::ifstream fParser(fName.c_str());
+
+    if (!fParser)
+    {
+        std::cout << "Invalid File!" << std::endl;
+        return false;
+    }
+
+    // loadObject always starts with one blank object
+    info.objectCount = 1;
+
+    std::string line;
+
+    while (std::getline(fParser, line))
+    {
+
+        if (line.substr(0,2) == "o ")
+        {
+            info.objectCount++;
+        }
+        else if (line.substr(0,2) == "v ")
+        {
+
+            // Same axis order as loadObject (the file's z is our y)
+            Point3D p;
+
+            std::istringstream sParser(line.substr(2));
+            sParser >> p.x;
+            sParser >> p.z;
+            sParser >> p.y;
+
+            info.maxX = std::max(info.maxX, p.x); info.minX = std::min(info.minX, p.x);
+            info.maxY = std::max(info.maxY, p.y); info.minY = std::min(info.minY, p.y);
+            info.maxZ = std::max(info.maxZ, p.z); info.minZ = std::min(info.minZ, p.z);
+
+            info.vertexCount++;
+
+        }
+        else if (line.substr(0,2) == "f ")
+        {
+
+            // A face of n corners becomes a fan of n - 2 triangles; faces of more than three corners also count as polygons
+            std::string corner;
+            int corners = 0;
+
+            std::istringstream sParser(line.substr(2));
+
+            while (sParser >> corner) {
+                corners++;
+            }
+
+            if (corners >= 3) {
+                info.triangleCount += corners - 2;
+                info.polygonCount += corners > 3;
+            }
+
+        }
+
+    }
+
+    return true;
+
+}
+
+// Index streams - the triangle and edge indices of the built-in catalog are stored delta-encoded: each index as its difference from the index before it, zigzagged so that small differences either way are small numbers (0, -1, 1, -2 ... become 0, 1, 2, 3 ...), written 7 bits to a byte with the top bit set on every byte but the last. The vertices of a mesh ordered for the vertex cache are numbered in the order the triangles use them, so most indices take one byte instead of four
+
+// This void method appends the delta encoding of indices to stream
+inline void encodeIndices (const std::vector<int> &indices, std::vector<unsigned char> &stream) {
+
+    int last = 0;
+
+    for (int index : indices) {
+
+        int delta = index - last;
+        uint32_t value = delta < 0 ? ((uint32_t) -(delta + 1) << 1) | 1 : (uint32_t) delta << 1;
+
+        while (value >= 0x80) {
+            stream.push_back((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+
+        stream.push_back(value);
+        last = index;
+
+    }
+
+}
+
+// This void method decodes count indices from the start of a delta-encoded stream into indices
+inline void decodeIndices (const unsigned char *stream, int count, std::vector<int> &indices) {
+
+    indices.resize(count);
+
+    int last = 0;
+
+    for (int i=0; i<count; i++) {
+
+        uint32_t value = 0;
+        int shift = 0;
+
+        while (*stream & 0x80) {
+            value |= (uint32_t) (*stream++ & 0x7F) << shift;
+            shift += 7;
+        }
+
+        value |= (uint32_t) *stream++ << shift;
+
+        last += value & 1 ? -(int) (value >> 1) - 1 : (int) (value >> 1);
+        indices[i] = last;
+
+    }
+
+}
+
+#endif
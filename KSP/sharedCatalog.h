@@ -0,0 +1,278 @@
+/*
+
+    The shared catalog segment layout, and a small reader for it.
+
+    The game publishes a processed component catalog into a POSIX shared memory segment when started with --publish-catalog <name>: the physics values of every component, its meshes (welded, triangulated and ordered for the vertex cache, as loadObject returns them), and its silhouette, mass properties and convex hull. Other processes attach to the segment read-only with --shared-catalog <name>, so however many of them run, the catalog is parsed and processed once and held in memory once.
+
+    Everything in the segment is found by its offset from the start of the segment, never by address, so it reads the same wherever a process maps it. The header is written last: a segment whose magic and version do not match is still being written (or was written by another version of the game) and is not used.
+
+*/
+
+#ifndef KSP_SHARED_CATALOG_H
+#define KSP_SHARED_CATALOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// This struct is an array in the segment: where it starts (in bytes from the start of the segment) and how many elements it has
+struct SharedArray
+{
+    uint64_t offset;
+    uint64_t count;
+};
+
+// This struct is one object of a component's mesh: its vertices (three doubles each, x, y and z), and its triangle and edge indices (int32_t)
+struct SharedObject
+{
+    SharedArray vertices;
+    SharedArray triangles;
+    SharedArray edges;
+};
+
+// This struct is one component of the shared catalog
+struct SharedComponent
+{
+    // The file name of the model (chars, not terminated)
+    SharedArray name;
+
+    double mass;
+    double thrust;
+    double lift;
+    double drag;
+
+    // The bounds of the model
+    double maxX, minX;
+    double maxY, minY;
+    double maxZ, minZ;
+
+    // The counts of the model file, as scanned for the catalog (triangles after triangulation, and the faces of more than three corners)
+    int32_t vertexCount;
+    int32_t triangleCount;
+    int32_t polygonCount;
+    int32_t reserved;
+
+    // The objects of the mesh (SharedObject)
+    SharedArray objects;
+
+    // The silhouette: its grid, its covered and drag areas, and its cell heights and drag coefficients (floats, row by row)
+    double silhouetteMinX;
+    double silhouetteMinZ;
+    double cellSize;
+    int32_t columns;
+    int32_t rows;
+    double frontalArea;
+    double dragArea;
+    SharedArray top;
+    SharedArray coefficient;
+
+    // The mass properties of the mesh filled with a density of 1: its volume, centre of mass and inertia tensor (xx, yy, zz, xy, yz, zx)
+    double volume;
+    double centre[3];
+    double inertia[6];
+
+    // The convex hull: its corners (three doubles each), its faces (three int32_t corner indices each) and its bounds
+    SharedArray hullVertices;
+    SharedArray hullFaces;
+    double hullMaxX, hullMinX;
+    double hullMaxY, hullMinY;
+    double hullMaxZ, hullMinZ;
+};
+
+// This struct is the header at the start of every shared catalog segment
+struct SharedCatalogHeader
+{
+    char magic[4];
+    uint32_t version;
+
+    // The size of the whole segment in bytes
+    uint64_t size;
+
+    // The components (SharedComponent)
+    SharedArray components;
+};
+
+static_assert(sizeof(SharedCatalogHeader) == 32, "the shared catalog header must stay 32 bytes");
+
+// The magic and layout version of shared catalog segments
+const char sharedCatalogMagic[4] = {'K', 'S', 'P', 'C'};
+const uint32_t sharedCatalogVersion = 1;
+
+// This struct is a shared catalog segment mapped into this process (base is nullptr if none is attached)
+struct SharedCatalog
+{
+    const char *base;
+    size_t size;
+};
+
+// This method returns the elements of an array in a shared catalog
+template <typename T>
+inline const T *getSharedArray (const SharedCatalog &catalog, const SharedArray &array) {
+
+    return (const T*) (catalog.base + array.offset);
+
+}
+
+// This method returns the header of a shared catalog
+inline const SharedCatalogHeader &getSharedHeader (const SharedCatalog &catalog) {
+
+    return *(const SharedCatalogHeader*) catalog.base;
+
+}
+
+// This method returns component index of a shared catalog
+inline const SharedComponent &getSharedComponent (const SharedCatalog &catalog, int index) {
+
+    return getSharedArray<SharedComponent>(catalog, getSharedHeader(catalog).components)[index];
+
+}
+
+// This method returns true if an array of elements of elementSize bytes lies inside a segment of size bytes (and is aligned for them)
+inline bool isSharedArrayValid (const SharedArray &array, size_t elementSize, size_t size) {
+
+    return array.offset % 8 == 0 && array.offset <= size && array.count <= (size - array.offset) / elementSize;
+
+}
+
+// This method returns true if each of the first count indices (int32_t) an array starts with is the index of one of vertexCount vertices
+inline bool areSharedIndicesValid (const SharedCatalog &catalog, const SharedArray &array, uint64_t count, uint64_t vertexCount) {
+
+    const int32_t *indices = getSharedArray<int32_t>(catalog, array);
+
+    for (uint64_t i=0; i<count; i++) {
+        if (indices[i] < 0 || (uint64_t) indices[i] >= vertexCount) {
+            return false;
+        }
+    }
+
+    return true;
+
+}
+
+// This method returns true if every triangle, edge and hull face index of component index is that of a vertex of its own mesh or hull. This reads every index of the component, so it is left until the component is first read (see isSharedCatalogValid)
+inline bool areSharedComponentIndicesValid (const SharedCatalog &catalog, int index) {
+
+    const SharedComponent &component = getSharedComponent(catalog, index);
+    const SharedObject *objects = getSharedArray<SharedObject>(catalog, component.objects);
+
+    for (uint64_t o=0; o<component.objects.count; o++) {
+        if (!areSharedIndicesValid(catalog, objects[o].triangles, objects[o].triangles.count, objects[o].vertices.count) || !areSharedIndicesValid(catalog, objects[o].edges, objects[o].edges.count, objects[o].vertices.count)) {
+            return false;
+        }
+    }
+
+    return areSharedIndicesValid(catalog, component.hullFaces, component.hullFaces.count * 3, component.hullVertices.count);
+
+}
+
+// This method returns true if every array of a mapped segment lies inside it, so that a damaged segment cannot make a reader go past its end. Only the header, the components and the object lists are read, so attaching does not touch the bulk of the segment; the indices are checked per component by areSharedComponentIndicesValid when it is first read
+inline bool isSharedCatalogValid (const SharedCatalog &catalog) {
+
+    const SharedCatalogHeader &header = getSharedHeader(catalog);
+
+    if (!isSharedArrayValid(header.components, sizeof(SharedComponent), catalog.size)) {
+        return false;
+    }
+
+    for (uint64_t i=0; i<header.components.count; i++) {
+
+        const SharedComponent &component = getSharedComponent(catalog, i);
+
+        if (!isSharedArrayValid(component.name, 1, catalog.size) || !isSharedArrayValid(component.objects, sizeof(SharedObject), catalog.size)) {
+            return false;
+        }
+
+        if (component.columns < 0 || component.rows < 0 || component.top.count != (uint64_t) component.columns * component.rows || component.coefficient.count != component.top.count) {
+            return false;
+        }
+
+        if (!isSharedArrayValid(component.top, sizeof(float), catalog.size) || !isSharedArrayValid(component.coefficient, sizeof(float), catalog.size)) {
+            return false;
+        }
+
+        if (!isSharedArrayValid(component.hullVertices, 3 * sizeof(double), catalog.size) || !isSharedArrayValid(component.hullFaces, 3 * sizeof(int32_t), catalog.size)) {
+            return false;
+        }
+
+        const SharedObject *objects = getSharedArray<SharedObject>(catalog, component.objects);
+
+        for (uint64_t o=0; o<component.objects.count; o++) {
+            if (!isSharedArrayValid(objects[o].vertices, 3 * sizeof(double), catalog.size) || !isSharedArrayValid(objects[o].triangles, sizeof(int32_t), catalog.size) || !isSharedArrayValid(objects[o].edges, sizeof(int32_t), catalog.size)) {
+                return false;
+            }
+
+            // Whole triangles and edges only
+            if (objects[o].triangles.count % 3 != 0 || objects[o].edges.count % 2 != 0) {
+                return false;
+            }
+        }
+
+    }
+
+    return true;
+
+}
+
+// This method maps the shared catalog segment called name read-only. Returns false if there is no such segment, or it is not a complete shared catalog of this version
+inline bool attachSharedCatalog (const std::string &name, SharedCatalog &catalog) {
+
+    catalog.base = nullptr;
+    catalog.size = 0;
+
+#ifdef _WIN32
+    (void) name;
+    return false;
+#else
+    int file = shm_open(name.c_str(), O_RDONLY, 0);
+
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat status;
+
+    if (fstat(file, &status) != 0 || (size_t) status.st_size < sizeof(SharedCatalogHeader)) {
+        close(file);
+        return false;
+    }
+
+    void *view = mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, file, 0);
+
+    // The mapping stays valid once the descriptor is closed
+    close(file);
+
+    if (view == MAP_FAILED) {
+        return false;
+    }
+
+    catalog.base = (const char*) view;
+    catalog.size = status.st_size;
+
+    const SharedCatalogHeader &header = getSharedHeader(catalog);
+
+    bool valid = header.version == sharedCatalogVersion && header.size == catalog.size;
+
+    for (int i=0; i<4; i++) {
+        valid = valid && header.magic[i] == sharedCatalogMagic[i];
+    }
+
+    if (!valid || !isSharedCatalogValid(catalog)) {
+        munmap(view, status.st_size);
+        catalog.base = nullptr;
+        catalog.size = 0;
+        return false;
+    }
+
+    return true;
+#endif
+
+}
+
+#endif
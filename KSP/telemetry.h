@@ -0,0 +1,117 @@
+/*
+
+    The flight telemetry file format, and a small reader for it.
+
+    The game writes the file when started with --telemetry <file>: a header followed by one fixed-size sample per simulation tick of every launch. The file is written through a memory mapping while the game runs, so it can be read back at any time; only the first sampleCount samples after the header are complete.
+
+*/
+
+#ifndef KSP_TELEMETRY_H
+#define KSP_TELEMETRY_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// This struct is one telemetry sample: the state of the launched rocket after one simulation tick
+struct TelemetrySample
+{
+    // The launch the sample belongs to (counted from 1), and the tick of that launch (0 is the state at blastoff)
+    int32_t launch;
+    int32_t tick;
+
+    // The simulation time since blastoff
+    double time;
+
+    // Altitude, vertical velocity, vertical acceleration and remaining lift
+    double pos;
+    double vel;
+    double accel;
+    double lift;
+
+    // How far the rocket has gone around the planet (radians from the launch site), and its horizontal velocity and acceleration
+    double angle;
+    double hvel;
+    double haccel;
+};
+
+static_assert(sizeof(TelemetrySample) == 72, "telemetry samples must stay 72 bytes");
+
+// This struct is the header at the start of every telemetry file
+struct TelemetryHeader
+{
+    char magic[4];
+    uint32_t version;
+
+    // The size of one sample in bytes (lets a reader skip fields added by newer versions)
+    uint32_t sampleSize;
+    uint32_t reserved;
+
+    // The number of complete samples after the header
+    uint64_t sampleCount;
+};
+
+static_assert(sizeof(TelemetryHeader) == 24, "the telemetry header must stay 24 bytes");
+
+// The magic and format version of telemetry files
+const char telemetryMagic[4] = {'K', 'S', 'P', 'T'};
+const uint32_t telemetryVersion = 2;
+
+// This method reads every sample of a telemetry file into samples. Returns false if the file cannot be read or is not a telemetry file
+inline bool loadTelemetry (const std::string &filename, std::vector<TelemetrySample> &samples) {
+
+    samples.clear();
+
+    std::ifstream fParser(filename.c_str(), std::ios::binary);
+
+    TelemetryHeader header;
+
+    if (!fParser.read((char*) &header, sizeof(header))) {
+        return false;
+    }
+
+    for (int i=0; i<4; i++) {
+        if (header.magic[i] != telemetryMagic[i]) {
+            return false;
+        }
+    }
+
+    if (header.version != telemetryVersion || header.sampleSize < sizeof(TelemetrySample)) {
+        return false;
+    }
+
+    // Read the samples in one go, then pick the known fields out of each record
+    std::vector<char> records(header.sampleCount * header.sampleSize);
+
+    fParser.read(records.data(), records.size());
+
+    size_t count = fParser.gcount() / header.sampleSize;
+
+    samples.resize(count);
+
+    for (size_t i=0; i<count; i++) {
+        std::memcpy(&samples[i], &records[i * header.sampleSize], sizeof(TelemetrySample));
+    }
+
+    return true;
+
+}
+
+// This method returns the samples of one launch, in tick order
+inline std::vector<TelemetrySample> getLaunchTelemetry (const std::vector<TelemetrySample> &samples, int launch) {
+
+    std::vector<TelemetrySample> launchSamples;
+
+    for (const TelemetrySample &sample : samples) {
+        if (sample.launch == launch) {
+            launchSamples.push_back(sample);
+        }
+    }
+
+    return launchSamples;
+
+}
+
+#endif